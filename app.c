@@ -13,13 +13,17 @@ This can easily be ported to other Operating System environments, also into embe
 */
 
 #include "common.h"
+#include <time.h>
 #include "gen_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
 #include "util_if.h"
 #include "slp_if.h"
+#include "slp_lib_if.h"
 #include "msg.h"
 
 #define APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS (8*GEN_MEM_SIZE)
-#define APP_DELAY_US                            10000
+#define APP_COMPLETION_BATCH_SIZE               64
 
 pthread_mutex_t gAppLock;
 
@@ -29,136 +33,100 @@ typedef struct AppNonCompletedData_t {
 }  AppNonCompletedData_t;
 
 typedef struct AppState_t {
-    uint64_t                    appId[APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS];
-    uint64_t                    slpId[APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS];
-    AppNonCompletedData_t       nonCompletedData[APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS];
-    int                         nrOfNonCompletedDataBlocks;
+    InflightTable_t             nonCompletedData; //AppNonCompletedData_t by appId, appId is appTag of data block
+    uint64_t                    appIdBase; //appIds of a run start from its start time, older ones come from SLP journal
     uint64_t                    appIdCount;
     uint64_t                    waitAppId;
     int                         waitState;
-    int                         nrOfRandBreaks;
-    uint64_t                    randBreakTime;
 } AppState_t;
 
 static AppState_t sAppState;
 
 static int sAppDebugPrint;
 
-static uint64_t AppSave(SlpAppMsg_t* pSbuf)
+static uint64_t AppSave(const SlpAppData_t* pData)
 {
+    AppNonCompletedData_t* pSaved;
     void* pAppData;
     uint64_t appId = sAppState.appIdCount;
-    int pos = sAppState.nrOfNonCompletedDataBlocks;
 
     sAppState.appIdCount++;
-    pAppData = malloc(pSbuf->data.len);
+    pAppData = malloc(pData->len);
     assert(NULL != pAppData);
-    memcpy(pAppData, pSbuf->data.appData, pSbuf->data.len);
-    assert(APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS > sAppState.nrOfNonCompletedDataBlocks);
-    sAppState.nonCompletedData[pos].pAppDataPtr = pAppData;
-    sAppState.nonCompletedData[pos].appLen = pSbuf->data.len;
-    sAppState.appId[pos] = appId;
-    sAppState.slpId[pos] = GEN_ID_INVALID;
-    sAppState.nrOfNonCompletedDataBlocks++;
+    memcpy(pAppData, pData->appData, pData->len);
+    pSaved = inflightTableAdd(&sAppState.nonCompletedData, appId);
+    assert(NULL != pSaved);
+    pSaved->pAppDataPtr = pAppData;
+    pSaved->appLen = pData->len;
     if (sAppDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("AppSave: appId %lu and len %u saved into pos %d\n",
-            appId, pSbuf->data.len, pos);
+        printf("AppSave: appId %lu and len %u saved, nr of non-completed data blocks %u\n",
+            appId, pData->len, sAppState.nonCompletedData.nr);
         pthread_mutex_unlock(&gGenPrintLock);
     }
     return appId;
 }
 
-static void AppFree(int pos)
+static void AppFree(uint64_t appId)
 {
-    int i;
+    AppNonCompletedData_t saved;
 
     if (sAppDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("AppFree: freeing pos %d having appId %lu and slpId %lu\n",
-            pos, sAppState.appId[pos], sAppState.slpId[pos]);
+        printf("AppFree: freeing appId %lu\n", appId);
         pthread_mutex_unlock(&gGenPrintLock);
     }
 
     //Free dynamically allocated APP memory
-    free(sAppState.nonCompletedData[pos].pAppDataPtr);
-
-    //Deleting element
-    for (i = pos; i < sAppState.nrOfNonCompletedDataBlocks; i++) {
-        if (pos < (sAppState.nrOfNonCompletedDataBlocks - 1)) {
-            sAppState.appId[i] = sAppState.appId[i + 1];
-            sAppState.slpId[i] = sAppState.slpId[i + 1];
-            sAppState.nonCompletedData[i] = sAppState.nonCompletedData[i + 1];
-        } else {
-            sAppState.appId[pos] =  0;
-            sAppState.slpId[pos] =  0;
-            sAppState.nonCompletedData[pos].pAppDataPtr = NULL;
-            sAppState.nonCompletedData[pos].appLen = 0;
-        }
+    if (inflightTableRemove(&sAppState.nonCompletedData, appId, &saved)) {
+        free(saved.pAppDataPtr);
     }
-
-    //Decrement nr of sent data blocks
-    sAppState.nrOfNonCompletedDataBlocks--;
 }
 
 void* app_tx_send_data()
 {
-    int msqid;
-    int msgflg = IPC_CREAT | MSG_FLAG;
-    key_t key;
-    SlpAppMsg_t sbuf;
+    static SlpAppData_t sbuf;
     uint8_t appCount = 0;
-    int i;
+    uint32_t i;
 
     //send APP data continuously
     for (;;) {
-        usleep(APP_DELAY_US);
-
-        //get the message queue id for the key with value APP_DATA_MSG_QUEUE_KEY_ID
-        key = SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID;
-
-        if ((msqid = msgget(key, msgflg)) < 0) {
-            perror("msgget");
-            exit(1);
-        }
-
-        //send message type APP_DATA_MSG
-        sbuf.mtype = SLP_APP_DATA_SEND_MSG;
+        usleep(gGenTestSettings.appDelayUs);
 
         //set APP data
-        sbuf.data.len = SLP_APP_DATA_SIZE - appCount;
-        for(i = 0; i < sbuf.data.len; i++) {
-            sbuf.data.appData[i] = i + appCount;
+        sbuf.len = SLP_APP_DATA_SIZE - appCount;
+        for(i = 0; i < sbuf.len; i++) {
+            sbuf.appData[i] = i + appCount;
         }
-        sbuf.data.appData[sbuf.data.len - 1] = appCount++;
+        sbuf.appData[sbuf.len - 1] = appCount++;
         pthread_mutex_lock(&gAppLock);
-        sbuf.data.genId = AppSave(&sbuf);
+        sbuf.genId = AppSave(&sbuf);
         pthread_mutex_unlock(&gAppLock);
 
         if (gGenDebugPrint) {
             pthread_mutex_lock(&gGenPrintLock);
-            printf("app_tx_send_data: sending %u bytes with last byte %u\n", sbuf.data.len, sbuf.data.appData[sbuf.data.len - 1]);
+            printf("app_tx_send_data: sending %u bytes with last byte %u\n", sbuf.len, sbuf.appData[sbuf.len - 1]);
             pthread_mutex_unlock(&gGenPrintLock);
         }
 
-        if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) { //last parameter IPC_NOWAIT replaced with 0
-            perror("msgsnd");
+        GEN_TRACE_EVENT(GEN_TRACE_APP_DATA_SENT, 0, sbuf.len, sbuf.genId);
+        if (slp_send(sbuf.appData, sbuf.len, sbuf.genId, NULL) < 0) {
+            fprintf(stderr, "app_tx_send_data: slp_send failed\n");
             exit(1);
         }
 
         while (sAppState.waitState) {
-            usleep(APP_DELAY_US);
+            usleep(gGenTestSettings.appDelayUs);
         }
 
-#ifdef GEN_APP_TEST_KEEP_RANDOM_BREAKS
-        {
+        if (gGenTestSettings.randomBreaks) {
             long r = rand();
-            if ((r % 100) == (sbuf.data.genId % 100)) {
+            if ((uint64_t) (r % 100) == (sbuf.genId % 100)) {
                 uint8_t appBreak = r % 10;
 
                 if (0 < appBreak) {
-                    sAppState.nrOfRandBreaks++;
-                    sAppState.randBreakTime += appBreak;
+                    GEN_STAT_INC(GEN_STAT_APP_RAND_BREAKS);
+                    GEN_STAT_ADD(GEN_STAT_APP_RAND_BREAK_SECONDS, appBreak);
                     pthread_mutex_lock(&gGenPrintLock);
                     printf("app_tx_send_data: random break of %u s started\n", appBreak);
                     pthread_mutex_unlock(&gGenPrintLock);
@@ -166,174 +134,160 @@ void* app_tx_send_data()
                 }
             }
         }
-#endif
     }
 }
 
-void* app_tx_receive_info()
+//SLP-tx info, appId given as appTag comes back with it
+static void AppInfoReceived(void* pUser, const SlpInfoData_t* pInfo)
 {
-    int msqid;
-    key_t key;
-    SlpInfoMsg_t rbuf;
-    int retVal;
-    int pos;
+    (void) pUser;
 
-    //get the message queue id
-    key = SLP_APP_INFO_MSG_QUEUE_KEY_ID;
-
-    //receive continuously
-    for (;;) {
-        usleep(GEN_SMALL_THREAD_DELAY_US);
-        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
-            usleep(GEN_SMALL_THREAD_DELAY_US);
-        }
-        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_INFO_MSG, 0);
-        if (0 > retVal) {
-            perror("msgrcv");
-            exit(1);
+    //print received info
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        if (SLP_INFO_TYPE_DONE == pInfo->infoType) {
+            printf("AppInfoReceived: infoType: DONE, slpId %lu, appId %lu, waiting %u, nr of non-completed data blocks %u\n",
+                pInfo->slpId, pInfo->appTag, sAppState.waitState, sAppState.nonCompletedData.nr);
+        } else if (SLP_INFO_TYPE_DONE_AND_RX_RESET == pInfo->infoType) {
+            printf("AppInfoReceived: infoType: DONE_AND_RX_RESET, slpId %lu, appId %lu, waiting %u, nr of non-completed data blocks %u\n",
+                pInfo->slpId, pInfo->appTag, sAppState.waitState, sAppState.nonCompletedData.nr);
+        } else if (SLP_INFO_TYPE_RX_RESET == pInfo->infoType) {
+            printf("AppInfoReceived: infoType: RX_RESET, slpId %lu, waiting %u, nr of non-completed data blocks %u\n",
+                pInfo->slpId, sAppState.waitState, sAppState.nonCompletedData.nr);
+        } else {
+            printf("AppInfoReceived: unknown infoType %u, slpId %lu, waiting %u, nr of non-completed data blocks %u\n",
+                pInfo->infoType, pInfo->slpId, sAppState.waitState, sAppState.nonCompletedData.nr);
         }
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+}
 
-        //find saved appId for saving corresponding slpId
-        if (SLP_INFO_TYPE_APP_DATA_RECEIVED == rbuf.data.infoType) {
-            pthread_mutex_lock(&gAppLock);
-            pos = binarySearch(sAppState.appId, 0, sAppState.nrOfNonCompletedDataBlocks - 1, rbuf.data.appId);
-            if (0 > pos)
-            {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("app_tx_receive_info: appId %lu not found!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!, nr of non-completed data blocks %d, oldest appId %lu\n",
-                    rbuf.data.appId, sAppState.nrOfNonCompletedDataBlocks, sAppState.appId[0]);
-                pthread_mutex_unlock(&gGenPrintLock);
-                pthread_mutex_unlock(&gAppLock);
-                continue;
-            }
-            sAppState.slpId[pos] = rbuf.data.slpId;
-            pthread_mutex_unlock(&gAppLock);
-            if (sAppDebugPrint) {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("app_tx_receive_info: received appId %lu found from pos %d where saved received slpId %lu, len %u\n",
-                    rbuf.data.appId, pos, rbuf.data.slpId, sAppState.nonCompletedData[pos].appLen);
-                pthread_mutex_unlock(&gGenPrintLock);
-            }
-        }
+//SLP-tx asks APP to wait or go on
+static void AppStateReceived(void* pUser, uint8_t state)
+{
+    (void) pUser;
 
-        //print received msg
-        if (gGenDebugPrint) {
-            pthread_mutex_lock(&gGenPrintLock);
-            if (SLP_INFO_TYPE_APP_DATA_RECEIVED == rbuf.data.infoType) {
-                printf("app_tx_receive_info: infoType: APP_DATA_RECEIVED, slpId %lu, waiting %u, nr of non-completed data blocks %d\n",
-                    rbuf.data.slpId, sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            } else if (SLP_INFO_TYPE_DONE == rbuf.data.infoType) {
-                printf("app_tx_receive_info: infoType: DONE, slpId %lu, waiting %u, nr of non-completed data blocks %d\n",
-                    rbuf.data.slpId, sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            } else if (SLP_INFO_TYPE_DONE_AND_RX_RESET == rbuf.data.infoType) {
-                printf("app_tx_receive_info: infoType: DONE_AND_RX_RESET, slpId %lu, waiting %u, nr of non-completed data blocks %d\n",
-                    rbuf.data.slpId, sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            } else if (SLP_INFO_TYPE_RX_RESET == rbuf.data.infoType) {
-                printf("app_tx_receive_info: infoType: RX_RESET, slpId %lu, waiting %u, nr of non-completed data blocks %d\n",
-                    rbuf.data.slpId, sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            } else {
-                printf("app_tx_receive_info: unknown infoType %u, slpId %lu, waiting %u, nr of non-completed data blocks %d\n",
-                    rbuf.data.infoType, rbuf.data.slpId, sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            }
-            pthread_mutex_unlock(&gGenPrintLock);
-        }
+    //set APP state
+    sAppState.waitState = state;
+
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("AppStateReceived: received state %u, nr of non-completed data blocks %u\n",
+            sAppState.waitState, sAppState.nonCompletedData.nr);
+        pthread_mutex_unlock(&gGenPrintLock);
     }
 }
 
-void* app_tx_receive_state()
+//deliveries are received by slp_recv, completions by slp_reap_completions, other infos and states come by callbacks
+void AppInit(void)
 {
-    int msqid;
-    key_t key;
-    SlpStateMsg_t rbuf;
-    int retVal;
+    static const SlpCallbacks_t callbacks = {
+        .pRecv = NULL,
+        .pInfo = AppInfoReceived,
+        .pState = AppStateReceived,
+        .pUser = NULL,
+        .completionQueue = 1
+    };
+
+    if (pthread_mutex_init(&gAppLock, NULL) != 0)
+    {
+        printf("\n App mutex init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    inflightTableInit(&sAppState.nonCompletedData, APP_MAX_NR_OF_NON_COMPLETED_DATA_BLOCKS, sizeof(AppNonCompletedData_t));
+    sAppState.appIdBase = (uint64_t) time(NULL) << 32;
+    sAppState.appIdCount = sAppState.appIdBase;
+    sAppState.waitAppId = sAppState.appIdBase;
+    if (slp_open(&callbacks) < 0) {
+        fprintf(stderr, "AppInit: slp_open failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
 
-    //get the message queue id for the key with value APP_STATE_FROM_SLP_MSG_QUEUE_KEY_ID
-    key = SLP_APP_STATE_MSG_QUEUE_KEY_ID;
+//DONE completions come in slpId order, receiver resets may interleave them
+void* app_tx_reap_completions()
+{
+    SlpCompletion_t completions[APP_COMPLETION_BATCH_SIZE];
+    uint64_t nextDoneSlpId = 0;
+    int nr;
+    int i;
 
-    //receive continuously message type APP_STATE_FROM_SLP_MSG
     for (;;) {
-        usleep(GEN_THREAD_DELAY_US);
-        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
-            usleep(GEN_THREAD_DELAY_US);
-        }
-        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_STATE_MSG, 0);
-        if (0 > retVal) {
-            perror("msgrcv");
+        nr = slp_reap_completions(completions, APP_COMPLETION_BATCH_SIZE, 1);
+        if (0 > nr) {
+            fprintf(stderr, "app_tx_reap_completions: slp_reap_completions failed\n");
             exit(1);
         }
-
-        //set APP state
-        sAppState.waitState = rbuf.data.state;
-
-        if (gGenDebugPrint) {
-            pthread_mutex_lock(&gGenPrintLock);
-            printf("app_tx_receive_state: received state %u, nr of non-completed data blocks %d\n",
-                sAppState.waitState, sAppState.nrOfNonCompletedDataBlocks);
-            pthread_mutex_unlock(&gGenPrintLock);
+        for (i = 0; i < nr; i++) {
+            if (SLP_INFO_TYPE_RX_RESET != completions[i].infoType) {
+                assert(nextDoneSlpId <= completions[i].firstSlpId);
+                nextDoneSlpId = completions[i].firstSlpId + completions[i].nr;
+            }
+            if (gGenDebugPrint) {
+                pthread_mutex_lock(&gGenPrintLock);
+                printf("app_tx_reap_completions: infoType %u, slpIds %lu..%lu, appIds from %lu, %d/%d of batch\n",
+                    completions[i].infoType, completions[i].firstSlpId, completions[i].firstSlpId + completions[i].nr - 1,
+                    completions[i].firstAppTag, i + 1, nr);
+                pthread_mutex_unlock(&gGenPrintLock);
+            }
         }
     }
 }
 
 void* app_rx_receive_data()
 {
-    int msqid;
-    key_t key;
-    SlpAppMsg_t rbuf;
+    static SlpAppData_t rbuf;
+    const AppNonCompletedData_t* pSaved;
     int retVal;
-    int pos;
     uint64_t appId;
+    uint64_t nowNs;
 
-    //get the message queue id for the key with value APP_RECEIVE_DATA_FROM_SLP_MSG_QUEUE_KEY_ID
-    key = SLP_APP_DATA_RECEIVE_MSG_QUEUE_KEY_ID;
-
-    //receive continuously message type APP_RECEIVE_DATA_FROM_SLP_MSG
+    //receive continuously
     for (;;) {
-        usleep(GEN_THREAD_DELAY_US);
-        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
-            usleep(GEN_THREAD_DELAY_US);
-        }
-        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_DATA_RECEIVE_MSG, 0);
+        retVal = slp_recv(rbuf.appData, sizeof(rbuf.appData), &rbuf.genId, &appId, &rbuf.timeNs);
         if (0 > retVal) {
-            perror("msgrcv");
+            fprintf(stderr, "app_rx_receive_data: slp_recv failed\n");
             exit(1);
         }
+        rbuf.len = retVal;
 
-        //find saved slpId for comparing received data block to slpId corresponding sent data block
+        //data blocks of previous run are resent from SLP journal, they aren't saved anymore
+        if (appId < sAppState.appIdBase) {
+            pthread_mutex_lock(&gGenPrintLock);
+            printf("app_rx_receive_data: appId %lu of slpId %lu is from previous run\n", appId, rbuf.genId);
+            pthread_mutex_unlock(&gGenPrintLock);
+            continue;
+        }
+
+        //appId came back as appTag, saved data block is found by it
         pthread_mutex_lock(&gAppLock);
-        pos = binarySearch(sAppState.slpId, 0, sAppState.nrOfNonCompletedDataBlocks - 1, rbuf.data.genId);
-        if (0 > pos) {
+        pSaved = inflightTableFind(&sAppState.nonCompletedData, appId);
+        if (NULL == pSaved) {
             pthread_mutex_lock(&gGenPrintLock);
-            printf("app_rx_receive_data: slpId %lu not found!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n",
-                rbuf.data.genId);
+            printf("app_rx_receive_data: appId %lu of slpId %lu not found!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n",
+                appId, rbuf.genId);
             pthread_mutex_unlock(&gGenPrintLock);
             pthread_mutex_unlock(&gAppLock);
             continue;
         }
 
         //failed assert if differences found
-        assert(sAppState.nonCompletedData[pos].appLen == rbuf.data.len);
-        assert(0 == memcmp(sAppState.nonCompletedData[pos].pAppDataPtr, rbuf.data.appData, rbuf.data.len));
+        assert(pSaved->appLen == rbuf.len);
+        assert(0 == memcmp(pSaved->pAppDataPtr, rbuf.appData, rbuf.len));
 
         //ensure proper order
-        appId = sAppState.appId[pos];
+        GEN_TRACE_EVENT(GEN_TRACE_APP_DATA_RECEIVED, rbuf.genId, rbuf.len, appId);
         assert(appId == sAppState.waitAppId);
         sAppState.waitAppId++;
 
         //saved APP data is not needed anymore
-        AppFree(pos);
+        AppFree(appId);
 
-#ifdef GEN_APP_DEBUG_STATISTICS
-        pthread_mutex_lock(&gGenPrintLock);
-        printf(
-            "APP result statistics:\n"
-            " nr of data blocks sent and successfully received %lu\n"
-            " nr of APP random breaks %d\n"
-            " random break total time %lu s\n"
-            "==========================================================\n",
-            appId + 1,
-            sAppState.nrOfRandBreaks, sAppState.randBreakTime);
-        pthread_mutex_unlock(&gGenPrintLock);
-#endif
+        nowNs = GenStatNowNs();
+        GenStatLatency(GEN_STAT_LATENCY_ACCEPT_TO_DELIVERY, rbuf.timeNs, nowNs);
+        GenStatLatency(GEN_STAT_LATENCY_SUBMIT_TO_DELIVERY, GenStatGetStamp(rbuf.genId, GEN_STAT_STAMP_SUBMIT), nowNs);
+
+        GEN_STAT_INC(GEN_STAT_APP_DELIVERED_DATA_BLOCKS);
         pthread_mutex_unlock(&gAppLock);
     }
 }
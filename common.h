@@ -14,6 +14,7 @@ This can easily be ported to other Operating System environments, also into embe
 
 
 #include <stdint.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
@@ -23,3 +24,8 @@ This can easily be ported to other Operating System environments, also into embe
 #include <sys/msg.h>
 #include <string.h>
 #include <unistd.h>
+
+//simulation build maps threads, sleeps and message queues to virtual time
+#ifdef GEN_SIM
+#include "gen_sim_if.h"
+#endif
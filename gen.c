@@ -15,11 +15,23 @@ This can be ported easily to other Operating System environments, also into embe
 */
 #include "common.h"
 #include "msg.h"
-#include "gen.h"
+#include "gen_if.h"
+#include "util_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
+#include "gen_link_if.h"
+#include "gen_timer_if.h"
+#include "slp_if.h"
+#include "slp.h"
 
 int gGenDebugPrint;
 pthread_mutex_t gGenPrintLock;
 
+GenTestSettings_t gGenTestSettings = {
+    1,      //randomBreaks
+    10000   //appDelayUs
+};
+
 static int GenIsThisMsgQueueEmpty(key_t key)
 {
     struct msqid_ds qbuf;
@@ -54,3 +66,79 @@ int GenCertainSyncRelatedMsgQueuesEmpty(void)
     }
     return 1;
 }
+
+//initialisations before any APP or SLP thread is started
+void GenInit(void)
+{
+    if (gGenTraceSettings.enabled) {
+        GenTraceInit();
+    }
+    GenTimerInit();
+    crcInit();
+    crc32cInit();
+    SlpRxInit();
+    GenLinkInit();
+
+    if (pthread_mutex_init(&gGenPrintLock, NULL) != 0)
+    {
+        printf("\n print mutex init failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_mutex_init(&gSlpTxLock, NULL) != 0)
+    {
+        printf("\n slp tx mutex init failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (pthread_mutex_init(&gSlpRxLock, NULL) != 0)
+    {
+        printf("\n slp rx mutex init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    SlpTxInit();
+}
+
+static void GenCreateDetachedThread(void* (*pFunc)(), size_t threadNr)
+{
+    pthread_t thread;
+    int retVal;
+
+    retVal = pthread_create(&thread, NULL, pFunc, NULL);
+    if(retVal)
+    {
+        fprintf(stderr,"Error - pthread_create(&thread_slp%zu, ..) returned value: %d\n", threadNr, retVal);
+        exit(EXIT_FAILURE);
+    }
+    pthread_detach(thread);
+}
+
+//starts SLP-tx, SLP-rx, link emulator, timer and statistics threads, they run until the process exits
+//sysvApp: APP sends data blocks to SysV queue, otherwise it calls slp_send: slp_lib_if.h
+void GenStartSlpThreads(int sysvApp)
+{
+    static void* (*const threads[])() = {
+        slp_tx_receive_ack,
+        slp_tx_receive_nack,
+        slp_rx_receive_app_data,
+        slp_rx_send_ack,
+        slp_rx_receive_retrans,
+        slp_rx_receive_poll,
+        slp_rx_receive_fec,
+        gen_link_deliver,
+        gen_timer_run,
+        gen_stat_export
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+        GenCreateDetachedThread(threads[i], i + 1);
+    }
+    if (sysvApp) {
+        GenCreateDetachedThread(slp_tx_receive_app_data, i + 1);
+        GenCreateDetachedThread(slp_tx_receive_urgent_app_data, i + 2);
+    }
+    if (gSlpJournalSettings.enabled && (SLP_JOURNAL_DURABILITY_GROUP == gSlpJournalSettings.durability)) {
+        GenCreateDetachedThread(slp_journal_commit, i + 3);
+    }
+}
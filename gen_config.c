@@ -0,0 +1,363 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include "common.h"
+#include "gen_if.h"
+#include "gen_config_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
+#include "gen_link_if.h"
+#include "msg.h"
+#include "slp_if.h"
+#include "slp.h"
+
+enum {
+    GEN_CONFIG_INT = 0,
+    GEN_CONFIG_U32,
+    GEN_CONFIG_U64,
+    GEN_CONFIG_STR //NULL value is printed and set as "-"
+};
+
+typedef struct GenConfigEntry_t {
+    const char* pKey;
+    int         type;
+    void*       pValue;
+    const char* pHelp;
+} GenConfigEntry_t;
+
+static const GenConfigEntry_t sGenConfigEntries[] = {
+    {"integrity_alg",           GEN_CONFIG_U32, &gSlpLinkSettings.integrityAlg,         "0 legacy crc, 1 crc32c, 2 none"},
+    {"compression",             GEN_CONFIG_INT, &gSlpLinkSettings.compression,          "compress sent data blocks"},
+    {"fec_group_size",          GEN_CONFIG_U32, &gSlpLinkSettings.fecGroupSize,         "data blocks per parity block, 0 no FEC"},
+    {"app_wait_limit",          GEN_CONFIG_U32, &gSlpLinkSettings.appWaitLimit,         "saved data blocks when APP is asked to wait"},
+    {"app_restart_limit",       GEN_CONFIG_U32, &gSlpLinkSettings.appRestartLimit,      "saved data blocks when APP is asked to go on"},
+    {"secondary_app_wait",      GEN_CONFIG_INT, &gSlpLinkSettings.secondaryAppWait,     "APP waits also while receiver is reset"},
+    {"nack_check_delay_us",     GEN_CONFIG_U32, &gSlpLinkSettings.nackCheckDelayUs,     "reorder tolerance unit before NACK"},
+    {"nack_check_limit",        GEN_CONFIG_U32, &gSlpLinkSettings.nackCheckLimit,       "reorder tolerance in units"},
+    {"nack_retrans_limit",      GEN_CONFIG_U32, &gSlpLinkSettings.nackRetransLimit,     "NACKs of same seqNum before receiver reset"},
+    {"fast_retrans_threshold",  GEN_CONFIG_U32, &gSlpLinkSettings.fastRetransThreshold, "selective acks of a gap before resending it, 0 off"},
+    {"probe_min_timeout_us",    GEN_CONFIG_U32, &gSlpLinkSettings.probeMinTimeoutUs,    "lower bound of tail loss probe timeout"},
+    {"journal.enabled",         GEN_CONFIG_INT, &gSlpJournalSettings.enabled,           "journal unacknowledged data blocks to file"},
+    {"journal.file",            GEN_CONFIG_STR, &gSlpJournalSettings.pFileName,         "journal file, recovered at start"},
+    {"journal.size_mb",         GEN_CONFIG_U32, &gSlpJournalSettings.sizeMb,            "journal file size"},
+    {"journal.durability",      GEN_CONFIG_U32, &gSlpJournalSettings.durability,        "0 page cache, 1 group commit, 2 flush per submit"},
+    {"journal.group_commit_us", GEN_CONFIG_U32, &gSlpJournalSettings.groupCommitUs,     "group commit period"},
+    {"stat.counters",           GEN_CONFIG_INT, &gGenStatSettings.counters,             "update statistics counters"},
+    {"stat.export_format",      GEN_CONFIG_INT, &gGenStatSettings.exportFormat,         "0 prometheus, 1 json"},
+    {"stat.export_interval_ms", GEN_CONFIG_U32, &gGenStatSettings.exportIntervalMs,     "0 no export"},
+    {"stat.export_file",        GEN_CONFIG_STR, &gGenStatSettings.pExportFileName,      "- stdout"},
+    {"trace.enabled",           GEN_CONFIG_INT, &gGenTraceSettings.enabled,             "record binary trace"},
+    {"trace.file",              GEN_CONFIG_STR, &gGenTraceSettings.pFileName,           "trace file"},
+    {"test.random_breaks",      GEN_CONFIG_INT, &gGenTestSettings.randomBreaks,         "APP sender keeps random breaks"},
+    {"test.app_delay_us",       GEN_CONFIG_U32, &gGenTestSettings.appDelayUs,           "APP polling period while waiting"},
+    {"debug.print",             GEN_CONFIG_INT, &gGenDebugPrint,                        "print every message"},
+};
+
+#define GEN_CONFIG_NR_OF_ENTRIES        (sizeof(sGenConfigEntries) / sizeof(sGenConfigEntries[0]))
+
+//fields of each link, key is link.<GenLinkName>.<field>
+typedef struct GenConfigLinkField_t {
+    const char* pName;
+    int         type;
+    size_t      offset;
+} GenConfigLinkField_t;
+
+static const GenConfigLinkField_t sGenConfigLinkFields[] = {
+    {"delay_us",        GEN_CONFIG_U32, offsetof(GenLinkSettings_t, delayUs)},
+    {"jitter_us",       GEN_CONFIG_U32, offsetof(GenLinkSettings_t, jitterUs)},
+    {"bandwidth_kbps",  GEN_CONFIG_U32, offsetof(GenLinkSettings_t, bandwidthKbps)},
+    {"loss_ppm",        GEN_CONFIG_U32, offsetof(GenLinkSettings_t, lossPpm)},
+    {"good_to_bad_ppm", GEN_CONFIG_U32, offsetof(GenLinkSettings_t, goodToBadPpm)},
+    {"bad_to_good_ppm", GEN_CONFIG_U32, offsetof(GenLinkSettings_t, badToGoodPpm)},
+    {"bad_loss_ppm",    GEN_CONFIG_U32, offsetof(GenLinkSettings_t, badLossPpm)},
+    {"reorder_ppm",     GEN_CONFIG_U32, offsetof(GenLinkSettings_t, reorderPpm)},
+    {"duplicate_ppm",   GEN_CONFIG_U32, offsetof(GenLinkSettings_t, duplicatePpm)},
+    {"corrupt_ppm",     GEN_CONFIG_U32, offsetof(GenLinkSettings_t, corruptPpm)},
+    {"seed",            GEN_CONFIG_U64, offsetof(GenLinkSettings_t, seed)},
+};
+
+#define GEN_CONFIG_NR_OF_LINK_FIELDS    (sizeof(sGenConfigLinkFields) / sizeof(sGenConfigLinkFields[0]))
+#define GEN_CONFIG_NR_OF_KEYS           (GEN_CONFIG_NR_OF_ENTRIES + GEN_LINK_NR_OF_LINKS * GEN_CONFIG_NR_OF_LINK_FIELDS)
+
+//fills key, type and value pointer of keyNr, keys are numbered from 0 to GEN_CONFIG_NR_OF_KEYS - 1
+static void GenConfigKey(size_t keyNr, char* pKey, int* pType, void** ppValue, const char** ppHelp)
+{
+    const GenConfigLinkField_t* pField;
+    size_t linkId;
+
+    assert(GEN_CONFIG_NR_OF_KEYS > keyNr);
+    if (GEN_CONFIG_NR_OF_ENTRIES > keyNr) {
+        snprintf(pKey, GEN_CONFIG_MAX_KEY_SIZE, "%s", sGenConfigEntries[keyNr].pKey);
+        *pType = sGenConfigEntries[keyNr].type;
+        *ppValue = sGenConfigEntries[keyNr].pValue;
+        *ppHelp = sGenConfigEntries[keyNr].pHelp;
+        return;
+    }
+    keyNr -= GEN_CONFIG_NR_OF_ENTRIES;
+    linkId = keyNr / GEN_CONFIG_NR_OF_LINK_FIELDS;
+    pField = &sGenConfigLinkFields[keyNr % GEN_CONFIG_NR_OF_LINK_FIELDS];
+    snprintf(pKey, GEN_CONFIG_MAX_KEY_SIZE, "link.%s.%s", GenLinkName(linkId), pField->pName);
+    *pType = pField->type;
+    *ppValue = (uint8_t*) &gGenLinkSettings[linkId] + pField->offset;
+    *ppHelp = "link emulator, see gen_link_if.h";
+}
+
+//returns 0 if value doesn't fit to type
+static int GenConfigParse(int type, void* pValue, const char* pStr)
+{
+    char* pEnd;
+    long long n;
+    unsigned long long u;
+
+    errno = 0;
+    switch (type) {
+    case GEN_CONFIG_INT:
+        n = strtoll(pStr, &pEnd, 0);
+        if (errno || (pEnd == pStr) || *pEnd || (INT32_MIN > n) || (INT32_MAX < n)) return 0;
+        *(int*) pValue = n;
+        return 1;
+    case GEN_CONFIG_U32:
+    case GEN_CONFIG_U64:
+        if ('-' == *pStr) return 0;
+        u = strtoull(pStr, &pEnd, 0);
+        if (errno || (pEnd == pStr) || *pEnd) return 0;
+        if (GEN_CONFIG_U32 == type) {
+            if (UINT32_MAX < u) return 0;
+            *(uint32_t*) pValue = u;
+        } else {
+            *(uint64_t*) pValue = u;
+        }
+        return 1;
+    case GEN_CONFIG_STR:
+        if (0 == strcmp(pStr, "-")) {
+            *(const char**) pValue = NULL;
+        } else {
+            //settings keep the pointer, never freed
+            *(const char**) pValue = strdup(pStr);
+            if (NULL == *(const char**) pValue) {
+                perror("strdup");
+                exit(1);
+            }
+        }
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+//returns 0 if key is unknown or value is invalid
+int GenConfigSet(const char* pKey, const char* pValue)
+{
+    char key[GEN_CONFIG_MAX_KEY_SIZE];
+    const char* pHelp;
+    void* pSetting;
+    int type;
+    size_t i;
+
+    for (i = 0; i < GEN_CONFIG_NR_OF_KEYS; i++) {
+        GenConfigKey(i, key, &type, &pSetting, &pHelp);
+        if (0 == strcmp(key, pKey)) {
+            return GenConfigParse(type, pSetting, pValue);
+        }
+    }
+    return 0;
+}
+
+void GenConfigPrint(FILE* pFile)
+{
+    char key[GEN_CONFIG_MAX_KEY_SIZE];
+    const char* pHelp;
+    void* pSetting;
+    int type;
+    size_t i;
+
+    for (i = 0; i < GEN_CONFIG_NR_OF_KEYS; i++) {
+        GenConfigKey(i, key, &type, &pSetting, &pHelp);
+        fprintf(pFile, "%s = ", key);
+        switch (type) {
+        case GEN_CONFIG_INT:
+            fprintf(pFile, "%d", *(int*) pSetting);
+            break;
+        case GEN_CONFIG_U32:
+            fprintf(pFile, "%u", *(uint32_t*) pSetting);
+            break;
+        case GEN_CONFIG_U64:
+            fprintf(pFile, "%lu", *(uint64_t*) pSetting);
+            break;
+        default:
+            fprintf(pFile, "%s", (NULL != *(const char**) pSetting) ? *(const char**) pSetting : "-");
+            break;
+        }
+        fprintf(pFile, " # %s\n", pHelp);
+    }
+}
+
+static char* GenConfigTrim(char* pStr)
+{
+    char* pEnd;
+
+    while (isspace((unsigned char) *pStr)) pStr++;
+    pEnd = pStr + strlen(pStr);
+    while ((pEnd > pStr) && isspace((unsigned char) pEnd[-1])) pEnd--;
+    *pEnd = '\0';
+    return pStr;
+}
+
+static void GenConfigLoadFile(const char* pFileName)
+{
+    char line[GEN_CONFIG_MAX_LINE_SIZE];
+    char* pKey;
+    char* pValue;
+    FILE* pFile;
+    int lineNr = 0;
+
+    pFile = fopen(pFileName, "r");
+    if (NULL == pFile) {
+        perror(pFileName);
+        exit(1);
+    }
+    while (NULL != fgets(line, sizeof(line), pFile)) {
+        lineNr++;
+        pValue = strchr(line, '#');
+        if (NULL != pValue) *pValue = '\0';
+        pKey = GenConfigTrim(line);
+        if ('\0' == *pKey) continue;
+
+        pValue = strchr(pKey, '=');
+        if (NULL == pValue) {
+            fprintf(stderr, "%s:%d: missing '='\n", pFileName, lineNr);
+            exit(1);
+        }
+        *pValue++ = '\0';
+        pKey = GenConfigTrim(pKey);
+        pValue = GenConfigTrim(pValue);
+        if (!GenConfigSet(pKey, pValue)) {
+            fprintf(stderr, "%s:%d: invalid setting %s = %s\n", pFileName, lineNr, pKey, pValue);
+            exit(1);
+        }
+    }
+    fclose(pFile);
+}
+
+static void GenConfigLoadEnv(void)
+{
+    char key[GEN_CONFIG_MAX_KEY_SIZE];
+    char name[sizeof(GEN_CONFIG_ENV_PREFIX) + GEN_CONFIG_MAX_KEY_SIZE];
+    const char* pHelp;
+    const char* pValue;
+    void* pSetting;
+    int type;
+    size_t i;
+    char* p;
+
+    for (i = 0; i < GEN_CONFIG_NR_OF_KEYS; i++) {
+        GenConfigKey(i, key, &type, &pSetting, &pHelp);
+        snprintf(name, sizeof(name), GEN_CONFIG_ENV_PREFIX "%s", key);
+        for (p = name; *p; p++) {
+            *p = ('.' == *p) ? '_' : toupper((unsigned char) *p);
+        }
+        pValue = getenv(name);
+        if ((NULL != pValue) && !GenConfigParse(type, pSetting, pValue)) {
+            fprintf(stderr, "invalid environment setting %s=%s\n", name, pValue);
+            exit(1);
+        }
+    }
+}
+
+//settings which other ones or fixed table sizes limit
+static void GenConfigCheck(void)
+{
+    const char* pError = NULL;
+
+    if (SLP_INTEGRITY_ALG_NONE < gSlpLinkSettings.integrityAlg) {
+        pError = "integrity_alg is unknown";
+    } else if (SLP_FEC_MAX_GROUP_SIZE < gSlpLinkSettings.fecGroupSize) {
+        pError = "fec_group_size is over 64";
+    } else if (SLP_MAX_NR_OF_BLOCKS < gSlpLinkSettings.appWaitLimit) {
+        pError = "app_wait_limit is over SLP window size";
+    } else if (gSlpLinkSettings.appRestartLimit >= gSlpLinkSettings.appWaitLimit) {
+        pError = "app_restart_limit isn't below app_wait_limit";
+    } else if ((0 == gSlpLinkSettings.probeMinTimeoutUs) || (0 == gSlpLinkSettings.nackCheckDelayUs)) {
+        pError = "probe_min_timeout_us and nack_check_delay_us must be positive";
+    } else if (gSlpJournalSettings.enabled && (NULL == gSlpJournalSettings.pFileName)) {
+        pError = "journal.file is missing";
+    } else if (gSlpJournalSettings.enabled && (0 == gSlpJournalSettings.sizeMb)) {
+        pError = "journal.size_mb must be positive";
+    } else if (SLP_JOURNAL_DURABILITY_SUBMIT < gSlpJournalSettings.durability) {
+        pError = "journal.durability is unknown";
+    } else if ((SLP_JOURNAL_DURABILITY_GROUP == gSlpJournalSettings.durability) && (0 == gSlpJournalSettings.groupCommitUs)) {
+        pError = "journal.group_commit_us must be positive";
+    } else if (GEN_STAT_FORMAT_JSON < (uint32_t) gGenStatSettings.exportFormat) {
+        pError = "stat.export_format is unknown";
+    } else if (gGenTraceSettings.enabled && (NULL == gGenTraceSettings.pFileName)) {
+        pError = "trace.file is missing";
+    }
+    if (NULL != pError) {
+        fprintf(stderr, "config: %s\n", pError);
+        exit(1);
+    }
+}
+
+//must be called before GenInit, exits on any invalid source
+void GenConfigLoad(int argc, char* argv[])
+{
+    const char* pFileName = getenv(GEN_CONFIG_FILE_ENV);
+    int i;
+
+    //file is read first whatever its position in command line
+    for (i = 1; i < argc; i++) {
+        if ((0 == strcmp(argv[i], "-c")) && (i + 1 < argc)) {
+            pFileName = argv[++i];
+        } else if (0 == strncmp(argv[i], "--config=", strlen("--config="))) {
+            pFileName = argv[i] + strlen("--config=");
+        }
+    }
+    if (NULL != pFileName) {
+        GenConfigLoadFile(pFileName);
+    }
+    GenConfigLoadEnv();
+
+    for (i = 1; i < argc; i++) {
+        char key[GEN_CONFIG_MAX_KEY_SIZE];
+        const char* pValue;
+        size_t len;
+
+        if (0 == strcmp(argv[i], "-c")) {
+            i++;
+            continue;
+        }
+        if (0 == strncmp(argv[i], "--config=", strlen("--config="))) continue;
+        if (0 == strcmp(argv[i], "--help")) {
+            printf("usage: %s [-c file] [--key=value ...]\n", argv[0]);
+            GenConfigPrint(stdout);
+            exit(0);
+        }
+        pValue = (0 == strncmp(argv[i], "--", 2)) ? strchr(argv[i], '=') : NULL;
+        len = (NULL != pValue) ? (size_t) (pValue - argv[i] - 2) : 0;
+        if ((0 == len) || (GEN_CONFIG_MAX_KEY_SIZE <= len)) {
+            fprintf(stderr, "invalid argument %s, try --help\n", argv[i]);
+            exit(1);
+        }
+        memcpy(key, argv[i] + 2, len);
+        key[len] = '\0';
+        if (!GenConfigSet(key, pValue + 1)) {
+            fprintf(stderr, "invalid setting %s, try --help\n", argv[i]);
+            exit(1);
+        }
+    }
+    GenConfigCheck();
+}
@@ -0,0 +1,32 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Runtime configuration: every tunable of gSlpLinkSettings, gSlpJournalSettings, gGenStatSettings,
+ * gGenTraceSettings, gGenTestSettings and gGenLinkSettings has a key, e.g. fec_group_size, stat.counters or
+ * link.data.loss_ppm. GenConfigLoad overrides compile-time defaults before GenInit, later
+ * source wins:
+ * - config file given by -c <path>, --config=<path> or SLP_CONFIG, lines "key = value", # comments
+ * - environment SLP_<KEY>, key in upper case and dots as underscores, e.g. SLP_LINK_DATA_LOSS_PPM
+ * - command line --key=value
+ * --help lists all keys with their values and exits.
+ */
+#define GEN_CONFIG_ENV_PREFIX           "SLP_"
+#define GEN_CONFIG_FILE_ENV             "SLP_CONFIG"
+#define GEN_CONFIG_MAX_KEY_SIZE         64
+#define GEN_CONFIG_MAX_LINE_SIZE        256
+
+void GenConfigLoad(int argc, char* argv[]);
+int GenConfigSet(const char* pKey, const char* pValue);
+void GenConfigPrint(FILE* pFile);
@@ -27,14 +27,15 @@ extern pthread_mutex_t gSlpTxLock;
 extern pthread_mutex_t gSlpRxLock;
 
 int GenCertainSyncRelatedMsgQueuesEmpty(void);
-
-//conditional test features
-#define GEN_APP_TEST_KEEP_RANDOM_BREAKS
-#define GEN_SLP_TEST_LOST_APP_DATA
-#define GEN_SLP_TEST_LOST_ACKS
-#define GEN_SLP_TEST_RAND_LOST
-
-//conditional debug statistics
-#define GEN_APP_DEBUG_STATISTICS
-#define GEN_SLP_TX_DEBUG_STATISTICS
-#define GEN_SLP_RX_DEBUG_STATISTICS
+void GenInit(void);
+void GenStartSlpThreads(int sysvApp);
+
+//runtime switches of test features, e.g. benchmark turns all of them off
+//delays and losses of SLP messages are in link emulator settings: gen_link_if.h
+//all settings are tunable at startup: gen_config_if.h
+typedef struct GenTestSettings_t {
+    int         randomBreaks; //APP sender keeps random breaks of 1-9 s
+    uint32_t    appDelayUs; //APP polling period while asked to wait
+} GenTestSettings_t;
+
+extern GenTestSettings_t gGenTestSettings;
@@ -0,0 +1,319 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include <time.h>
+#include "common.h"
+#include "gen_if.h"
+#include "gen_link_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
+
+//links are transparent by default, so libslp embedders get no emulated delay or loss,
+//test APP of main.c and tools set their own before GenConfigLoad
+GenLinkSettings_t gGenLinkSettings[GEN_LINK_NR_OF_LINKS] = {
+    [GEN_LINK_DATA]     = {.seed = 1},
+    [GEN_LINK_RETRANS]  = {.seed = 2},
+    [GEN_LINK_POLL]     = {.seed = 3},
+    [GEN_LINK_FEC]      = {.seed = 4},
+    [GEN_LINK_ACK]      = {.seed = 5},
+    [GEN_LINK_NACK]     = {.seed = 6},
+};
+
+static const char* const sGenLinkNames[GEN_LINK_NR_OF_LINKS] = {
+    [GEN_LINK_DATA]     = "data",
+    [GEN_LINK_RETRANS]  = "retrans",
+    [GEN_LINK_POLL]     = "poll",
+    [GEN_LINK_FEC]      = "fec",
+    [GEN_LINK_ACK]      = "ack",
+    [GEN_LINK_NACK]     = "nack",
+};
+
+typedef struct GenLinkState_t {
+    pthread_mutex_t lock;
+    uint64_t        rand; //xorshift64* state, never 0
+    uint64_t        freeNs; //end of previous message transmission when bandwidth is capped
+    int             bad; //Gilbert-Elliott state
+} GenLinkState_t;
+
+//message waiting for its due time, copy of sent message including mtype follows the header
+typedef struct GenLinkMsg_t {
+    uint64_t    dueNs;
+    uint64_t    order; //messages having same due time are delivered in send order
+    int         msqid;
+    size_t      msgSize;
+    mtype_t     msg[];
+} GenLinkMsg_t;
+
+static GenLinkState_t sGenLinkState[GEN_LINK_NR_OF_LINKS];
+
+//min-heap by due time
+static pthread_mutex_t sGenLinkHeapLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sGenLinkHeapCond;
+static GenLinkMsg_t** sGenLinkHeap;
+static int sGenLinkHeapSize;
+static int sGenLinkHeapCapacity;
+static uint64_t sGenLinkOrder;
+
+void GenLinkInit(void)
+{
+    pthread_condattr_t attr;
+    int i;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&sGenLinkHeapCond, &attr) != 0) {
+        printf("\n link cond init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_condattr_destroy(&attr);
+
+    for (i = 0; i < GEN_LINK_NR_OF_LINKS; i++) {
+        if (pthread_mutex_init(&sGenLinkState[i].lock, NULL) != 0) {
+            printf("\n link mutex init failed\n");
+            exit(EXIT_FAILURE);
+        }
+        sGenLinkState[i].rand = gGenLinkSettings[i].seed ^ (0x9e3779b97f4a7c15ULL * (i + 1));
+        if (0 == sGenLinkState[i].rand) sGenLinkState[i].rand = 1;
+        sGenLinkState[i].freeNs = 0;
+        sGenLinkState[i].bad = 0;
+    }
+}
+
+const char* GenLinkName(int linkId)
+{
+    if ((0 > linkId) || (GEN_LINK_NR_OF_LINKS <= linkId)) return "unknown";
+    return sGenLinkNames[linkId];
+}
+
+uint32_t GenLinkMaxDelayUs(int linkId)
+{
+    return gGenLinkSettings[linkId].delayUs + gGenLinkSettings[linkId].jitterUs;
+}
+
+static uint64_t GenLinkRand(GenLinkState_t* pState)
+{
+    uint64_t x = pState->rand;
+
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    pState->rand = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+static int GenLinkChance(GenLinkState_t* pState, uint32_t ppm)
+{
+    if (0 == ppm) return 0;
+    return (GenLinkRand(pState) >> 11) % GEN_LINK_PPM < ppm;
+}
+
+static int GenLinkIsLost(const GenLinkSettings_t* pSettings, GenLinkState_t* pState)
+{
+    if (0 < pSettings->goodToBadPpm) {
+        if (pState->bad) {
+            pState->bad = !GenLinkChance(pState, pSettings->badToGoodPpm);
+        } else {
+            pState->bad = GenLinkChance(pState, pSettings->goodToBadPpm);
+        }
+        if (pState->bad) return GenLinkChance(pState, pSettings->badLossPpm);
+    }
+    return GenLinkChance(pState, pSettings->lossPpm);
+}
+
+static int GenLinkHeapLess(int a, int b)
+{
+    if (sGenLinkHeap[a]->dueNs != sGenLinkHeap[b]->dueNs) return sGenLinkHeap[a]->dueNs < sGenLinkHeap[b]->dueNs;
+    return sGenLinkHeap[a]->order < sGenLinkHeap[b]->order;
+}
+
+static void GenLinkHeapSwap(int a, int b)
+{
+    GenLinkMsg_t* pTmp = sGenLinkHeap[a];
+
+    sGenLinkHeap[a] = sGenLinkHeap[b];
+    sGenLinkHeap[b] = pTmp;
+}
+
+static void GenLinkHeapPush(GenLinkMsg_t* pMsg)
+{
+    int i;
+
+    pthread_mutex_lock(&sGenLinkHeapLock);
+    if (sGenLinkHeapSize == sGenLinkHeapCapacity) {
+        sGenLinkHeapCapacity = sGenLinkHeapCapacity ? 2 * sGenLinkHeapCapacity : 256;
+        sGenLinkHeap = realloc(sGenLinkHeap, sGenLinkHeapCapacity * sizeof(sGenLinkHeap[0]));
+        assert(NULL != sGenLinkHeap);
+    }
+    pMsg->order = sGenLinkOrder++;
+    i = sGenLinkHeapSize++;
+    sGenLinkHeap[i] = pMsg;
+    while ((0 < i) && GenLinkHeapLess(i, (i - 1) / 2)) {
+        GenLinkHeapSwap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    //deliver thread sleeps until previous first due time
+    if (0 == i) {
+        pthread_cond_signal(&sGenLinkHeapCond);
+    }
+    pthread_mutex_unlock(&sGenLinkHeapLock);
+}
+
+//caller holds sGenLinkHeapLock
+static GenLinkMsg_t* GenLinkHeapPop(void)
+{
+    GenLinkMsg_t* pMsg = sGenLinkHeap[0];
+    int i = 0;
+
+    sGenLinkHeap[0] = sGenLinkHeap[--sGenLinkHeapSize];
+    for (;;) {
+        int child = 2 * i + 1;
+
+        if (child >= sGenLinkHeapSize) break;
+        if ((child + 1 < sGenLinkHeapSize) && GenLinkHeapLess(child + 1, child)) child++;
+        if (!GenLinkHeapLess(child, i)) break;
+        GenLinkHeapSwap(i, child);
+        i = child;
+    }
+    return pMsg;
+}
+
+static GenLinkMsg_t* GenLinkCopy(int msqid, const void* pMsg, size_t msgSize, uint64_t dueNs)
+{
+    GenLinkMsg_t* pCopy = malloc(sizeof(GenLinkMsg_t) + sizeof(mtype_t) + msgSize);
+
+    assert(NULL != pCopy);
+    pCopy->dueNs = dueNs;
+    pCopy->msqid = msqid;
+    pCopy->msgSize = msgSize;
+    memcpy(pCopy->msg, pMsg, sizeof(mtype_t) + msgSize);
+    return pCopy;
+}
+
+//pMsg starts with mtype as for msgsnd, msgSize excludes it
+//returns msgsnd result when sent at once, otherwise 0: message was lost or is delivered later
+int GenLinkSend(int linkId, uint64_t seqNum, int msqid, const void* pMsg, size_t msgSize)
+{
+    const GenLinkSettings_t* pSettings = &gGenLinkSettings[linkId];
+    GenLinkState_t* pState = &sGenLinkState[linkId];
+    GenLinkMsg_t* pCopy = NULL;
+    uint64_t nowNs = GenStatNowNs();
+    uint64_t dueNs = nowNs;
+    uint32_t delayUs = pSettings->delayUs;
+    int lost;
+    int reordered;
+    int duplicated;
+    int corruptBit = -1;
+
+    pthread_mutex_lock(&pState->lock);
+    if (0 < pSettings->bandwidthKbps) {
+        if (pState->freeNs > dueNs) dueNs = pState->freeNs;
+        dueNs += (uint64_t) (sizeof(mtype_t) + msgSize) * 8 * 1000000 / pSettings->bandwidthKbps;
+        pState->freeNs = dueNs;
+    }
+    lost = GenLinkIsLost(pSettings, pState);
+    if (0 < pSettings->jitterUs) {
+        delayUs += GenLinkRand(pState) % (pSettings->jitterUs + 1);
+    }
+    reordered = (0 < delayUs) && GenLinkChance(pState, pSettings->reorderPpm);
+    duplicated = GenLinkChance(pState, pSettings->duplicatePpm);
+    if (GenLinkChance(pState, pSettings->corruptPpm)) {
+        size_t span = msgSize < GEN_LINK_CORRUPT_SPAN ? msgSize : GEN_LINK_CORRUPT_SPAN;
+
+        corruptBit = GenLinkRand(pState) % (span * 8);
+    }
+    pthread_mutex_unlock(&pState->lock);
+
+    GEN_STAT_INC(GEN_STAT_LINK_SENT_MSGS);
+    if (lost) {
+        GEN_TRACE_EVENT(GEN_TRACE_LINK_LOST, seqNum, linkId, msgSize);
+        GEN_STAT_INC(GEN_STAT_LINK_LOST_MSGS);
+        return 0;
+    }
+    if (reordered) {
+        GEN_TRACE_EVENT(GEN_TRACE_LINK_REORDERED, seqNum, linkId, delayUs);
+        GEN_STAT_INC(GEN_STAT_LINK_REORDERED_MSGS);
+    } else {
+        dueNs += (uint64_t) delayUs * 1000;
+    }
+
+    if (0 <= corruptBit) {
+        pCopy = GenLinkCopy(msqid, pMsg, msgSize, dueNs);
+        ((uint8_t*) (pCopy->msg + 1))[corruptBit / 8] ^= 1 << (corruptBit % 8);
+        GEN_TRACE_EVENT(GEN_TRACE_LINK_CORRUPTED, seqNum, linkId, corruptBit);
+        GEN_STAT_INC(GEN_STAT_LINK_CORRUPTED_MSGS);
+    }
+    if (duplicated) {
+        GEN_TRACE_EVENT(GEN_TRACE_LINK_DUPLICATED, seqNum, linkId, msgSize);
+        GEN_STAT_INC(GEN_STAT_LINK_DUPLICATED_MSGS);
+#ifdef GEN_SIM
+        GenSimMsgSndAt(msqid, pMsg, msgSize, dueNs);
+#else
+        GenLinkHeapPush(GenLinkCopy(msqid, pMsg, msgSize, dueNs));
+#endif
+    }
+
+#ifdef GEN_SIM
+    //simulated message queue keeps message invisible until due time
+    {
+        int retVal = GenSimMsgSndAt(msqid, pCopy ? pCopy->msg : pMsg, msgSize, dueNs);
+
+        free(pCopy);
+        return retVal;
+    }
+#endif
+
+    //ideal link: sending thread sends at once
+    if ((dueNs <= nowNs) && !duplicated) {
+        int retVal = msgsnd(msqid, pCopy ? pCopy->msg : pMsg, msgSize, 0);
+
+        free(pCopy);
+        return retVal;
+    }
+    GenLinkHeapPush(pCopy ? pCopy : GenLinkCopy(msqid, pMsg, msgSize, dueNs));
+    return 0;
+}
+
+//sends delayed messages to their message queues at due time
+void* gen_link_deliver()
+{
+    GenLinkMsg_t* pMsg;
+    struct timespec ts;
+
+#ifdef GEN_SIM
+    return NULL;
+#endif
+    pthread_mutex_lock(&sGenLinkHeapLock);
+    for (;;) {
+        if (0 == sGenLinkHeapSize) {
+            pthread_cond_wait(&sGenLinkHeapCond, &sGenLinkHeapLock);
+            continue;
+        }
+        if (sGenLinkHeap[0]->dueNs > GenStatNowNs()) {
+            ts.tv_sec = sGenLinkHeap[0]->dueNs / 1000000000ULL;
+            ts.tv_nsec = sGenLinkHeap[0]->dueNs % 1000000000ULL;
+            pthread_cond_timedwait(&sGenLinkHeapCond, &sGenLinkHeapLock, &ts);
+            continue;
+        }
+        pMsg = GenLinkHeapPop();
+        pthread_mutex_unlock(&sGenLinkHeapLock);
+
+        if (msgsnd(pMsg->msqid, pMsg->msg, pMsg->msgSize, 0) < 0) {
+            perror("msgsnd");
+            exit(1);
+        }
+        free(pMsg);
+        pthread_mutex_lock(&sGenLinkHeapLock);
+    }
+    return NULL;
+}
@@ -0,0 +1,55 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Link emulator between SLP-tx and SLP-rx: every message sent over a link gets delay, jitter,
+ * bandwidth cap, loss (Bernoulli or Gilbert-Elliott), reordering, duplication and corruption
+ * by gGenLinkSettings. Delayed messages wait in a due time ordered heap and gen_link_deliver
+ * thread sends them to their message queue, so receiving threads never sleep for the link.
+ * Each link has its own seeded PRNG, runs with the same settings and seeds repeat decisions.
+ */
+enum {
+    GEN_LINK_DATA = 0, //SLP-tx => SLP-rx
+    GEN_LINK_RETRANS,
+    GEN_LINK_POLL,
+    GEN_LINK_FEC,
+    GEN_LINK_ACK, //SLP-rx => SLP-tx
+    GEN_LINK_NACK,
+    GEN_LINK_NR_OF_LINKS
+};
+
+#define GEN_LINK_PPM                    1000000 //probabilities are parts per million
+#define GEN_LINK_CORRUPT_SPAN           64 //bytes from message start where a bit may flip, covers SLP header
+
+typedef struct GenLinkSettings_t {
+    uint32_t    delayUs;
+    uint32_t    jitterUs; //random 0..jitterUs added to delay
+    uint32_t    bandwidthKbps; //0: no cap, otherwise messages are serialised by their size
+    uint32_t    lossPpm; //Bernoulli loss, loss of good state when Gilbert-Elliott is on
+    uint32_t    goodToBadPpm; //Gilbert-Elliott state change per message, 0: Bernoulli loss only
+    uint32_t    badToGoodPpm;
+    uint32_t    badLossPpm;
+    uint32_t    reorderPpm; //message skips delay and overtakes earlier ones
+    uint32_t    duplicatePpm;
+    uint32_t    corruptPpm; //one bit flipped within GEN_LINK_CORRUPT_SPAN
+    uint64_t    seed;
+} GenLinkSettings_t;
+
+extern GenLinkSettings_t gGenLinkSettings[GEN_LINK_NR_OF_LINKS];
+
+void GenLinkInit(void);
+int GenLinkSend(int linkId, uint64_t seqNum, int msqid, const void* pMsg, size_t msgSize);
+uint32_t GenLinkMaxDelayUs(int linkId);
+const char* GenLinkName(int linkId);
+void* gen_link_deliver();
@@ -0,0 +1,435 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#ifdef GEN_SIM
+
+#define GEN_SIM_IMPL
+#include <errno.h>
+#include <ucontext.h>
+#include "common.h"
+#include "gen_if.h"
+
+enum {
+    GEN_SIM_RUNNABLE = 0,
+    GEN_SIM_SLEEPING,
+    GEN_SIM_WAITING_MSG,
+    GEN_SIM_WAITING_CHANNEL, //mutex or condition
+    GEN_SIM_WAITING_JOIN,
+    GEN_SIM_EXITED
+};
+
+typedef struct GenSimThread_t {
+    ucontext_t      context;
+    void*           pStack;
+    void*           (*pFunc)(void*);
+    void*           pArg;
+    void*           pRetVal;
+    int             state;
+    uint64_t        wakeNs; //GEN_SIM_SLEEPING, timeout of GEN_SIM_WAITING_CHANNEL or UINT64_MAX
+    int             msqid; //GEN_SIM_WAITING_MSG
+    long            msgtyp;
+    const void*     pChannel; //GEN_SIM_WAITING_CHANNEL
+    int             joinId; //GEN_SIM_WAITING_JOIN
+} GenSimThread_t;
+
+typedef struct GenSimMsg_t {
+    struct GenSimMsg_t* pNext;
+    uint64_t            dueNs;
+    size_t              msgSize;
+    mtype_t             msg[]; //mtype and msgSize bytes as given to msgsnd
+} GenSimMsg_t;
+
+//messages are in due time order, same due time in send order
+typedef struct GenSimQueue_t {
+    key_t           key;
+    int             inUse;
+    GenSimMsg_t*    pHead;
+    GenSimMsg_t*    pTail;
+} GenSimQueue_t;
+
+//thread 0 is the one calling main()
+static GenSimThread_t sGenSimThreads[GEN_SIM_MAX_NR_OF_THREADS];
+static int sGenSimNrOfThreads = 1;
+static int sGenSimCurrent;
+static int sGenSimNrOfChannelWaiters;
+static uint64_t sGenSimNowNs = GEN_SIM_START_NS;
+static GenSimQueue_t sGenSimQueues[GEN_SIM_MAX_NR_OF_QUEUES];
+
+uint64_t GenSimNowNs(void)
+{
+    return sGenSimNowNs;
+}
+
+//first visible message of type msgtyp, 0: any type
+static GenSimMsg_t* GenSimFindMsg(GenSimQueue_t* pQueue, long msgtyp, GenSimMsg_t** ppPrev)
+{
+    GenSimMsg_t* pPrev = NULL;
+    GenSimMsg_t* pMsg;
+
+    for (pMsg = pQueue->pHead; (NULL != pMsg) && (pMsg->dueNs <= sGenSimNowNs); pMsg = pMsg->pNext) {
+        if ((0 == msgtyp) || (msgtyp == pMsg->msg[0])) {
+            if (NULL != ppPrev) *ppPrev = pPrev;
+            return pMsg;
+        }
+        pPrev = pMsg;
+    }
+    return NULL;
+}
+
+static uint64_t GenSimNextDueNs(GenSimQueue_t* pQueue, long msgtyp)
+{
+    GenSimMsg_t* pMsg;
+
+    for (pMsg = pQueue->pHead; NULL != pMsg; pMsg = pMsg->pNext) {
+        if ((0 == msgtyp) || (msgtyp == pMsg->msg[0])) return pMsg->dueNs;
+    }
+    return UINT64_MAX;
+}
+
+static int GenSimIsRunnable(const GenSimThread_t* pThread)
+{
+    switch (pThread->state) {
+    case GEN_SIM_RUNNABLE:
+        return 1;
+    case GEN_SIM_SLEEPING:
+        return pThread->wakeNs <= sGenSimNowNs;
+    case GEN_SIM_WAITING_MSG:
+        return NULL != GenSimFindMsg(&sGenSimQueues[pThread->msqid], pThread->msgtyp, NULL);
+    case GEN_SIM_WAITING_JOIN:
+        return GEN_SIM_EXITED == sGenSimThreads[pThread->joinId].state;
+    case GEN_SIM_WAITING_CHANNEL:
+        return pThread->wakeNs <= sGenSimNowNs;
+    default:
+        return 0;
+    }
+}
+
+static uint64_t GenSimWakeNs(const GenSimThread_t* pThread)
+{
+    switch (pThread->state) {
+    case GEN_SIM_SLEEPING:
+    case GEN_SIM_WAITING_CHANNEL:
+        return pThread->wakeNs;
+    case GEN_SIM_WAITING_MSG:
+        return GenSimNextDueNs(&sGenSimQueues[pThread->msqid], pThread->msgtyp);
+    default:
+        return UINT64_MAX;
+    }
+}
+
+//gives turn to the next runnable thread in round robin order, returns when this one runs again
+static void GenSimSchedule(void)
+{
+    int self = sGenSimCurrent;
+    uint64_t nextNs;
+    int i;
+    int k;
+
+    for (;;) {
+        for (k = 1; k <= sGenSimNrOfThreads; k++) {
+            i = (self + k) % sGenSimNrOfThreads;
+            if (GenSimIsRunnable(&sGenSimThreads[i])) {
+                //timed out channel wait
+                if (GEN_SIM_WAITING_CHANNEL == sGenSimThreads[i].state) {
+                    sGenSimNrOfChannelWaiters--;
+                }
+                sGenSimThreads[i].state = GEN_SIM_RUNNABLE;
+                if (i != self) {
+                    sGenSimCurrent = i;
+                    swapcontext(&sGenSimThreads[self].context, &sGenSimThreads[i].context);
+                }
+                return;
+            }
+        }
+
+        //nothing to do at this time: advance virtual clock
+        nextNs = UINT64_MAX;
+        for (i = 0; i < sGenSimNrOfThreads; i++) {
+            uint64_t wakeNs = GenSimWakeNs(&sGenSimThreads[i]);
+
+            if (wakeNs < nextNs) nextNs = wakeNs;
+        }
+        if (UINT64_MAX == nextNs) {
+            fprintf(stderr, "gen_sim: all threads blocked at %lu ns\n", sGenSimNowNs);
+            exit(1);
+        }
+        sGenSimNowNs = nextNs;
+    }
+}
+
+static void GenSimThreadStart(int id)
+{
+    GenSimThread_t* pThread = &sGenSimThreads[id];
+
+    pThread->pRetVal = pThread->pFunc(pThread->pArg);
+    pThread->state = GEN_SIM_EXITED;
+    GenSimSchedule();
+}
+
+int GenSimSleepUs(uint64_t us)
+{
+    GenSimThread_t* pThread = &sGenSimThreads[sGenSimCurrent];
+
+    pThread->state = GEN_SIM_SLEEPING;
+    pThread->wakeNs = sGenSimNowNs + us * 1000;
+    GenSimSchedule();
+    return 0;
+}
+
+int GenSimThreadCreate(pthread_t* pThread, const pthread_attr_t* pAttr, void* (*pFunc)(void*), void* pArg)
+{
+    GenSimThread_t* pNew;
+    int id = sGenSimNrOfThreads;
+
+    (void) pAttr;
+    if (GEN_SIM_MAX_NR_OF_THREADS <= id) return EAGAIN;
+
+    pNew = &sGenSimThreads[id];
+    memset(pNew, 0, sizeof(*pNew));
+    pNew->pFunc = pFunc;
+    pNew->pArg = pArg;
+    pNew->pStack = malloc(GEN_SIM_STACK_SIZE);
+    assert(NULL != pNew->pStack);
+    getcontext(&pNew->context);
+    pNew->context.uc_stack.ss_sp = pNew->pStack;
+    pNew->context.uc_stack.ss_size = GEN_SIM_STACK_SIZE;
+    pNew->context.uc_link = NULL;
+    makecontext(&pNew->context, (void (*)(void)) GenSimThreadStart, 1, id);
+    pNew->state = GEN_SIM_RUNNABLE;
+    sGenSimNrOfThreads++;
+    *pThread = (pthread_t) id;
+    return 0;
+}
+
+int GenSimThreadJoin(pthread_t thread, void** ppRetVal)
+{
+    GenSimThread_t* pThread = &sGenSimThreads[sGenSimCurrent];
+
+    if ((pthread_t) sGenSimNrOfThreads <= thread) return ESRCH;
+    while (GEN_SIM_EXITED != sGenSimThreads[thread].state) {
+        pThread->state = GEN_SIM_WAITING_JOIN;
+        pThread->joinId = (int) thread;
+        GenSimSchedule();
+    }
+    if (NULL != ppRetVal) *ppRetVal = sGenSimThreads[thread].pRetVal;
+    return 0;
+}
+
+int GenSimThreadDetach(pthread_t thread)
+{
+    (void) thread;
+    return 0;
+}
+
+static void GenSimWaitChannel(const void* pChannel, uint64_t timeoutNs)
+{
+    GenSimThread_t* pThread = &sGenSimThreads[sGenSimCurrent];
+
+    pThread->state = GEN_SIM_WAITING_CHANNEL;
+    pThread->pChannel = pChannel;
+    pThread->wakeNs = timeoutNs;
+    sGenSimNrOfChannelWaiters++;
+    GenSimSchedule();
+}
+
+static void GenSimNotifyChannel(const void* pChannel, int all)
+{
+    int i;
+
+    for (i = 0; (i < sGenSimNrOfThreads) && (0 < sGenSimNrOfChannelWaiters); i++) {
+        if ((GEN_SIM_WAITING_CHANNEL == sGenSimThreads[i].state) && (pChannel == sGenSimThreads[i].pChannel)) {
+            sGenSimThreads[i].state = GEN_SIM_RUNNABLE;
+            sGenSimNrOfChannelWaiters--;
+            if (!all) return;
+        }
+    }
+}
+
+//a thread can sleep or receive while holding a mutex, others wait for it in turn
+int GenSimMutexLock(pthread_mutex_t* pMutex)
+{
+    while (0 != pthread_mutex_trylock(pMutex)) {
+        GenSimWaitChannel(pMutex, UINT64_MAX);
+    }
+    return 0;
+}
+
+int GenSimMutexUnlock(pthread_mutex_t* pMutex)
+{
+    int retVal = pthread_mutex_unlock(pMutex);
+
+    GenSimNotifyChannel(pMutex, 1);
+    return retVal;
+}
+
+int GenSimCondWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex)
+{
+    GenSimMutexUnlock(pMutex);
+    GenSimWaitChannel(pCond, UINT64_MAX);
+    return GenSimMutexLock(pMutex);
+}
+
+//absolute time is virtual as given by GenSimNowNs
+int GenSimCondTimedWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex, const struct timespec* pTime)
+{
+    uint64_t timeoutNs = (uint64_t) pTime->tv_sec * 1000000000ULL + pTime->tv_nsec;
+
+    GenSimMutexUnlock(pMutex);
+    GenSimWaitChannel(pCond, timeoutNs);
+    GenSimMutexLock(pMutex);
+    return (timeoutNs <= sGenSimNowNs) ? ETIMEDOUT : 0;
+}
+
+int GenSimCondSignal(pthread_cond_t* pCond)
+{
+    GenSimNotifyChannel(pCond, 0);
+    return 0;
+}
+
+int GenSimCondBroadcast(pthread_cond_t* pCond)
+{
+    GenSimNotifyChannel(pCond, 1);
+    return 0;
+}
+
+static GenSimQueue_t* GenSimGetQueue(int msqid)
+{
+    if ((0 > msqid) || (GEN_SIM_MAX_NR_OF_QUEUES <= msqid) || !sGenSimQueues[msqid].inUse) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return &sGenSimQueues[msqid];
+}
+
+int GenSimMsgGet(key_t key, int msgflg)
+{
+    int i;
+    int freeId = -1;
+
+    for (i = 0; i < GEN_SIM_MAX_NR_OF_QUEUES; i++) {
+        if (sGenSimQueues[i].inUse && (key == sGenSimQueues[i].key)) return i;
+        if (!sGenSimQueues[i].inUse && (0 > freeId)) freeId = i;
+    }
+    if (!(IPC_CREAT & msgflg)) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (0 > freeId) {
+        errno = ENOSPC;
+        return -1;
+    }
+    memset(&sGenSimQueues[freeId], 0, sizeof(sGenSimQueues[freeId]));
+    sGenSimQueues[freeId].key = key;
+    sGenSimQueues[freeId].inUse = 1;
+    return freeId;
+}
+
+int GenSimMsgSndAt(int msqid, const void* pMsg, size_t msgSize, uint64_t dueNs)
+{
+    GenSimQueue_t* pQueue = GenSimGetQueue(msqid);
+    GenSimMsg_t* pNew;
+    GenSimMsg_t** ppPos;
+
+    if (NULL == pQueue) return -1;
+    if (dueNs < sGenSimNowNs) dueNs = sGenSimNowNs;
+
+    pNew = malloc(sizeof(GenSimMsg_t) + sizeof(mtype_t) + msgSize);
+    assert(NULL != pNew);
+    pNew->pNext = NULL;
+    pNew->dueNs = dueNs;
+    pNew->msgSize = msgSize;
+    memcpy(pNew->msg, pMsg, sizeof(mtype_t) + msgSize);
+
+    //usually due time isn't before the last one
+    if ((NULL == pQueue->pTail) || (pQueue->pTail->dueNs <= dueNs)) {
+        ppPos = (NULL == pQueue->pTail) ? &pQueue->pHead : &pQueue->pTail->pNext;
+    } else {
+        for (ppPos = &pQueue->pHead; (*ppPos)->dueNs <= dueNs; ppPos = &(*ppPos)->pNext);
+    }
+    pNew->pNext = *ppPos;
+    *ppPos = pNew;
+    if (NULL == pNew->pNext) pQueue->pTail = pNew;
+    return 0;
+}
+
+int GenSimMsgSnd(int msqid, const void* pMsg, size_t msgSize, int msgflg)
+{
+    (void) msgflg;
+    return GenSimMsgSndAt(msqid, pMsg, msgSize, sGenSimNowNs);
+}
+
+ssize_t GenSimMsgRcv(int msqid, void* pMsg, size_t msgSize, long msgtyp, int msgflg)
+{
+    GenSimThread_t* pThread = &sGenSimThreads[sGenSimCurrent];
+    GenSimQueue_t* pQueue;
+    GenSimMsg_t* pPrev = NULL;
+    GenSimMsg_t* pFound;
+    size_t size;
+
+    for (;;) {
+        if (NULL == (pQueue = GenSimGetQueue(msqid))) return -1;
+        if (NULL != (pFound = GenSimFindMsg(pQueue, msgtyp, &pPrev))) break;
+        if (IPC_NOWAIT & msgflg) {
+            errno = ENOMSG;
+            return -1;
+        }
+        pThread->state = GEN_SIM_WAITING_MSG;
+        pThread->msqid = msqid;
+        pThread->msgtyp = msgtyp;
+        GenSimSchedule();
+    }
+
+    //unlink
+    if (NULL == pPrev) {
+        pQueue->pHead = pFound->pNext;
+    } else {
+        pPrev->pNext = pFound->pNext;
+    }
+    if (pQueue->pTail == pFound) pQueue->pTail = pPrev;
+
+    assert((pFound->msgSize <= msgSize) || (MSG_NOERROR & msgflg));
+    size = (pFound->msgSize < msgSize) ? pFound->msgSize : msgSize;
+    memcpy(pMsg, pFound->msg, sizeof(mtype_t) + size);
+    free(pFound);
+    return size;
+}
+
+int GenSimMsgCtl(int msqid, int cmd, struct msqid_ds* pBuf)
+{
+    GenSimQueue_t* pQueue = GenSimGetQueue(msqid);
+    GenSimMsg_t* pMsg;
+
+    if (NULL == pQueue) return -1;
+    switch (cmd) {
+    case IPC_STAT:
+        //only messages already delivered by the link are in the queue
+        memset(pBuf, 0, sizeof(*pBuf));
+        for (pMsg = pQueue->pHead; (NULL != pMsg) && (pMsg->dueNs <= sGenSimNowNs); pMsg = pMsg->pNext) {
+            pBuf->msg_qnum++;
+        }
+        return 0;
+    case IPC_RMID:
+        while (NULL != (pMsg = pQueue->pHead)) {
+            pQueue->pHead = pMsg->pNext;
+            free(pMsg);
+        }
+        pQueue->inUse = 0;
+        return 0;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+#endif
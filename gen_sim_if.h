@@ -0,0 +1,64 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Discrete-event simulation build, make sim compiles everything with -DGEN_SIM.
+ * Threads become coroutines of one OS thread and only one of them runs at a time. A thread
+ * gives turn to the next one only when it would block: sleep, message receive, mutex, condition
+ * or join. When no thread can run, virtual clock jumps to the next timer or message due time.
+ * SysV message queues are replaced by in-process queues whose messages become visible at due
+ * time, so link emulator delays need no delivery thread. Runs with same settings and seeds
+ * are identical and take only the CPU time of the protocol itself.
+ *
+ * Code keeps using POSIX names, macros below map them to gen_sim.c.
+ */
+#define GEN_SIM_MAX_NR_OF_THREADS       32
+#define GEN_SIM_MAX_NR_OF_QUEUES        16
+#define GEN_SIM_STACK_SIZE              (1024*1024)
+#define GEN_SIM_START_NS                1000000000ULL //0 is reserved for missing time stamps
+
+uint64_t GenSimNowNs(void);
+int GenSimSleepUs(uint64_t us);
+int GenSimThreadCreate(pthread_t* pThread, const pthread_attr_t* pAttr, void* (*pFunc)(void*), void* pArg);
+int GenSimThreadJoin(pthread_t thread, void** ppRetVal);
+int GenSimThreadDetach(pthread_t thread);
+int GenSimMutexLock(pthread_mutex_t* pMutex);
+int GenSimMutexUnlock(pthread_mutex_t* pMutex);
+int GenSimCondWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex);
+int GenSimCondTimedWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex, const struct timespec* pTime);
+int GenSimCondSignal(pthread_cond_t* pCond);
+int GenSimCondBroadcast(pthread_cond_t* pCond);
+int GenSimMsgGet(key_t key, int msgflg);
+int GenSimMsgSnd(int msqid, const void* pMsg, size_t msgSize, int msgflg);
+int GenSimMsgSndAt(int msqid, const void* pMsg, size_t msgSize, uint64_t dueNs);
+ssize_t GenSimMsgRcv(int msqid, void* pMsg, size_t msgSize, long msgtyp, int msgflg);
+int GenSimMsgCtl(int msqid, int cmd, struct msqid_ds* pBuf);
+
+#ifndef GEN_SIM_IMPL
+#define usleep(us)                      GenSimSleepUs(us)
+#define sleep(s)                        GenSimSleepUs((uint64_t) (s) * 1000000)
+#define pthread_create                  GenSimThreadCreate
+#define pthread_join                    GenSimThreadJoin
+#define pthread_detach                  GenSimThreadDetach
+#define pthread_mutex_lock              GenSimMutexLock
+#define pthread_mutex_unlock            GenSimMutexUnlock
+#define pthread_cond_wait               GenSimCondWait
+#define pthread_cond_timedwait          GenSimCondTimedWait
+#define pthread_cond_signal             GenSimCondSignal
+#define pthread_cond_broadcast          GenSimCondBroadcast
+#define msgget                          GenSimMsgGet
+#define msgsnd                          GenSimMsgSnd
+#define msgrcv                          GenSimMsgRcv
+#define msgctl                          GenSimMsgCtl
+#endif
@@ -0,0 +1,379 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include <time.h>
+#include "common.h"
+#include "gen_if.h"
+#include "gen_stat_if.h"
+
+#define GEN_STAT_EXPORT_FILE_NAME   "slp_stat.prom"
+
+GenStatSettings_t gGenStatSettings = {
+    1,
+    GEN_STAT_FORMAT_PROMETHEUS,
+    1000,
+    GEN_STAT_EXPORT_FILE_NAME
+};
+
+typedef struct GenStatCounterInfo_t {
+    const char* pName;
+    const char* pHelp;
+} GenStatCounterInfo_t;
+
+static const GenStatCounterInfo_t sGenStatCounterInfo[GEN_STAT_NR_OF_COUNTERS] = {
+    [GEN_STAT_APP_DELIVERED_DATA_BLOCKS]                    = {"app_delivered_data_blocks", "data blocks sent and successfully received by APP"},
+    [GEN_STAT_APP_RAND_BREAKS]                              = {"app_rand_breaks", "APP random breaks"},
+    [GEN_STAT_APP_RAND_BREAK_SECONDS]                       = {"app_rand_break_seconds", "APP random break total time"},
+    [GEN_STAT_SLP_TX_DATA_BLOCKS_RECEIVED_FROM_APP]         = {"slp_tx_data_blocks_received_from_app", "data blocks received from APP"},
+    [GEN_STAT_SLP_TX_URGENT_DATA_BLOCKS_RECEIVED_FROM_APP]  = {"slp_tx_urgent_data_blocks_received_from_app", "urgent data blocks received from APP"},
+    [GEN_STAT_SLP_TX_SENT_DATA_BLOCKS]                      = {"slp_tx_sent_data_blocks", "sent data blocks"},
+    [GEN_STAT_SLP_TX_RECEIVED_ACKS]                         = {"slp_tx_received_acks", "received acks"},
+    [GEN_STAT_SLP_TX_RECEIVED_NACKS]                        = {"slp_tx_received_nacks", "received nacks"},
+    [GEN_STAT_SLP_TX_RETRANSMITTED_DATA_BLOCKS]             = {"slp_tx_retransmitted_data_blocks", "retransmitted data blocks"},
+    [GEN_STAT_SLP_TX_RETRANSMITTED_POLLS]                   = {"slp_tx_retransmitted_polls", "retransmitted polls"},
+    [GEN_STAT_SLP_TX_SENT_PROBES]                           = {"slp_tx_sent_probes", "newest data blocks resent as tail loss probe"},
+    [GEN_STAT_SLP_TX_COMPRESSED_DATA_BLOCKS]                = {"slp_tx_compressed_data_blocks", "compressed data blocks"},
+    [GEN_STAT_SLP_TX_SENT_FEC_PARITY_BLOCKS]                = {"slp_tx_sent_fec_parity_blocks", "sent FEC parity blocks"},
+    [GEN_STAT_SLP_TX_FEC_RECOVERED_DATA_BLOCKS]             = {"slp_tx_fec_recovered_data_blocks", "FEC recovered data blocks according to acks"},
+    [GEN_STAT_SLP_TX_JOURNAL_RECOVERED_DATA_BLOCKS]         = {"slp_tx_journal_recovered_data_blocks", "unacknowledged data blocks recovered from journal"},
+    [GEN_STAT_SLP_TX_JOURNAL_COMMITS]                       = {"slp_tx_journal_commits", "journal flushes to disk"},
+    [GEN_STAT_SLP_TX_JOURNAL_FULL_WAITS]                    = {"slp_tx_journal_full_waits", "appends waiting for acks to free journal space"},
+    [GEN_STAT_SLP_TX_RESYNCS]                               = {"slp_tx_resyncs", "answered resync requests"},
+    [GEN_STAT_SLP_TX_FAST_RETRANSMITTED_DATA_BLOCKS]        = {"slp_tx_fast_retransmitted_data_blocks", "data blocks resent after selective acks of gap"},
+    [GEN_STAT_SLP_RX_RECEIVED_DATA_BLOCKS]                  = {"slp_rx_received_data_blocks", "received data blocks"},
+    [GEN_STAT_SLP_RX_ACCEPTED_DATA_BLOCKS]                  = {"slp_rx_accepted_data_blocks", "accepted data blocks"},
+    [GEN_STAT_SLP_RX_SENT_ACKS]                             = {"slp_rx_sent_acks", "sent acks"},
+    [GEN_STAT_SLP_RX_SENT_NACKS]                            = {"slp_rx_sent_nacks", "sent nacks"},
+    [GEN_STAT_SLP_RX_SENT_SELECTIVE_ACKS]                   = {"slp_rx_sent_selective_acks", "sent acks of data blocks saved beyond gap"},
+    [GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_DATA_BLOCKS]    = {"slp_rx_received_retransmitted_data_blocks", "received retransmitted data blocks"},
+    [GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_POLLS]          = {"slp_rx_received_retransmitted_polls", "received retransmitted polls"},
+    [GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_DATA_BLOCKS]    = {"slp_rx_accepted_retransmitted_data_blocks", "accepted retransmitted data blocks"},
+    [GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_POLLS]          = {"slp_rx_accepted_retransmitted_polls", "accepted retransmitted polls"},
+    [GEN_STAT_SLP_RX_RECEIVED_POLLS]                        = {"slp_rx_received_polls", "received polls"},
+    [GEN_STAT_SLP_RX_DATA_BLOCKS_FORWARDED_TO_APP]          = {"slp_rx_data_blocks_forwarded_to_app", "to APP forwarded data blocks"},
+    [GEN_STAT_SLP_RX_RECEIVED_FEC_PARITY_BLOCKS]            = {"slp_rx_received_fec_parity_blocks", "received FEC parity blocks"},
+    [GEN_STAT_SLP_RX_FEC_RECOVERED_DATA_BLOCKS]             = {"slp_rx_fec_recovered_data_blocks", "FEC recovered data blocks"},
+    [GEN_STAT_SLP_RX_RESYNCS]                               = {"slp_rx_resyncs", "resynchronisations to a new SLP-tx session"},
+    [GEN_STAT_SLP_RX_STALE_MSGS]                            = {"slp_rx_stale_msgs", "dropped messages of unknown SLP-tx session"},
+
+    [GEN_STAT_LINK_SENT_MSGS]                               = {"link_sent_msgs", "messages sent over emulated links"},
+    [GEN_STAT_LINK_LOST_MSGS]                               = {"link_lost_msgs", "messages lost by emulated links"},
+    [GEN_STAT_LINK_REORDERED_MSGS]                          = {"link_reordered_msgs", "messages overtaking earlier ones on emulated links"},
+    [GEN_STAT_LINK_DUPLICATED_MSGS]                         = {"link_duplicated_msgs", "messages duplicated by emulated links"},
+    [GEN_STAT_LINK_CORRUPTED_MSGS]                          = {"link_corrupted_msgs", "messages corrupted by emulated links"},
+};
+
+static const char* sGenStatLatencyName[GEN_STAT_NR_OF_LATENCIES] = {
+    [GEN_STAT_LATENCY_SUBMIT_TO_SEND]           = "latency_submit_to_send_seconds",
+    [GEN_STAT_LATENCY_SEND_TO_ACCEPT]           = "latency_send_to_accept_seconds",
+    [GEN_STAT_LATENCY_ACCEPT_TO_DELIVERY]       = "latency_accept_to_delivery_seconds",
+    [GEN_STAT_LATENCY_SUBMIT_TO_DELIVERY]       = "latency_submit_to_delivery_seconds",
+    [GEN_STAT_LATENCY_SEND_TO_ACK_RELEASE]      = "latency_send_to_ack_release_seconds",
+    [GEN_STAT_LATENCY_URGENT_SUBMIT_TO_SEND]    = "latency_urgent_submit_to_send_seconds",
+    [GEN_STAT_LATENCY_URGENT_SUBMIT_TO_ACCEPT]  = "latency_urgent_submit_to_accept_seconds",
+};
+
+//bucket of value v: exact below 16, otherwise power of 2 of v and its next 4 bits
+#define GEN_STAT_SUB_BUCKET_BITS    4
+#define GEN_STAT_SUB_BUCKETS        (1 << GEN_STAT_SUB_BUCKET_BITS)
+#define GEN_STAT_NR_OF_BUCKETS      ((64 - GEN_STAT_SUB_BUCKET_BITS + 1) * GEN_STAT_SUB_BUCKETS)
+
+//each stage is mostly recorded by one thread, so shared atomic buckets don't contend
+typedef struct GenStatHistogram_t {
+    atomic_uint_fast64_t    buckets[GEN_STAT_NR_OF_BUCKETS];
+    atomic_uint_fast64_t    maxNs;
+} __attribute__((aligned(64))) GenStatHistogram_t;
+
+static GenStatHistogram_t sGenStatHistograms[GEN_STAT_NR_OF_LATENCIES];
+
+typedef struct GenStatStampEntry_t {
+    atomic_uint_fast64_t    seqNum;
+    atomic_uint_fast64_t    timeNs;
+} GenStatStampEntry_t;
+
+static GenStatStampEntry_t sGenStatStamps[GEN_STAT_NR_OF_STAMPS][GEN_STAT_STAMP_TABLE_SIZE];
+
+//counters of one thread, only the owner writes, on own cache lines
+typedef struct GenStatThreadCounters_t {
+    atomic_uint_fast64_t    counters[GEN_STAT_NR_OF_COUNTERS];
+} __attribute__((aligned(64))) GenStatThreadCounters_t;
+
+static GenStatThreadCounters_t sGenStatThreadCounters[GEN_STAT_MAX_NR_OF_THREADS];
+static atomic_uint sGenStatNrOfThreads;
+//shared by threads beyond GEN_STAT_MAX_NR_OF_THREADS, updated with atomic add
+static GenStatThreadCounters_t sGenStatSharedCounters;
+static __thread GenStatThreadCounters_t* sGenStatOwnCounters;
+
+static GenStatThreadCounters_t* GenStatClaimCounters(void)
+{
+    unsigned int nr = atomic_fetch_add(&sGenStatNrOfThreads, 1);
+
+    if (GEN_STAT_MAX_NR_OF_THREADS <= nr) {
+        return &sGenStatSharedCounters;
+    }
+    return &sGenStatThreadCounters[nr];
+}
+
+void GenStatAdd(int counterId, uint64_t n)
+{
+    GenStatThreadCounters_t* pOwn = sGenStatOwnCounters;
+    atomic_uint_fast64_t* pCounter;
+
+    if (NULL == pOwn) {
+        pOwn = sGenStatOwnCounters = GenStatClaimCounters();
+    }
+    pCounter = &pOwn->counters[counterId];
+    if (&sGenStatSharedCounters == pOwn) {
+        atomic_fetch_add_explicit(pCounter, n, memory_order_relaxed);
+    } else {
+        atomic_store_explicit(pCounter, atomic_load_explicit(pCounter, memory_order_relaxed) + n, memory_order_relaxed);
+    }
+}
+
+uint64_t GenStatNowNs(void)
+{
+#ifdef GEN_SIM
+    return GenSimNowNs();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static int GenStatBucket(uint64_t v)
+{
+    int e;
+
+    if (GEN_STAT_SUB_BUCKETS > v) return (int) v;
+    e = 63 - __builtin_clzll(v);
+    return (e - GEN_STAT_SUB_BUCKET_BITS + 1) * GEN_STAT_SUB_BUCKETS +
+        (int) ((v >> (e - GEN_STAT_SUB_BUCKET_BITS)) & (GEN_STAT_SUB_BUCKETS - 1));
+}
+
+//highest value of bucket
+static uint64_t GenStatBucketValue(int bucket)
+{
+    int e;
+    uint64_t sub;
+
+    if (GEN_STAT_SUB_BUCKETS > bucket) return (uint64_t) bucket;
+    e = bucket / GEN_STAT_SUB_BUCKETS + GEN_STAT_SUB_BUCKET_BITS - 1;
+    sub = GEN_STAT_SUB_BUCKETS + (bucket % GEN_STAT_SUB_BUCKETS);
+    return ((sub + 1) << (e - GEN_STAT_SUB_BUCKET_BITS)) - 1;
+}
+
+//startNs 0 means start time isn't known, e.g. stamp was overwritten
+void GenStatLatency(int latencyId, uint64_t startNs, uint64_t endNs)
+{
+    GenStatHistogram_t* pHistogram = &sGenStatHistograms[latencyId];
+    uint64_t v;
+    uint64_t maxNs;
+
+    if ((0 == startNs) || (startNs > endNs)) return;
+    v = endNs - startNs;
+    atomic_fetch_add_explicit(&pHistogram->buckets[GenStatBucket(v)], 1, memory_order_relaxed);
+    maxNs = atomic_load_explicit(&pHistogram->maxNs, memory_order_relaxed);
+    while ((v > maxNs) &&
+        !atomic_compare_exchange_weak_explicit(&pHistogram->maxNs, &maxNs, v, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void GenStatStamp(uint64_t seqNum, int stampId, uint64_t timeNs)
+{
+    GenStatStampEntry_t* pEntry = &sGenStatStamps[stampId][seqNum & (GEN_STAT_STAMP_TABLE_SIZE - 1)];
+
+    atomic_store_explicit(&pEntry->seqNum, GEN_ID_INVALID, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&pEntry->timeNs, timeNs, memory_order_relaxed);
+    atomic_store_explicit(&pEntry->seqNum, seqNum, memory_order_release);
+}
+
+//returns 0 if stamp of seqNum isn't in table
+uint64_t GenStatGetStamp(uint64_t seqNum, int stampId)
+{
+    GenStatStampEntry_t* pEntry = &sGenStatStamps[stampId][seqNum & (GEN_STAT_STAMP_TABLE_SIZE - 1)];
+    uint64_t timeNs;
+
+    if (seqNum != atomic_load_explicit(&pEntry->seqNum, memory_order_acquire)) return 0;
+    timeNs = atomic_load_explicit(&pEntry->timeNs, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (seqNum != atomic_load_explicit(&pEntry->seqNum, memory_order_relaxed)) return 0;
+    return timeNs;
+}
+
+//exporter thread and APP may take snapshots at the same time, scratch buckets are used under it
+static pthread_mutex_t sGenStatSnapshotLock = PTHREAD_MUTEX_INITIALIZER;
+
+//sGenStatSnapshotLock is locked by caller
+static void GenStatGetLatency(GenStatHistogram_t* pHistogram, GenStatLatency_t* pLatency, int resetInterval)
+{
+    static uint64_t buckets[GEN_STAT_NR_OF_BUCKETS];
+    uint64_t limits[3];
+    uint64_t* pValues[3];
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    int nextLimit = 0;
+    int b;
+
+    for (b = 0; b < GEN_STAT_NR_OF_BUCKETS; b++) {
+        if (resetInterval) {
+            buckets[b] = atomic_exchange_explicit(&pHistogram->buckets[b], 0, memory_order_relaxed);
+        } else {
+            buckets[b] = atomic_load_explicit(&pHistogram->buckets[b], memory_order_relaxed);
+        }
+        count += buckets[b];
+    }
+    if (resetInterval) {
+        pLatency->maxNs = atomic_exchange_explicit(&pHistogram->maxNs, 0, memory_order_relaxed);
+    } else {
+        pLatency->maxNs = atomic_load_explicit(&pHistogram->maxNs, memory_order_relaxed);
+    }
+    pLatency->count = count;
+    pLatency->p50Ns = pLatency->p99Ns = pLatency->p999Ns = 0;
+    if (0 == count) return;
+
+    limits[0] = (count * 500 + 999) / 1000;
+    limits[1] = (count * 990 + 999) / 1000;
+    limits[2] = (count * 999 + 999) / 1000;
+    pValues[0] = &pLatency->p50Ns;
+    pValues[1] = &pLatency->p99Ns;
+    pValues[2] = &pLatency->p999Ns;
+    for (b = 0; (b < GEN_STAT_NR_OF_BUCKETS) && (3 > nextLimit); b++) {
+        sum += buckets[b];
+        while ((3 > nextLimit) && (sum >= limits[nextLimit])) {
+            *pValues[nextLimit] = GenStatBucketValue(b);
+            if (*pValues[nextLimit] > pLatency->maxNs) *pValues[nextLimit] = pLatency->maxNs;
+            nextLimit++;
+        }
+    }
+}
+
+//resetInterval starts new interval for latency histograms, counters are never reset
+void GenStatGetSnapshot(GenStatSnapshot_t* pSnapshot, int resetInterval)
+{
+    unsigned int nrOfThreads = atomic_load(&sGenStatNrOfThreads);
+    struct timespec ts;
+    unsigned int t;
+    int i;
+
+    if (GEN_STAT_MAX_NR_OF_THREADS < nrOfThreads) nrOfThreads = GEN_STAT_MAX_NR_OF_THREADS;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    pSnapshot->timeMs = (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    for (i = 0; i < GEN_STAT_NR_OF_COUNTERS; i++) {
+        pSnapshot->counters[i] = atomic_load_explicit(&sGenStatSharedCounters.counters[i], memory_order_relaxed);
+        for (t = 0; t < nrOfThreads; t++) {
+            pSnapshot->counters[i] += atomic_load_explicit(&sGenStatThreadCounters[t].counters[i], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_lock(&sGenStatSnapshotLock);
+    for (i = 0; i < GEN_STAT_NR_OF_LATENCIES; i++) {
+        GenStatGetLatency(&sGenStatHistograms[i], &pSnapshot->latencies[i], resetInterval);
+    }
+    pthread_mutex_unlock(&sGenStatSnapshotLock);
+}
+
+const char* GenStatCounterName(int counterId)
+{
+    if ((0 > counterId) || (GEN_STAT_NR_OF_COUNTERS <= counterId)) return "unknown";
+    return sGenStatCounterInfo[counterId].pName;
+}
+
+//no sample timestamps, textfile collectors don't accept them
+static void GenStatWritePrometheus(FILE* pFile, const GenStatSnapshot_t* pSnapshot)
+{
+    int i;
+
+    for (i = 0; i < GEN_STAT_NR_OF_COUNTERS; i++) {
+        fprintf(pFile, "# HELP %s %s\n# TYPE %s counter\n%s %lu\n",
+            sGenStatCounterInfo[i].pName, sGenStatCounterInfo[i].pHelp,
+            sGenStatCounterInfo[i].pName, sGenStatCounterInfo[i].pName, pSnapshot->counters[i]);
+    }
+    for (i = 0; i < GEN_STAT_NR_OF_LATENCIES; i++) {
+        const GenStatLatency_t* pLatency = &pSnapshot->latencies[i];
+        const char* pName = sGenStatLatencyName[i];
+
+        fprintf(pFile, "# HELP %s latency of the last interval\n# TYPE %s summary\n", pName, pName);
+        fprintf(pFile, "%s{quantile=\"0.5\"} %.9f\n%s{quantile=\"0.99\"} %.9f\n%s{quantile=\"0.999\"} %.9f\n%s{quantile=\"1\"} %.9f\n%s_count %lu\n",
+            pName, pLatency->p50Ns / 1e9, pName, pLatency->p99Ns / 1e9, pName, pLatency->p999Ns / 1e9,
+            pName, pLatency->maxNs / 1e9, pName, pLatency->count);
+    }
+}
+
+static void GenStatWriteJson(FILE* pFile, const GenStatSnapshot_t* pSnapshot)
+{
+    int i;
+
+    fprintf(pFile, "{\"timestamp_ms\":%lu,\"counters\":{", pSnapshot->timeMs);
+    for (i = 0; i < GEN_STAT_NR_OF_COUNTERS; i++) {
+        fprintf(pFile, "%s\"%s\":%lu", (0 < i) ? "," : "", sGenStatCounterInfo[i].pName, pSnapshot->counters[i]);
+    }
+    fprintf(pFile, "},\"latencies\":{");
+    for (i = 0; i < GEN_STAT_NR_OF_LATENCIES; i++) {
+        const GenStatLatency_t* pLatency = &pSnapshot->latencies[i];
+
+        fprintf(pFile, "%s\"%s\":{\"count\":%lu,\"p50_ns\":%lu,\"p99_ns\":%lu,\"p999_ns\":%lu,\"max_ns\":%lu}",
+            (0 < i) ? "," : "", sGenStatLatencyName[i], pLatency->count,
+            pLatency->p50Ns, pLatency->p99Ns, pLatency->p999Ns, pLatency->maxNs);
+    }
+    fprintf(pFile, "}}\n");
+}
+
+//writes snapshot into temporary file which is renamed, so readers never see a partial file
+static void GenStatExport(const GenStatSnapshot_t* pSnapshot)
+{
+    char tmpFileName[256];
+    FILE* pFile;
+
+    if (NULL == gGenStatSettings.pExportFileName) {
+        pthread_mutex_lock(&gGenPrintLock);
+        if (GEN_STAT_FORMAT_JSON == gGenStatSettings.exportFormat) {
+            GenStatWriteJson(stdout, pSnapshot);
+        } else {
+            GenStatWritePrometheus(stdout, pSnapshot);
+        }
+        pthread_mutex_unlock(&gGenPrintLock);
+        return;
+    }
+
+    snprintf(tmpFileName, sizeof(tmpFileName), "%s.tmp", gGenStatSettings.pExportFileName);
+    pFile = fopen(tmpFileName, "w");
+    if (NULL == pFile) {
+        perror("fopen");
+        exit(1);
+    }
+    if (GEN_STAT_FORMAT_JSON == gGenStatSettings.exportFormat) {
+        GenStatWriteJson(pFile, pSnapshot);
+    } else {
+        GenStatWritePrometheus(pFile, pSnapshot);
+    }
+    fclose(pFile);
+    if (0 > rename(tmpFileName, gGenStatSettings.pExportFileName)) {
+        perror("rename");
+        exit(1);
+    }
+}
+
+void* gen_stat_export()
+{
+    GenStatSnapshot_t snapshot;
+
+    if (0 == gGenStatSettings.exportIntervalMs) return NULL;
+    for (;;) {
+        usleep(gGenStatSettings.exportIntervalMs * 1000);
+        GenStatGetSnapshot(&snapshot, 1);
+        GenStatExport(&snapshot);
+    }
+}
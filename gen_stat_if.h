@@ -0,0 +1,133 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Statistics counters: each thread increments its own 64-bit counters without locks or
+ * atomic read-modify-write, a snapshot sums them on demand. gen_stat_export thread writes
+ * snapshots in Prometheus text format or JSON at interval of gGenStatSettings.
+ *
+ * Latency of block lifecycle stages is kept in log-bucketed histograms, 16 sub-buckets per
+ * power of 2 give values within 6.25%. Stage start times are in a table indexed by seqNum.
+ */
+#define GEN_STAT_MAX_NR_OF_THREADS      32
+
+enum {
+    GEN_STAT_APP_DELIVERED_DATA_BLOCKS = 0,
+    GEN_STAT_APP_RAND_BREAKS,
+    GEN_STAT_APP_RAND_BREAK_SECONDS,
+
+    GEN_STAT_SLP_TX_DATA_BLOCKS_RECEIVED_FROM_APP,
+    GEN_STAT_SLP_TX_URGENT_DATA_BLOCKS_RECEIVED_FROM_APP,
+    GEN_STAT_SLP_TX_SENT_DATA_BLOCKS,
+    GEN_STAT_SLP_TX_RECEIVED_ACKS,
+    GEN_STAT_SLP_TX_RECEIVED_NACKS,
+    GEN_STAT_SLP_TX_RETRANSMITTED_DATA_BLOCKS,
+    GEN_STAT_SLP_TX_RETRANSMITTED_POLLS,
+    GEN_STAT_SLP_TX_SENT_PROBES,
+    GEN_STAT_SLP_TX_COMPRESSED_DATA_BLOCKS,
+    GEN_STAT_SLP_TX_SENT_FEC_PARITY_BLOCKS,
+    GEN_STAT_SLP_TX_FEC_RECOVERED_DATA_BLOCKS,
+    GEN_STAT_SLP_TX_JOURNAL_RECOVERED_DATA_BLOCKS,
+    GEN_STAT_SLP_TX_JOURNAL_COMMITS,
+    GEN_STAT_SLP_TX_JOURNAL_FULL_WAITS,
+    GEN_STAT_SLP_TX_RESYNCS,
+    GEN_STAT_SLP_TX_FAST_RETRANSMITTED_DATA_BLOCKS,
+
+    GEN_STAT_SLP_RX_RECEIVED_DATA_BLOCKS,
+    GEN_STAT_SLP_RX_ACCEPTED_DATA_BLOCKS,
+    GEN_STAT_SLP_RX_SENT_ACKS,
+    GEN_STAT_SLP_RX_SENT_NACKS,
+    GEN_STAT_SLP_RX_SENT_SELECTIVE_ACKS,
+    GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_DATA_BLOCKS,
+    GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_POLLS,
+    GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_DATA_BLOCKS,
+    GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_POLLS,
+    GEN_STAT_SLP_RX_RECEIVED_POLLS,
+    GEN_STAT_SLP_RX_DATA_BLOCKS_FORWARDED_TO_APP,
+    GEN_STAT_SLP_RX_RECEIVED_FEC_PARITY_BLOCKS,
+    GEN_STAT_SLP_RX_FEC_RECOVERED_DATA_BLOCKS,
+    GEN_STAT_SLP_RX_RESYNCS,
+    GEN_STAT_SLP_RX_STALE_MSGS,
+
+    GEN_STAT_LINK_SENT_MSGS,
+    GEN_STAT_LINK_LOST_MSGS,
+    GEN_STAT_LINK_REORDERED_MSGS,
+    GEN_STAT_LINK_DUPLICATED_MSGS,
+    GEN_STAT_LINK_CORRUPTED_MSGS,
+
+    GEN_STAT_NR_OF_COUNTERS
+};
+
+//block lifecycle stages: APP submit, SLP-tx send, SLP-rx accept, APP delivery, SLP-tx ack release,
+//SUBMIT_TO_SEND is of bulk data blocks, urgent ones have their own stages
+enum {
+    GEN_STAT_LATENCY_SUBMIT_TO_SEND = 0,
+    GEN_STAT_LATENCY_SEND_TO_ACCEPT,
+    GEN_STAT_LATENCY_ACCEPT_TO_DELIVERY,
+    GEN_STAT_LATENCY_SUBMIT_TO_DELIVERY,
+    GEN_STAT_LATENCY_SEND_TO_ACK_RELEASE,
+    GEN_STAT_LATENCY_URGENT_SUBMIT_TO_SEND,
+    GEN_STAT_LATENCY_URGENT_SUBMIT_TO_ACCEPT,
+    GEN_STAT_NR_OF_LATENCIES
+};
+
+//stage start times saved per seqNum
+enum {
+    GEN_STAT_STAMP_SUBMIT = 0,
+    GEN_STAT_STAMP_SEND,
+    GEN_STAT_NR_OF_STAMPS
+};
+
+#define GEN_STAT_STAMP_TABLE_SIZE       (64*1024) //power of 2, more than seqNums in flight
+
+#define GEN_STAT_FORMAT_PROMETHEUS      0
+#define GEN_STAT_FORMAT_JSON            1
+
+typedef struct GenStatSettings_t {
+    int             counters; //0: GEN_STAT_INC and GEN_STAT_ADD do nothing
+    int             exportFormat;
+    uint32_t        exportIntervalMs; //0: no export
+    const char*     pExportFileName; //NULL: stdout
+} GenStatSettings_t;
+
+extern GenStatSettings_t gGenStatSettings;
+
+typedef struct GenStatLatency_t {
+    uint64_t    count;
+    uint64_t    p50Ns;
+    uint64_t    p99Ns;
+    uint64_t    p999Ns;
+    uint64_t    maxNs;
+} GenStatLatency_t;
+
+typedef struct GenStatSnapshot_t {
+    uint64_t            timeMs; //wall clock
+    uint64_t            counters[GEN_STAT_NR_OF_COUNTERS];
+    GenStatLatency_t    latencies[GEN_STAT_NR_OF_LATENCIES]; //since previous interval reset
+} GenStatSnapshot_t;
+
+void GenStatAdd(int counterId, uint64_t n);
+//thread safe, resetInterval: histograms start again, so only one taker should reset,
+//the exporter does when stat.export_interval_ms is set, others pass 0 to see the ongoing interval
+void GenStatGetSnapshot(GenStatSnapshot_t* pSnapshot, int resetInterval);
+const char* GenStatCounterName(int counterId);
+uint64_t GenStatNowNs(void);
+void GenStatLatency(int latencyId, uint64_t startNs, uint64_t endNs);
+void GenStatStamp(uint64_t seqNum, int stampId, uint64_t timeNs);
+uint64_t GenStatGetStamp(uint64_t seqNum, int stampId);
+void* gen_stat_export();
+
+//disabled counters cost one predictable branch per update
+#define GEN_STAT_ADD(counterId, n) do { if (gGenStatSettings.counters) GenStatAdd((counterId), (n)); } while (0)
+#define GEN_STAT_INC(counterId) GEN_STAT_ADD((counterId), 1)
@@ -0,0 +1,281 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include <time.h>
+#include "common.h"
+#include "gen_if.h"
+#include "gen_timer_if.h"
+#include "gen_stat_if.h"
+
+#define GEN_TIMER_TICK_NS               (GEN_TIMER_TICK_US * 1000ULL)
+#define GEN_TIMER_SLOT_MASK             (GEN_TIMER_NR_OF_SLOTS - 1)
+#define GEN_TIMER_MAX_DELTA             ((1ULL << (GEN_TIMER_LEVEL_BITS * GEN_TIMER_NR_OF_LEVELS)) - 1)
+
+//slots are circular lists, the head is a timer that is never armed
+typedef struct GenTimerState_t {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    GenTimer_t      slots[GEN_TIMER_NR_OF_LEVELS][GEN_TIMER_NR_OF_SLOTS];
+    uint64_t        occupied[GEN_TIMER_NR_OF_LEVELS]; //slot bits, cleared lazily after cancels
+    uint64_t        currentTick; //earlier ticks are handled
+    uint64_t        sleepTick; //gen_timer_run wakes at this tick unless signalled
+} GenTimerState_t;
+
+static GenTimerState_t sGenTimerState;
+
+void GenTimerInit(void)
+{
+    pthread_condattr_t attr;
+    int level;
+    int slot;
+
+    if (pthread_mutex_init(&sGenTimerState.lock, NULL) != 0) {
+        printf("\n timer mutex init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (pthread_cond_init(&sGenTimerState.cond, &attr) != 0) {
+        printf("\n timer cond init failed\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_condattr_destroy(&attr);
+
+    for (level = 0; level < GEN_TIMER_NR_OF_LEVELS; level++) {
+        for (slot = 0; slot < GEN_TIMER_NR_OF_SLOTS; slot++) {
+            sGenTimerState.slots[level][slot].pNext = &sGenTimerState.slots[level][slot];
+            sGenTimerState.slots[level][slot].pPrev = &sGenTimerState.slots[level][slot];
+        }
+        sGenTimerState.occupied[level] = 0;
+    }
+    sGenTimerState.currentTick = GenStatNowNs() / GEN_TIMER_TICK_NS;
+    sGenTimerState.sleepTick = UINT64_MAX;
+}
+
+void GenTimerSetup(GenTimer_t* pTimer, GenTimerCallback_t pCallback, void* pArg)
+{
+    pTimer->pNext = NULL;
+    pTimer->pPrev = NULL;
+    pTimer->dueTick = 0;
+    pTimer->pCallback = pCallback;
+    pTimer->pArg = pArg;
+}
+
+static int GenTimerIsListEmpty(const GenTimer_t* pHead)
+{
+    return pHead->pNext == pHead;
+}
+
+static void GenTimerUnlink(GenTimer_t* pTimer)
+{
+    pTimer->pPrev->pNext = pTimer->pNext;
+    pTimer->pNext->pPrev = pTimer->pPrev;
+    pTimer->pNext = NULL;
+    pTimer->pPrev = NULL;
+}
+
+static void GenTimerLink(GenTimer_t* pHead, GenTimer_t* pTimer)
+{
+    pTimer->pPrev = pHead->pPrev;
+    pTimer->pNext = pHead;
+    pHead->pPrev->pNext = pTimer;
+    pHead->pPrev = pTimer;
+}
+
+//all timers of pFrom are moved to empty pTo
+static void GenTimerMoveList(GenTimer_t* pFrom, GenTimer_t* pTo)
+{
+    if (GenTimerIsListEmpty(pFrom)) return;
+    pTo->pNext = pFrom->pNext;
+    pTo->pPrev = pFrom->pPrev;
+    pTo->pNext->pPrev = pTo;
+    pTo->pPrev->pNext = pTo;
+    pFrom->pNext = pFrom;
+    pFrom->pPrev = pFrom;
+}
+
+//level is the lowest one whose revolution reaches due tick, lock is held by caller
+static void GenTimerInsert(GenTimer_t* pTimer)
+{
+    uint64_t delta;
+    int level = 0;
+    int slot;
+
+    if (pTimer->dueTick < sGenTimerState.currentTick) {
+        pTimer->dueTick = sGenTimerState.currentTick;
+    }
+    delta = pTimer->dueTick - sGenTimerState.currentTick;
+    if (GEN_TIMER_MAX_DELTA < delta) {
+        pTimer->dueTick = sGenTimerState.currentTick + GEN_TIMER_MAX_DELTA;
+        delta = GEN_TIMER_MAX_DELTA;
+    }
+    while ((delta >> (GEN_TIMER_LEVEL_BITS * (level + 1))) != 0) {
+        level++;
+    }
+    slot = (pTimer->dueTick >> (GEN_TIMER_LEVEL_BITS * level)) & GEN_TIMER_SLOT_MASK;
+    GenTimerLink(&sGenTimerState.slots[level][slot], pTimer);
+    sGenTimerState.occupied[level] |= 1ULL << slot;
+}
+
+//returns occupied slot bits of level from slot on, bits of slots emptied by cancels are cleared
+static uint64_t GenTimerOccupied(int level, int slot)
+{
+    uint64_t bits = sGenTimerState.occupied[level] >> slot;
+
+    while (0 != bits) {
+        int i = slot + __builtin_ctzll(bits);
+
+        if (!GenTimerIsListEmpty(&sGenTimerState.slots[level][i])) break;
+        sGenTimerState.occupied[level] &= ~(1ULL << i);
+        bits &= ~(1ULL << (i - slot));
+    }
+    return bits;
+}
+
+//first tick having a level 0 slot to expire or higher level slots to move down, UINT64_MAX if none
+static uint64_t GenTimerNextTick(void)
+{
+    int slot = sGenTimerState.currentTick & GEN_TIMER_SLOT_MASK;
+    uint64_t base = sGenTimerState.currentTick - slot;
+    uint64_t boundary = (0 == slot) ? base : (base + GEN_TIMER_NR_OF_SLOTS);
+    uint64_t bits;
+    int higher = 0;
+    int level;
+
+    //revolution of level 0 starts by moving timers down, also when currentTick is at its start
+    for (level = 1; (level < GEN_TIMER_NR_OF_LEVELS) && !higher; level++) {
+        higher = (0 != GenTimerOccupied(level, 0));
+    }
+    bits = GenTimerOccupied(0, slot);
+    if ((0 != bits) && (0 != slot)) return sGenTimerState.currentTick + __builtin_ctzll(bits);
+    if (higher) return boundary;
+    bits = GenTimerOccupied(0, 0);
+    if (0 != bits) return boundary + __builtin_ctzll(bits);
+    return UINT64_MAX;
+}
+
+//timers of a higher level slot are inserted again, now to a lower level
+static void GenTimerCascade(int level, int slot)
+{
+    GenTimer_t moved;
+    GenTimer_t* pTimer;
+
+    moved.pNext = &moved;
+    moved.pPrev = &moved;
+    GenTimerMoveList(&sGenTimerState.slots[level][slot], &moved);
+    while (!GenTimerIsListEmpty(&moved)) {
+        pTimer = moved.pNext;
+        GenTimerUnlink(pTimer);
+        GenTimerInsert(pTimer);
+    }
+}
+
+//handles tick, callbacks are called without lock
+static void GenTimerExpire(uint64_t tick)
+{
+    GenTimer_t expired;
+    GenTimer_t* pTimer;
+    GenTimerCallback_t pCallback;
+    void* pArg;
+    int level;
+    int slot;
+
+    sGenTimerState.currentTick = tick;
+    slot = tick & GEN_TIMER_SLOT_MASK;
+    for (level = 1; (0 == slot) && (level < GEN_TIMER_NR_OF_LEVELS); level++) {
+        slot = (tick >> (GEN_TIMER_LEVEL_BITS * level)) & GEN_TIMER_SLOT_MASK;
+        GenTimerCascade(level, slot);
+    }
+
+    //timers armed by callbacks expire on later ticks
+    expired.pNext = &expired;
+    expired.pPrev = &expired;
+    GenTimerMoveList(&sGenTimerState.slots[0][tick & GEN_TIMER_SLOT_MASK], &expired);
+    sGenTimerState.currentTick = tick + 1;
+    while (!GenTimerIsListEmpty(&expired)) {
+        pTimer = expired.pNext;
+        pCallback = pTimer->pCallback;
+        pArg = pTimer->pArg;
+        GenTimerUnlink(pTimer);
+        pthread_mutex_unlock(&sGenTimerState.lock);
+        pCallback(pArg);
+        pthread_mutex_lock(&sGenTimerState.lock);
+    }
+}
+
+//armed timer is moved to its new due time
+void GenTimerArm(GenTimer_t* pTimer, uint32_t delayUs)
+{
+    uint64_t dueNs = GenStatNowNs() + (uint64_t) delayUs * 1000;
+
+    pthread_mutex_lock(&sGenTimerState.lock);
+    if (NULL != pTimer->pNext) {
+        GenTimerUnlink(pTimer);
+    }
+    pTimer->dueTick = (dueNs + GEN_TIMER_TICK_NS - 1) / GEN_TIMER_TICK_NS;
+    GenTimerInsert(pTimer);
+    if (pTimer->dueTick < sGenTimerState.sleepTick) {
+        sGenTimerState.sleepTick = pTimer->dueTick;
+        pthread_cond_signal(&sGenTimerState.cond);
+    }
+    pthread_mutex_unlock(&sGenTimerState.lock);
+}
+
+void GenTimerCancel(GenTimer_t* pTimer)
+{
+    pthread_mutex_lock(&sGenTimerState.lock);
+    if (NULL != pTimer->pNext) {
+        GenTimerUnlink(pTimer);
+    }
+    pthread_mutex_unlock(&sGenTimerState.lock);
+}
+
+int GenTimerIsArmed(const GenTimer_t* pTimer)
+{
+    return NULL != pTimer->pNext;
+}
+
+//expires timers at their due ticks, sleeps over ticks having nothing to do
+void* gen_timer_run()
+{
+    struct timespec ts;
+    uint64_t nowTick;
+    uint64_t nextTick;
+    uint64_t dueNs;
+
+    pthread_mutex_lock(&sGenTimerState.lock);
+    for (;;) {
+        nowTick = GenStatNowNs() / GEN_TIMER_TICK_NS;
+        nextTick = GenTimerNextTick();
+        if (nextTick <= nowTick) {
+            GenTimerExpire(nextTick);
+            continue;
+        }
+
+        //nothing to do before nextTick, revolution boundaries having timers to move down aren't passed
+        if (sGenTimerState.currentTick < nowTick) {
+            sGenTimerState.currentTick = nowTick;
+        }
+        sGenTimerState.sleepTick = nextTick;
+        if (UINT64_MAX == nextTick) {
+            pthread_cond_wait(&sGenTimerState.cond, &sGenTimerState.lock);
+            continue;
+        }
+        dueNs = nextTick * GEN_TIMER_TICK_NS;
+        ts.tv_sec = dueNs / 1000000000ULL;
+        ts.tv_nsec = dueNs % 1000000000ULL;
+        pthread_cond_timedwait(&sGenTimerState.cond, &sGenTimerState.lock, &ts);
+    }
+    return NULL;
+}
@@ -0,0 +1,45 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Hierarchical timer wheel for protocol timers: SLP-rx NACK and SLP-tx tail loss probe timers.
+ * GEN_TIMER_NR_OF_LEVELS wheels of 2^GEN_TIMER_LEVEL_BITS slots, a slot of a level spans one
+ * revolution of the level below, timers move down a level when their slot comes up. Arm and
+ * cancel are O(1) and the timer is embedded in its owner, so there is nothing to allocate.
+ * gen_timer_run thread sleeps until the next occupied slot and calls expired timers in due
+ * order without the wheel lock held, so callbacks may arm and cancel timers. A timer cancelled
+ * while its callback is already being called still gets that call, callbacks check their state.
+ */
+#define GEN_TIMER_TICK_US               100
+#define GEN_TIMER_LEVEL_BITS            6
+#define GEN_TIMER_NR_OF_SLOTS           (1 << GEN_TIMER_LEVEL_BITS)
+#define GEN_TIMER_NR_OF_LEVELS          4 //longer delays expire at 2^24 ticks, about 28 minutes
+
+typedef void (*GenTimerCallback_t)(void* pArg);
+
+//NULL pNext: not armed
+typedef struct GenTimer_t {
+    struct GenTimer_t*  pNext;
+    struct GenTimer_t*  pPrev;
+    uint64_t            dueTick;
+    GenTimerCallback_t  pCallback;
+    void*               pArg;
+} GenTimer_t;
+
+void GenTimerInit(void);
+void GenTimerSetup(GenTimer_t* pTimer, GenTimerCallback_t pCallback, void* pArg);
+void GenTimerArm(GenTimer_t* pTimer, uint32_t delayUs);
+void GenTimerCancel(GenTimer_t* pTimer);
+int GenTimerIsArmed(const GenTimer_t* pTimer);
+void* gen_timer_run();
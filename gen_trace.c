@@ -0,0 +1,144 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "common.h"
+#include "gen_if.h"
+#include "gen_trace_if.h"
+
+typedef struct GenTraceEventInfo_t {
+    const char* pName;
+    const char* pArg1Name;
+    const char* pArg2Name;
+} GenTraceEventInfo_t;
+
+static const GenTraceEventInfo_t sGenTraceEventInfo[GEN_TRACE_NR_OF_EVENTS] = {
+    [GEN_TRACE_NONE]                        = {"none", "arg1", "arg2"},
+    [GEN_TRACE_APP_DATA_SENT]               = {"app data sent", "len", "appId"},
+    [GEN_TRACE_APP_DATA_RECEIVED]           = {"app data received", "len", "appId"},
+    [GEN_TRACE_SLP_TX_DATA_SENT]            = {"slp-tx data sent", "len", "flags"},
+    [GEN_TRACE_SLP_TX_RETRANSMITTED]        = {"slp-tx retransmitted", "len", "flags"},
+    [GEN_TRACE_SLP_TX_PROBE_SENT]           = {"slp-tx probe sent", "nrOfDataBlocks", "oldestSeqNum"},
+    [GEN_TRACE_SLP_TX_ACK_RECEIVED]         = {"slp-tx ack received", "nrOfReleased", "flags"},
+    [GEN_TRACE_SLP_TX_NACK_RECEIVED]        = {"slp-tx nack received", "found", "flags"},
+    [GEN_TRACE_SLP_TX_FEC_PARITY_SENT]      = {"slp-tx fec parity sent", "len", "seqNumMask"},
+    [GEN_TRACE_SLP_TX_RESYNC_SENT]          = {"slp-tx resync sent", "nrOfDataBlocks", "rxEpoch"},
+    [GEN_TRACE_SLP_TX_FAST_RETRANSMIT]      = {"slp-tx fast retransmit", "nrOfDataBlocks", "selectiveAcks"},
+    [GEN_TRACE_SLP_RX_DATA_ACCEPTED]        = {"slp-rx data accepted", "len", "ackFlags"},
+    [GEN_TRACE_SLP_RX_WRONG_ORDER_SAVED]    = {"slp-rx wrong order saved", "nrOfWrongOrder", "waitSeqNum"},
+    [GEN_TRACE_SLP_RX_NACK_SENT]            = {"slp-rx nack sent", "flags", "arg2"},
+    [GEN_TRACE_SLP_RX_FEC_RECOVERED]        = {"slp-rx fec recovered", "len", "firstSeqNum"},
+    [GEN_TRACE_SLP_RX_RESYNCED]             = {"slp-rx resynced", "txEpoch", "dropped"},
+    [GEN_TRACE_LINK_LOST]                   = {"link lost", "linkId", "msgSize"},
+    [GEN_TRACE_LINK_REORDERED]              = {"link reordered", "linkId", "skippedDelayUs"},
+    [GEN_TRACE_LINK_DUPLICATED]             = {"link duplicated", "linkId", "msgSize"},
+    [GEN_TRACE_LINK_CORRUPTED]              = {"link corrupted", "linkId", "bitNr"},
+};
+
+GenTraceSettings_t gGenTraceSettings = {
+    1,
+    GEN_TRACE_FILE_NAME
+};
+
+static GenTraceFile_t* sGenTraceFile;
+static __thread GenTraceRing_t* sGenTraceRing;
+static __thread int sGenTraceRingClaimed;
+
+void GenTraceInit(void)
+{
+    int fd;
+
+    fd = open(gGenTraceSettings.pFileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (0 > fd) {
+        perror("open");
+        exit(1);
+    }
+    if (0 > ftruncate(fd, sizeof(GenTraceFile_t))) {
+        perror("ftruncate");
+        exit(1);
+    }
+    sGenTraceFile = mmap(NULL, sizeof(GenTraceFile_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == sGenTraceFile) {
+        perror("mmap");
+        exit(1);
+    }
+    close(fd);
+
+    sGenTraceFile->magic = GEN_TRACE_MAGIC;
+    sGenTraceFile->version = GEN_TRACE_VERSION;
+    sGenTraceFile->ringSize = GEN_TRACE_RING_SIZE;
+    sGenTraceFile->maxNrOfRings = GEN_TRACE_MAX_NR_OF_RINGS;
+    atomic_store(&sGenTraceFile->nrOfRings, 0);
+}
+
+//first trace of a thread claims a ring, threads beyond GEN_TRACE_MAX_NR_OF_RINGS aren't traced
+static GenTraceRing_t* GenTraceClaimRing(void)
+{
+    unsigned int nr;
+
+    sGenTraceRingClaimed = 1;
+    nr = atomic_fetch_add(&sGenTraceFile->nrOfRings, 1);
+    if (GEN_TRACE_MAX_NR_OF_RINGS <= nr) {
+        return NULL;
+    }
+    sGenTraceFile->rings[nr].tid = (uint32_t) syscall(SYS_gettid);
+    return &sGenTraceFile->rings[nr];
+}
+
+void GenTrace(uint16_t eventId, uint64_t seqNum, uint32_t arg1, uint64_t arg2)
+{
+    GenTraceRing_t* pRing = sGenTraceRing;
+    GenTraceRecord_t* pRecord;
+#ifndef GEN_SIM
+    struct timespec ts;
+#endif
+    uint64_t index;
+
+    if (NULL == pRing) {
+        if ((NULL == sGenTraceFile) || sGenTraceRingClaimed) return;
+        pRing = sGenTraceRing = GenTraceClaimRing();
+        if (NULL == pRing) return;
+    }
+
+    index = atomic_load_explicit(&pRing->writeIndex, memory_order_relaxed);
+    pRecord = &pRing->records[index & (GEN_TRACE_RING_SIZE - 1)];
+#ifdef GEN_SIM
+    pRecord->timeNs = GenSimNowNs();
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    pRecord->timeNs = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+    pRecord->seqNum = seqNum;
+    pRecord->arg2 = arg2;
+    pRecord->arg1 = arg1;
+    pRecord->eventId = eventId;
+    atomic_store_explicit(&pRing->writeIndex, index + 1, memory_order_release);
+}
+
+const char* GenTraceEventName(uint16_t eventId)
+{
+    if ((GEN_TRACE_NR_OF_EVENTS <= eventId) || (NULL == sGenTraceEventInfo[eventId].pName)) return "unknown";
+    return sGenTraceEventInfo[eventId].pName;
+}
+
+const char* GenTraceArgName(uint16_t eventId, int argNr)
+{
+    if ((GEN_TRACE_NR_OF_EVENTS <= eventId) || (NULL == sGenTraceEventInfo[eventId].pName)) {
+        return (1 == argNr) ? "arg1" : "arg2";
+    }
+    return (1 == argNr) ? sGenTraceEventInfo[eventId].pArg1Name : sGenTraceEventInfo[eventId].pArg2Name;
+}
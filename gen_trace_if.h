@@ -0,0 +1,91 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * Binary trace: each thread writes fixed size records to its own ring without locks.
+ * Rings are in a shared file mapping, so records survive a crash and tools/gen_trace_decode
+ * renders them offline as text or Chrome trace JSON.
+ */
+#define GEN_TRACE_FILE_NAME         "slp.trace"
+#define GEN_TRACE_MAGIC             0x534c5054 //"SLPT"
+#define GEN_TRACE_VERSION           1
+#define GEN_TRACE_RING_SIZE         (16*1024) //records per thread, power of 2
+#define GEN_TRACE_MAX_NR_OF_RINGS   32
+
+//event ids, names and argument names are in gen_trace.c
+enum {
+    GEN_TRACE_NONE = 0,
+    GEN_TRACE_APP_DATA_SENT,
+    GEN_TRACE_APP_DATA_RECEIVED,
+    GEN_TRACE_SLP_TX_DATA_SENT,
+    GEN_TRACE_SLP_TX_RETRANSMITTED,
+    GEN_TRACE_SLP_TX_PROBE_SENT,
+    GEN_TRACE_SLP_TX_ACK_RECEIVED,
+    GEN_TRACE_SLP_TX_NACK_RECEIVED,
+    GEN_TRACE_SLP_TX_FEC_PARITY_SENT,
+    GEN_TRACE_SLP_TX_RESYNC_SENT,
+    GEN_TRACE_SLP_TX_FAST_RETRANSMIT,
+    GEN_TRACE_SLP_RX_DATA_ACCEPTED,
+    GEN_TRACE_SLP_RX_WRONG_ORDER_SAVED,
+    GEN_TRACE_SLP_RX_NACK_SENT,
+    GEN_TRACE_SLP_RX_FEC_RECOVERED,
+    GEN_TRACE_SLP_RX_RESYNCED,
+    GEN_TRACE_LINK_LOST,
+    GEN_TRACE_LINK_REORDERED,
+    GEN_TRACE_LINK_DUPLICATED,
+    GEN_TRACE_LINK_CORRUPTED,
+    GEN_TRACE_NR_OF_EVENTS
+};
+
+typedef struct GenTraceRecord_t {
+    uint64_t    timeNs; //CLOCK_MONOTONIC
+    uint64_t    seqNum; //0 if not known yet, e.g. APP data sent
+    uint64_t    arg2;
+    uint32_t    arg1;
+    uint16_t    eventId;
+    uint16_t    reserved;
+} GenTraceRecord_t;
+
+typedef struct GenTraceRing_t {
+    atomic_uint_fast64_t    writeIndex; //nr of records ever written, only owner thread writes
+    uint32_t                tid;
+    uint8_t                 pad[64 - sizeof(atomic_uint_fast64_t) - sizeof(uint32_t)];
+    GenTraceRecord_t        records[GEN_TRACE_RING_SIZE];
+} GenTraceRing_t;
+
+typedef struct GenTraceFile_t {
+    uint32_t        magic;
+    uint32_t        version;
+    uint32_t        ringSize;
+    uint32_t        maxNrOfRings;
+    atomic_uint     nrOfRings;
+    uint8_t         pad[64 - 5 * sizeof(uint32_t)];
+    GenTraceRing_t  rings[GEN_TRACE_MAX_NR_OF_RINGS];
+} GenTraceFile_t;
+
+typedef struct GenTraceSettings_t {
+    int             enabled; //0: GenTraceInit isn't called and events aren't recorded
+    const char*     pFileName;
+} GenTraceSettings_t;
+
+extern GenTraceSettings_t gGenTraceSettings;
+
+void GenTraceInit(void);
+void GenTrace(uint16_t eventId, uint64_t seqNum, uint32_t arg1, uint64_t arg2);
+const char* GenTraceEventName(uint16_t eventId);
+const char* GenTraceArgName(uint16_t eventId, int argNr);
+
+//disabled trace costs one predictable branch per event
+#define GEN_TRACE_EVENT(eventId, seqNum, arg1, arg2) \
+    do { if (gGenTraceSettings.enabled) GenTrace((eventId), (seqNum), (arg1), (arg2)); } while (0)
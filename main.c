@@ -15,54 +15,50 @@ This can easily be ported to other Operating System environments, also into embe
 #include "common.h"
 #include "msg.h"
 #include "gen_if.h"
+#include "gen_config_if.h"
+#include "gen_link_if.h"
 #include "util_if.h"
 
-//Main function which starts all necessary threads
-int main(void)
+//test APP keeps the loss pattern of earlier hand-coded test drops: random loss of 1/256 data blocks
+//and acks and 1/16 control messages, plus bursts of about 10 successive data blocks and acks,
+//settings of GenConfigLoad override these, e.g. --link.data.loss_ppm=0
+static void MainSetTestLinks(void)
+{
+    GenLinkSettings_t* pLinks = gGenLinkSettings;
+
+    pLinks[GEN_LINK_DATA].delayUs = 100000;
+    pLinks[GEN_LINK_DATA].lossPpm = 3906;
+    pLinks[GEN_LINK_DATA].goodToBadPpm = 3906;
+    pLinks[GEN_LINK_DATA].badToGoodPpm = 100000;
+    pLinks[GEN_LINK_DATA].badLossPpm = GEN_LINK_PPM;
+    pLinks[GEN_LINK_RETRANS].delayUs = 10000;
+    pLinks[GEN_LINK_RETRANS].lossPpm = 62500;
+    pLinks[GEN_LINK_POLL].delayUs = 10000;
+    pLinks[GEN_LINK_POLL].lossPpm = 62500;
+    pLinks[GEN_LINK_FEC].delayUs = 100000;
+    pLinks[GEN_LINK_FEC].lossPpm = 62500;
+    pLinks[GEN_LINK_ACK].delayUs = 10000;
+    pLinks[GEN_LINK_ACK].lossPpm = 3906;
+    pLinks[GEN_LINK_ACK].goodToBadPpm = 3906;
+    pLinks[GEN_LINK_ACK].badToGoodPpm = 100000;
+    pLinks[GEN_LINK_ACK].badLossPpm = GEN_LINK_PPM;
+    pLinks[GEN_LINK_NACK].delayUs = 1000;
+    pLinks[GEN_LINK_NACK].lossPpm = 62500;
+}
+
+//Main function which starts all necessary threads, settings are in arguments: gen_config_if.h
+int main(int argc, char* argv[])
 {
     pthread_t thread_app1;
     pthread_t thread_app2;
     pthread_t thread_app3;
-    pthread_t thread_app4;
-    pthread_t thread_slp1;
-    pthread_t thread_slp2;
-    pthread_t thread_slp3;
-    pthread_t thread_slp4;
-    pthread_t thread_slp5;
-    pthread_t thread_slp6;
-    pthread_t thread_slp7;
-    pthread_t thread_slp8;
-    pthread_t thread_slp9;
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-    pthread_t thread_slp_d1;
-#endif
     int retVal;
 
-    crcInit();
-
-    if (pthread_mutex_init(&gGenPrintLock, NULL) != 0)
-    {
-        printf("\n print mutex init failed\n");
-        exit(EXIT_FAILURE);
-    }
+    MainSetTestLinks();
+    GenConfigLoad(argc, argv);
 
-    if (pthread_mutex_init(&gAppLock, NULL) != 0)
-    {
-        printf("\n App mutex init failed\n");
-        exit(EXIT_FAILURE);
-    }
-
-    if (pthread_mutex_init(&gSlpTxLock, NULL) != 0)
-    {
-        printf("\n slp tx mutex init failed\n");
-        exit(EXIT_FAILURE);
-    }
-
-    if (pthread_mutex_init(&gSlpRxLock, NULL) != 0)
-    {
-        printf("\n slp rx mutex init failed\n");
-        exit(EXIT_FAILURE);
-    }
+    //opens SLP, which starts SLP threads
+    AppInit();
 
     //create thread_app1
     retVal = pthread_create(&thread_app1, NULL, app_tx_send_data, NULL);
@@ -73,7 +69,7 @@ int main(void)
     }
 
     //create thread_app2
-    retVal = pthread_create(&thread_app2, NULL, app_tx_receive_info, NULL);
+    retVal = pthread_create(&thread_app2, NULL, app_rx_receive_data, NULL);
     if(retVal)
     {
         fprintf(stderr,"Error - pthread_create(&thread_app2, ..) returned value: %d\n", retVal);
@@ -81,117 +77,16 @@ int main(void)
     }
 
     //create thread_app3
-    retVal = pthread_create(&thread_app3, NULL, app_tx_receive_state, NULL);
+    retVal = pthread_create(&thread_app3, NULL, app_tx_reap_completions, NULL);
     if(retVal)
     {
         fprintf(stderr,"Error - pthread_create(&thread_app3, ..) returned value: %d\n", retVal);
         exit(EXIT_FAILURE);
     }
 
-    //create thread_app4
-    retVal = pthread_create(&thread_app4, NULL, app_rx_receive_data, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_app4, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp1
-    retVal = pthread_create(&thread_slp1, NULL, slp_tx_receive_app_data, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp1, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp2
-    retVal = pthread_create(&thread_slp2, NULL, slp_tx_receive_ack, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp2, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp3
-    retVal = pthread_create(&thread_slp3, NULL, slp_tx_receive_nack, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp3, ..) returned value: %d\n",retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp4
-    retVal = pthread_create(&thread_slp4, NULL, slp_tx_send_poll, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp4, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp5
-    retVal = pthread_create(&thread_slp5, NULL, slp_rx_receive_app_data, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp5, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp6
-    retVal = pthread_create(&thread_slp6, NULL, slp_rx_send_ack, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp6, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp7
-    retVal = pthread_create(&thread_slp7, NULL, slp_rx_send_nack, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp7, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-
-    // create thread_slp8
-    retVal = pthread_create(&thread_slp8, NULL, slp_rx_receive_retrans, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp8, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-    // create thread_slp9
-    retVal = pthread_create(&thread_slp9, NULL, slp_rx_receive_poll, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp9, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-    // create thread_slp_d1
-    retVal = pthread_create(&thread_slp_d1, NULL, slp_tx_debug_get_time, NULL);
-    if(retVal)
-    {
-        fprintf(stderr,"Error - pthread_create(&thread_slp_d1, ..) returned value: %d\n", retVal);
-        exit(EXIT_FAILURE);
-    }
-#endif
-
     //wait untill threads are done with their routines before continuing with main thread
     pthread_join(thread_app1, NULL);
     pthread_join(thread_app2, NULL);
     pthread_join(thread_app3, NULL);
-    pthread_join(thread_app4, NULL); 
-    pthread_join(thread_slp1, NULL);
-    pthread_join(thread_slp2, NULL);
-    pthread_join(thread_slp3, NULL);
-    pthread_join(thread_slp4, NULL);
-    pthread_join(thread_slp5, NULL);
-    pthread_join(thread_slp6, NULL);
-    pthread_join(thread_slp7, NULL);
-    pthread_join(thread_slp8, NULL);
-    pthread_join(thread_slp9, NULL);
     exit(EXIT_SUCCESS);
 }
@@ -14,6 +14,7 @@ This can easily be ported to other Operating System environments, also into embe
 
 //Message types from APP to SLP
 #define SLP_APP_DATA_SEND_MSG           1 //actual APP data message to SLP to be sent to another device
+#define SLP_APP_URGENT_DATA_SEND_MSG    11 //same as above but in own queue, SLP-tx takes it ahead of bulk data backlog
 
 //Message types from SLP to APP
 #define SLP_APP_INFO_MSG                2 //4 kind of types
@@ -23,12 +24,13 @@ This can easily be ported to other Operating System environments, also into embe
 //Message types from SLP sender to SLP of another device
 #define SLP_INNER_APP_DATA_MSG          5 //SLP inner message for sending/receiving APP data
 #define SLP_RETRANS_MSG                 6 //same as above but not same thread because retransmitting case
-#define SLP_POLL_MSG                    7 //for recovery e.g. when last ACK was lost
+#define SLP_POLL_MSG                    7 //recovery of older SLP-tx when last ACK was lost, tail loss probe replaces it
 
 //Message types from SLP of another device to SLP sender
 #define SLP_ACK_MSG                     8 //SLP receiver acknowledges with this SLP_INNER_APP_DATA_MSG
 #define SLP_NACK_MSG                    9 //SLP receiver sends this when it observes that previous message(s) is/are missing,
                                           //causes retramsmission when received by sender of original SLP_INNER_APP_DATA_MSG or SLP_POLL_MSG
+#define SLP_FEC_MSG                     10 //XOR parity of a group of SLP_INNER_APP_DATA_MSGs, lets receiver rebuild one lost block
 
 //Keys of message queue ids
 #define SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID           1001
@@ -44,26 +46,31 @@ This can easily be ported to other Operating System environments, also into embe
 
 #define SLP_ACK_MSG_QUEUE_KEY_ID                     1008
 #define SLP_NACK_MSG_QUEUE_KEY_ID                    1009
+#define SLP_FEC_MSG_QUEUE_KEY_ID                     1010
+
+#define SLP_APP_URGENT_DATA_SEND_MSG_QUEUE_KEY_ID    1011
 
 //Message flag for msgget
 #define MSG_FLAG                                     0666
 
-//Function prototypes of APP pthreads
+//Function prototypes of APP pthreads, APP uses in-process API: slp_lib_if.h
+void AppInit(void);
 void* app_tx_send_data();
-void* app_tx_receive_info();
-void* app_tx_receive_state();
+void* app_tx_reap_completions();
 void* app_rx_receive_data();
 
 //Function prototypes of SLP sending device pthreads
+void SlpTxInit(void);
 void* slp_tx_receive_app_data();
+void* slp_tx_receive_urgent_app_data();
 void* slp_tx_receive_ack();
 void* slp_tx_receive_nack();
-void* slp_tx_send_poll();
-void* slp_tx_debug_get_time();
+void* slp_journal_commit();
 
 //Function prototypes of SLP receiving device pthreads
+void SlpRxInit(void);
 void* slp_rx_receive_app_data();
 void* slp_rx_send_ack();
-void* slp_rx_send_nack();
 void* slp_rx_receive_retrans();
 void* slp_rx_receive_poll();
+void* slp_rx_receive_fec();
@@ -12,27 +12,29 @@ https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
 This can easily be ported to other Operating System environments, also into embedded SW having some OS.
 */
 
-#define SLP_SIMULATED_TRANSFER_DELAY_US         100000
-#define SLP_SIM_CTRL_MSG_TRANS_DELAY_US         10000
-#define SLP_SIM_SMALL_CTRL_MSG_TRANS_DELAY_US   1000
-
-#define SLP_WAIT_FOR_POLL_SENDING_US            100
-
 #define SLP_MAX_NR_OF_BLOCKS                    (4*GEN_MEM_SIZE)
 #define SLP_FILL_TOLERANCE                      1024
-#define SLP_APP_WAIT_LIMIT                      (SLP_MAX_NR_OF_BLOCKS - SLP_FILL_TOLERANCE)
-#define SLP_APP_RESTART_LIMIT                   0
+#define SLP_URGENT_RESERVED_BLOCKS              64 //window room bulk data blocks leave to urgent ones
 
 //SLP message structures: slp_tx.c <=> slp_rx.c
 typedef struct SlpSubHeader_t {
     uint32_t    appDataLen;
-    uint32_t    fill;
+    uint32_t    flags;
+#define SLP_SUBHEADER_FLAG_COMPRESSED   1 //APP data is SlpCompressedData_t
+#define SLP_SUBHEADER_FLAG_RESYNC       2 //retransmission without APP data: receiver continues from seqNum
+#define SLP_SUBHEADER_FLAG_URGENT       4 //APP data block of SLP_PRIORITY_URGENT, its latencies are recorded apart
     uint64_t    seqNum;
+    uint64_t    appTag; //opaque to SLP, echoed to both APPs, 0 in short messages
+    uint32_t    txEpoch; //session of SLP-tx which seqNum belongs to, acks and nacks echo it
+    uint32_t    rxEpoch; //session of SLP-rx, 0 in SLP-tx messages before first resync
 } SlpSubHeader_t;
 
 typedef struct SlpHeader_t {
     uint32_t            crc;
-    uint32_t            fill;
+    uint32_t            integrityAlg; //algorithm of crc, 0 (legacy) when peer doesn't know this field
+#define SLP_INTEGRITY_ALG_LEGACY_CRC    0 //table based crcFast
+#define SLP_INTEGRITY_ALG_CRC32C        1 //CRC32C, SSE4.2/ARMv8 instruction when available
+#define SLP_INTEGRITY_ALG_NONE          2 //no check, trusted in-memory transports only
     SlpSubHeader_t      subHeader;
 } SlpHeader_t;
 
@@ -41,19 +43,151 @@ typedef struct SlpData_t {
     uint8_t     appData[SLP_APP_DATA_SIZE];
 } SlpData_t;
 
+//APP data of a compressed data block, appDataLen covers origLen and LZ4 block
+typedef struct SlpCompressedData_t {
+    uint32_t    origLen;
+    uint8_t     lz4Block[SLP_APP_DATA_SIZE - sizeof(uint32_t)];
+} SlpCompressedData_t;
+
 //SLP data messages: slp_tx.c => slp_rx.c
 typedef struct SlpInnerMsg_t {
     mtype_t     mtype;
     SlpData_t   data;
 } SlpInnerMsg_t;
 
+//SLP FEC parity messages: slp_tx.c => slp_rx.c
+typedef struct SlpFecHeader_t {
+    uint64_t    seqNumMask;     //bit n set: data block having seqNum subHeader.seqNum + n is covered
+    uint32_t    appDataLenXor;
+    uint32_t    flagsXor;
+    uint64_t    appTagXor;
+} SlpFecHeader_t;
+
+typedef struct SlpFecData_t {
+    SlpHeader_t     slpHeader;  //subHeader.seqNum is first seqNum of group, appDataLen is parity length
+    SlpFecHeader_t  fecHeader;
+    uint8_t         parity[SLP_APP_DATA_SIZE];
+} SlpFecData_t;
+
+typedef struct SlpFecMsg_t {
+    mtype_t         mtype;
+    SlpFecData_t    data;
+} SlpFecMsg_t;
+
 //SLP poll message: slp_tx.c => slp_rx.c
 //SLP ack and nack messages: slp_rx.c => slp_tx.c
 typedef struct SlpShortMsg_t {
     mtype_t             mtype;
     SlpHeader_t         slpHeader;
 //subHeader.appDataLen is in flag use
-#define SLP_FLAGS_RECEIVER_RESET    1
+#define SLP_FLAGS_RECEIVER_RESET    1 //receiver has resynchronised and this is its first ack or nack
+#define SLP_FLAGS_FEC_RECOVERED     2 //ack: data block was rebuilt from FEC parity
+#define SLP_FLAGS_RESYNC_REQUEST    4 //ack channel: receiver doesn't know txEpoch, asks where to continue
+#define SLP_FLAGS_SELECTIVE_ACK     8 //ack: data block saved beyond gap from seqNum to appTag, nothing is released
 } SlpShortMsg_t;
 
-int SlpTestRandOfThisSeqNum(uint64_t seqNum, int testCase);
+//SLP per-link settings: slp_gen.c
+#define SLP_INTEGRITY_ALG                       SLP_INTEGRITY_ALG_LEGACY_CRC
+#define SLP_COMPRESSION                         0
+#define SLP_FEC_GROUP_SIZE                      0 //data blocks per parity block, max 64
+#define SLP_FEC_MAX_GROUP_SIZE                  64
+#define SLP_APP_WAIT_LIMIT                      (SLP_MAX_NR_OF_BLOCKS - SLP_FILL_TOLERANCE)
+#define SLP_APP_RESTART_LIMIT                   0
+#define SLP_NACK_CHECK_DELAY_US                 1000
+#define SLP_NACK_CHECK_LIMIT                    3
+#define SLP_NACK_RETRANS_LIMIT                  10
+#define SLP_FAST_RETRANS_THRESHOLD              3
+#define SLP_PROBE_MIN_TIMEOUT_US                2000
+
+//runtime tunable, see gen_config_if.h
+typedef struct SlpLinkSettings_t {
+    uint32_t    integrityAlg; //used for sending, received messages are checked by their own algorithm
+    int         compression;  //compress sent data blocks, received ones are decompressed by their flag
+    uint32_t    fecGroupSize; //0: no FEC, must be same in both ends
+    uint32_t    appWaitLimit; //saved data blocks when APP is asked to wait, max SLP_MAX_NR_OF_BLOCKS
+    uint32_t    appRestartLimit; //saved data blocks when APP is asked to go on
+    int         secondaryAppWait; //APP waits also while receiver is reset
+    uint32_t    nackCheckDelayUs; //SLP-rx waits nackCheckDelayUs * nackCheckLimit for a gap to fill before NACK
+    uint32_t    nackCheckLimit;
+    uint32_t    nackRetransLimit; //NACKs of same seqNum before receiver is reset
+    uint32_t    fastRetransThreshold; //data blocks saved beyond a gap before SLP-tx resends it, 0: wait for NACK
+    uint32_t    probeMinTimeoutUs; //lower bound of two round trips without ACK progress before tail loss probe
+} SlpLinkSettings_t;
+
+extern SlpLinkSettings_t gSlpLinkSettings;
+
+void SlpSetIntegrity(SlpHeader_t* pHeader, int nBytes);
+int SlpIsIntegrityOk(const SlpHeader_t* pHeader, int nBytes);
+int SlpCompress(const uint8_t* pAppData, uint32_t appLen, SlpCompressedData_t* pCompressed, uint32_t* pLen);
+int SlpDecompress(SlpData_t* pData);
+uint32_t SlpNewEpoch(void);
+
+//SLP-tx window of saved data blocks, oldest unacknowledged seqNum to newest reserved one: slp_txwin.c
+//Producers reserve seqNums without lock, gSlpTxLock only guards release and retransmission copy
+#define SLP_TX_WIN_FLAG_REF             0x80000000 //window only: pAppDataPtr is SlpTxRef_t, never sent
+
+//saved data block referencing APP segments instead of a copy of them
+typedef struct SlpTxRef_t {
+    SlpReleaseCallback_t    pRelease;
+    void*                   pReleaseArg;
+    uint32_t                nrOfSegs;
+    SlpSegment_t            segs[];
+} SlpTxRef_t;
+
+typedef struct SlpTxReleased_t {
+    uint64_t    seqNum;
+    uint64_t    appTag;
+    void*       pAppDataPtr;
+    uint32_t    flags;
+} SlpTxReleased_t;
+
+uint64_t SlpTxWinReserve(void);
+uint64_t SlpTxWinReserveRange(uint32_t nr);
+void SlpTxWinPublish(uint64_t seqNum, void* pAppDataPtr, uint32_t appLen, uint32_t flags, uint64_t appTag);
+uint32_t SlpTxGather(uint8_t* pDst, const SlpSegment_t* pSegs, uint32_t nrOfSegs);
+int SlpTxWinRelease(uint64_t seqNum, SlpTxReleased_t* pReleased, int maxNr);
+int SlpTxWinCopy(uint64_t seqNum, uint8_t* pAppData, uint32_t* pAppLen, uint32_t* pFlags, uint64_t* pAppTag, int* pIsPoll);
+int SlpTxWinNrOfDataBlocks(uint64_t* pOldestSeqNum);
+void SlpTxWinRestart(uint64_t seqNum);
+
+
+//SLP-tx send journal of unacknowledged data blocks surviving a crash: slp_journal.c
+#define SLP_JOURNAL_FILE_NAME                   "slp.journal"
+#define SLP_JOURNAL_SIZE_MB                     64 //submit waits while it is full of unacknowledged data blocks
+#define SLP_JOURNAL_DURABILITY                  SLP_JOURNAL_DURABILITY_GROUP
+#define SLP_JOURNAL_GROUP_COMMIT_US             1000
+
+#define SLP_JOURNAL_DURABILITY_PROCESS          0 //page cache only, survives process crash but not power loss
+#define SLP_JOURNAL_DURABILITY_GROUP            1 //slp_journal_commit flushes every groupCommitUs
+#define SLP_JOURNAL_DURABILITY_SUBMIT           2 //flushed before slp_send returns, one flush per slp_sendv batch
+
+//runtime tunable, see gen_config_if.h
+typedef struct SlpJournalSettings_t {
+    int         enabled;
+    const char* pFileName;
+    uint32_t    sizeMb;
+    uint32_t    durability;
+    uint32_t    groupCommitUs;
+} SlpJournalSettings_t;
+
+extern SlpJournalSettings_t gSlpJournalSettings;
+
+uint64_t SlpJournalOpen(void);
+void SlpJournalRecover(void (*pRecovered)(uint64_t seqNum, uint64_t appTag, const uint8_t* pData, uint32_t len, uint32_t flags));
+void SlpJournalAppend(uint64_t seqNum, uint64_t appTag, const uint8_t* pData, uint32_t len, uint32_t flags);
+void SlpJournalRelease(uint64_t floorSeqNum);
+void SlpJournalCommit(void);
+
+
+//APP side of SLP-tx and SLP-rx: SysV queues when NULL, set by slp_open: slp_lib.c
+typedef struct SlpAppOps_t {
+    void    (*pDeliver)(uint64_t slpId, uint64_t appTag, const uint8_t* pAppData, uint32_t len, uint64_t timeNs);
+    void    (*pInfo)(const SlpInfoData_t* pInfo);
+    void    (*pComplete)(const SlpCompletion_t* pCompletion);
+    void    (*pState)(uint8_t state);
+} SlpAppOps_t;
+
+extern SlpAppOps_t gSlpAppOps;
+
+uint64_t SlpTxSubmit(const uint8_t* pAppData, uint32_t appLen, uint64_t appTag, uint32_t priority, uint64_t submitNs);
+uint64_t SlpTxSubmitv(const SlpIovec_t* pIov, uint32_t nr, uint64_t submitNs);
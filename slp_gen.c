@@ -0,0 +1,120 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include "common.h"
+#include "gen_if.h"
+#include "gen_stat_if.h"
+#include "util_if.h"
+#include "msg.h"
+#include "slp_if.h"
+#include "slp.h"
+
+SlpLinkSettings_t gSlpLinkSettings = {
+    .integrityAlg = SLP_INTEGRITY_ALG,
+    .compression = SLP_COMPRESSION,
+    .fecGroupSize = SLP_FEC_GROUP_SIZE,
+    .appWaitLimit = SLP_APP_WAIT_LIMIT,
+    .appRestartLimit = SLP_APP_RESTART_LIMIT,
+    .secondaryAppWait = 0,
+    .nackCheckDelayUs = SLP_NACK_CHECK_DELAY_US,
+    .nackCheckLimit = SLP_NACK_CHECK_LIMIT,
+    .nackRetransLimit = SLP_NACK_RETRANS_LIMIT,
+    .fastRetransThreshold = SLP_FAST_RETRANS_THRESHOLD,
+    .probeMinTimeoutUs = SLP_PROBE_MIN_TIMEOUT_US,
+};
+
+//nBytes is counted from the beginning of subHeader, APP data follows subHeader in SlpData_t
+void SlpSetIntegrity(SlpHeader_t* pHeader, int nBytes)
+{
+    const uint8_t* pData = (const uint8_t*) &pHeader->subHeader;
+
+    pHeader->integrityAlg = gSlpLinkSettings.integrityAlg;
+    switch (pHeader->integrityAlg) {
+    case SLP_INTEGRITY_ALG_CRC32C:
+        pHeader->crc = crc32cFast(pData, nBytes);
+        break;
+    case SLP_INTEGRITY_ALG_NONE:
+        pHeader->crc = 0;
+        break;
+    default:
+        pHeader->integrityAlg = SLP_INTEGRITY_ALG_LEGACY_CRC;
+        pHeader->crc = crcFast(pData, nBytes);
+        break;
+    }
+}
+
+int SlpIsIntegrityOk(const SlpHeader_t* pHeader, int nBytes)
+{
+    const uint8_t* pData = (const uint8_t*) &pHeader->subHeader;
+
+    switch (pHeader->integrityAlg) {
+    case SLP_INTEGRITY_ALG_LEGACY_CRC:
+        return pHeader->crc == crcFast(pData, nBytes);
+    case SLP_INTEGRITY_ALG_CRC32C:
+        return pHeader->crc == crc32cFast(pData, nBytes);
+    case SLP_INTEGRITY_ALG_NONE:
+        //integrityAlg isn't covered by crc: accept unchecked data only when this link is trusted too
+        return SLP_INTEGRITY_ALG_NONE == gSlpLinkSettings.integrityAlg;
+    default:
+        return 0;
+    }
+}
+
+//returns 1 and compressed data length when compression is on and data shrinks, otherwise APP data is sent raw
+int SlpCompress(const uint8_t* pAppData, uint32_t appLen, SlpCompressedData_t* pCompressed, uint32_t* pLen)
+{
+    int len;
+
+    if (!gSlpLinkSettings.compression || (sizeof(pCompressed->origLen) >= appLen)) return 0;
+
+    //accept only results shorter than original
+    len = lz4Compress(pAppData, appLen, pCompressed->lz4Block, appLen - sizeof(pCompressed->origLen) - 1);
+    if (0 == len) return 0;
+
+    pCompressed->origLen = appLen;
+    *pLen = sizeof(pCompressed->origLen) + len;
+    return 1;
+}
+
+//decompresses received data block in place, returns 0 if it is malformed
+int SlpDecompress(SlpData_t* pData)
+{
+    SlpCompressedData_t* pCompressed = (SlpCompressedData_t*) pData->appData;
+    uint8_t appData[SLP_APP_DATA_SIZE];
+    int len;
+
+    if (0 == (SLP_SUBHEADER_FLAG_COMPRESSED & pData->slpHeader.subHeader.flags)) return 1;
+    if ((sizeof(pCompressed->origLen) > pData->slpHeader.subHeader.appDataLen) ||
+        (SLP_APP_DATA_SIZE < pCompressed->origLen)) {
+        return 0;
+    }
+
+    len = lz4Decompress(pCompressed->lz4Block, pData->slpHeader.subHeader.appDataLen - sizeof(pCompressed->origLen),
+        appData, SLP_APP_DATA_SIZE);
+    if (len != (int) pCompressed->origLen) return 0;
+
+    memcpy(pData->appData, appData, len);
+    pData->slpHeader.subHeader.appDataLen = len;
+    pData->slpHeader.subHeader.flags &= ~SLP_SUBHEADER_FLAG_COMPRESSED;
+    return 1;
+}
+
+//session id of SLP-tx or SLP-rx, a restarted one gets another, never 0
+uint32_t SlpNewEpoch(void)
+{
+    uint64_t nowNs = GenStatNowNs();
+    uint32_t epoch = (uint32_t) (nowNs ^ (nowNs >> 32) ^ ((uint64_t) getpid() << 16));
+
+    return (0 == epoch) ? 1 : epoch;
+}
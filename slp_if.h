@@ -17,8 +17,10 @@ This can easily be ported to other Operating System environments, also into embe
 
 //Data structure for APP data messages: APP <=> SLP
 typedef struct SlpAppData_t {
-    uint64_t    genId; //appId or slpId depending on direction
+    uint64_t    genId; //appTag or slpId depending on direction
+    uint64_t    appTag; //SLP => APP: appTag given by sending APP
     uint32_t    len;
+    uint64_t    timeNs; //APP submit time or SLP-rx accept time depending on direction, for latency statistics
     uint8_t     appData[SLP_APP_DATA_SIZE];
 } SlpAppData_t;
 
@@ -30,14 +32,48 @@ typedef struct SlpAppMsg_t {
 //Data structure for INFO message: SLP => APP
 typedef struct SlpInfoData_t {
     uint8_t infoType;
-#define SLP_INFO_TYPE_APP_DATA_RECEIVED 1
 #define SLP_INFO_TYPE_DONE              2
 #define SLP_INFO_TYPE_DONE_AND_RX_RESET 3
 #define SLP_INFO_TYPE_RX_RESET          4
-    uint64_t appId;
+    uint64_t appTag; //given by APP with data block, 0 for RX_RESET
     uint64_t slpId; //SLP seqNum
 } SlpInfoData_t;
 
+//part of APP data block, e.g. header and body from different buffers
+typedef struct SlpSegment_t {
+    const uint8_t*  pData;
+    uint32_t        len;
+} SlpSegment_t;
+
+#define SLP_MAX_NR_OF_SEGMENTS          16
+
+//SLP doesn't need referenced segments of slpId anymore, APP may reuse them
+typedef void (*SlpReleaseCallback_t)(void* pArg, uint64_t slpId);
+
+//one APP data block of a vectored submit: APP => SLP, slp_lib_if.h
+typedef struct SlpIovec_t {
+    const uint8_t*          pAppData; //contiguous data when pSegs is NULL
+    uint32_t                len;
+    uint64_t                appTag; //opaque to SLP, comes back in completion and delivery
+    const SlpSegment_t*     pSegs; //data block is concatenation of nrOfSegs segments, len is ignored
+    uint32_t                nrOfSegs;
+    SlpReleaseCallback_t    pRelease; //NULL: data is copied, otherwise SLP references it until pRelease
+    void*                   pReleaseArg;
+    uint32_t                priority; //SLP_PRIORITY_BULK or SLP_PRIORITY_URGENT, same for all blocks of one submit
+#define SLP_PRIORITY_BULK       0
+#define SLP_PRIORITY_URGENT     1 //sent ahead of waiting bulk data blocks, even when APP is asked to wait
+#define SLP_NR_OF_PRIORITIES    2
+} SlpIovec_t;
+
+//completed range of consecutive slpIds having same infoType: SLP => APP by completion queue
+//appTags of a range are consecutive too, so APP using running appTags gets long ranges
+typedef struct SlpCompletion_t {
+    uint64_t    firstSlpId;
+    uint64_t    firstAppTag; //0 for SLP_INFO_TYPE_RX_RESET
+    uint32_t    nr;
+    uint8_t     infoType; //SLP_INFO_TYPE_DONE, SLP_INFO_TYPE_DONE_AND_RX_RESET or SLP_INFO_TYPE_RX_RESET
+} SlpCompletion_t;
+
 typedef struct SlpInfoMsg_t {
     mtype_t                     mtype;
     SlpInfoData_t               data;
@@ -47,7 +83,7 @@ typedef struct SlpInfoMsg_t {
 typedef struct SlpStateData_t {
     uint8_t                     state;
 #define SLP_ASKS_APP_TO_GO_ON 0
-#define SLP_ASKS_APP_TO_WAIT  1
+#define SLP_ASKS_APP_TO_WAIT  1 //pauses bulk data blocks, urgent ones may still be sent
 } SlpStateData_t;
 
 typedef struct SlpStateMsg_t {
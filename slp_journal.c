@@ -0,0 +1,349 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include "common.h"
+#include <stddef.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gen_if.h"
+#include "gen_stat_if.h"
+#include "util_if.h"
+#include "msg.h"
+#include "slp_if.h"
+#include "slp.h"
+
+/*
+Send journal: saved data blocks are appended to a memory mapped file used as a ring.
+Records are addressed by log position growing forever, file offset is position % file size.
+Space from the record of the oldest unacknowledged data block to the newest record is never
+overwritten, records before it are stale. After a crash the file is scanned for valid records
+and the data blocks not acknowledged according to them are handed back to SLP-tx.
+*/
+
+#define SLP_JOURNAL_MAGIC_DATA          0x444a4c53 //"SLJD"
+#define SLP_JOURNAL_MAGIC_ACK           0x414a4c53 //"SLJA"
+#define SLP_JOURNAL_ALIGN               8
+
+typedef struct SlpJournalRecord_t {
+    uint32_t    magic;
+    uint32_t    crc;            //crc32c from len to the end of APP data
+    uint32_t    len;            //APP data bytes following record header
+    uint32_t    flags;          //subHeader flags of saved data, e.g. compressed
+    uint64_t    pos;            //log position of this record
+    uint64_t    seqNum;
+    uint64_t    appTag;
+    uint64_t    floorSeqNum;    //oldest unacknowledged seqNum when record was written
+} SlpJournalRecord_t;
+
+typedef struct SlpJournalBlock_t {
+    uint64_t    journaled;      //seqNum + 1 when data block has a record
+    uint64_t    pos;
+} SlpJournalBlock_t;
+
+typedef struct SlpJournal_t {
+    pthread_mutex_t     lock;
+    int                 fd;
+    uint8_t*            pMap;
+    uint64_t            size;
+    uint64_t            head;           //log position of next record
+    uint64_t            tail;           //log position of oldest unacknowledged data record
+    uint64_t            syncedHead;     //records before it are on disk, changed only under commitLock
+    uint64_t            floorSeqNum;    //oldest unacknowledged seqNum
+    uint64_t            nextSeqNum;     //seqNum after newest journaled data block
+    SlpJournalBlock_t   blocks[SLP_MAX_NR_OF_BLOCKS]; //data block of seqNum in slot seqNum % SLP_MAX_NR_OF_BLOCKS
+} SlpJournal_t;
+
+SlpJournalSettings_t gSlpJournalSettings = {
+    .enabled = 0,
+    .pFileName = SLP_JOURNAL_FILE_NAME,
+    .sizeMb = SLP_JOURNAL_SIZE_MB,
+    .durability = SLP_JOURNAL_DURABILITY,
+    .groupCommitUs = SLP_JOURNAL_GROUP_COMMIT_US,
+};
+
+static SlpJournal_t sSlpJournal = {.lock = PTHREAD_MUTEX_INITIALIZER, .fd = -1};
+static pthread_mutex_t sSlpJournalCommitLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t SlpJournalRecordSize(uint32_t len)
+{
+    return (sizeof(SlpJournalRecord_t) + len + SLP_JOURNAL_ALIGN - 1) & ~(SLP_JOURNAL_ALIGN - 1);
+}
+
+static uint32_t SlpJournalCrc(const SlpJournalRecord_t* pRecord)
+{
+    size_t offset = offsetof(SlpJournalRecord_t, len);
+
+    return crc32cFast((const uint8_t*) pRecord + offset, sizeof(*pRecord) - offset + pRecord->len);
+}
+
+static SlpJournalBlock_t* SlpJournalBlock(uint64_t seqNum)
+{
+    return &sSlpJournal.blocks[seqNum & (SLP_MAX_NR_OF_BLOCKS - 1)];
+}
+
+//returns data or ack record at file offset, NULL if there is none or it is torn
+static const SlpJournalRecord_t* SlpJournalValidRecord(uint64_t offset)
+{
+    const SlpJournalRecord_t* pRecord = (const SlpJournalRecord_t*) (sSlpJournal.pMap + offset);
+
+    if ((offset + sizeof(*pRecord)) > sSlpJournal.size) return NULL;
+    if ((SLP_JOURNAL_MAGIC_DATA != pRecord->magic) && (SLP_JOURNAL_MAGIC_ACK != pRecord->magic)) return NULL;
+    if ((SLP_APP_DATA_SIZE < pRecord->len) || ((offset + SlpJournalRecordSize(pRecord->len)) > sSlpJournal.size)) return NULL;
+    if ((pRecord->pos % sSlpJournal.size) != offset) return NULL;
+    if (SlpJournalCrc(pRecord) != pRecord->crc) return NULL;
+    return pRecord;
+}
+
+//returns log position for a record of recordSize bytes, waits while space is in use,
+//sSlpJournal.lock is locked by caller, with noWait returns UINT64_MAX instead of waiting
+static uint64_t SlpJournalReserve(uint32_t recordSize, int noWait)
+{
+    uint64_t offset;
+    uint64_t padSize;
+    int waited = 0;
+
+    for (;;) {
+        //a record never wraps, rest of file is left unused
+        offset = sSlpJournal.head % sSlpJournal.size;
+        padSize = ((offset + recordSize) > sSlpJournal.size) ? (sSlpJournal.size - offset) : 0;
+        if ((sSlpJournal.head + padSize + recordSize - sSlpJournal.tail) <= sSlpJournal.size) break;
+        if (noWait) return UINT64_MAX;
+        if (!waited) {
+            waited = 1;
+            GEN_STAT_INC(GEN_STAT_SLP_TX_JOURNAL_FULL_WAITS);
+        }
+        pthread_mutex_unlock(&sSlpJournal.lock);
+        usleep(GEN_SMALL_THREAD_DELAY_US);
+        pthread_mutex_lock(&sSlpJournal.lock);
+    }
+    sSlpJournal.head += padSize + recordSize;
+    return sSlpJournal.head - recordSize;
+}
+
+static void SlpJournalWrite(uint64_t pos, uint32_t magic, const uint8_t* pData, uint32_t len, uint32_t flags, uint64_t seqNum, uint64_t appTag)
+{
+    SlpJournalRecord_t* pRecord = (SlpJournalRecord_t*) (sSlpJournal.pMap + pos % sSlpJournal.size);
+
+    pRecord->len = len;
+    pRecord->flags = flags;
+    pRecord->pos = pos;
+    pRecord->seqNum = seqNum;
+    pRecord->appTag = appTag;
+    pRecord->floorSeqNum = sSlpJournal.floorSeqNum;
+    if (0 < len) {
+        memcpy(pRecord + 1, pData, len);
+    }
+    pRecord->crc = SlpJournalCrc(pRecord);
+    pRecord->magic = magic;
+}
+
+/*
+Maps journal file, creates it if missing, and finds unacknowledged data blocks of previous run.
+Must be called before any SLP thread is started.
+Returns seqNum of the oldest recovered data block, or the one SLP-tx continues from if none.
+*/
+uint64_t SlpJournalOpen(void)
+{
+    const SlpJournalRecord_t* pRecord;
+    SlpJournalBlock_t* pBlock;
+    struct stat st;
+    uint64_t offset;
+    uint64_t floorSeqNum = 0;
+    uint64_t firstSeqNum;
+
+    sSlpJournal.size = (uint64_t) gSlpJournalSettings.sizeMb << 20;
+    if ((sSlpJournal.fd = open(gSlpJournalSettings.pFileName, O_RDWR | O_CREAT, 0644)) < 0) {
+        perror("journal open");
+        exit(1);
+    }
+    if (fstat(sSlpJournal.fd, &st) < 0) {
+        perror("journal fstat");
+        exit(1);
+    }
+
+    //file of another size would move records to other offsets, it is started from scratch
+    if ((uint64_t) st.st_size != sSlpJournal.size) {
+        if ((ftruncate(sSlpJournal.fd, 0) < 0) || (ftruncate(sSlpJournal.fd, sSlpJournal.size) < 0)) {
+            perror("journal ftruncate");
+            exit(1);
+        }
+    }
+    sSlpJournal.pMap = mmap(NULL, sSlpJournal.size, PROT_READ | PROT_WRITE, MAP_SHARED, sSlpJournal.fd, 0);
+    if (MAP_FAILED == sSlpJournal.pMap) {
+        perror("journal mmap");
+        exit(1);
+    }
+
+    //newest record tells where appending continues and the highest floor which data blocks are still needed
+    for (offset = 0; offset < sSlpJournal.size; ) {
+        pRecord = SlpJournalValidRecord(offset);
+        if (NULL == pRecord) {
+            offset += SLP_JOURNAL_ALIGN;
+            continue;
+        }
+        if (floorSeqNum < pRecord->floorSeqNum) floorSeqNum = pRecord->floorSeqNum;
+        if (sSlpJournal.head < (pRecord->pos + SlpJournalRecordSize(pRecord->len))) {
+            sSlpJournal.head = pRecord->pos + SlpJournalRecordSize(pRecord->len);
+        }
+        offset += SlpJournalRecordSize(pRecord->len);
+    }
+
+    //data records from the floor on, older ones are stale and newer ones than a window are corrupt
+    firstSeqNum = UINT64_MAX;
+    sSlpJournal.nextSeqNum = floorSeqNum;
+    sSlpJournal.tail = sSlpJournal.head;
+    for (offset = 0; offset < sSlpJournal.size; ) {
+        pRecord = SlpJournalValidRecord(offset);
+        if (NULL == pRecord) {
+            offset += SLP_JOURNAL_ALIGN;
+            continue;
+        }
+        offset += SlpJournalRecordSize(pRecord->len);
+        if ((SLP_JOURNAL_MAGIC_DATA != pRecord->magic) || (floorSeqNum > pRecord->seqNum) ||
+            (SLP_MAX_NR_OF_BLOCKS <= (pRecord->seqNum - floorSeqNum))) {
+            continue;
+        }
+        pBlock = SlpJournalBlock(pRecord->seqNum);
+        pBlock->journaled = pRecord->seqNum + 1;
+        pBlock->pos = pRecord->pos;
+        if (sSlpJournal.tail > pRecord->pos) sSlpJournal.tail = pRecord->pos;
+        if (firstSeqNum > pRecord->seqNum) firstSeqNum = pRecord->seqNum;
+        if (sSlpJournal.nextSeqNum <= pRecord->seqNum) sSlpJournal.nextSeqNum = pRecord->seqNum + 1;
+    }
+    sSlpJournal.floorSeqNum = floorSeqNum;
+    sSlpJournal.syncedHead = sSlpJournal.head;
+
+    pthread_mutex_lock(&gGenPrintLock);
+    printf("SlpJournalOpen: %s, floor seqNum %lu, unacknowledged data blocks up to seqNum %lu, head %lu, tail %lu\n",
+        gSlpJournalSettings.pFileName, floorSeqNum, sSlpJournal.nextSeqNum, sSlpJournal.head, sSlpJournal.tail);
+    pthread_mutex_unlock(&gGenPrintLock);
+    return (UINT64_MAX == firstSeqNum) ? floorSeqNum : firstSeqNum;
+}
+
+//hands recovered data blocks to pRecovered in seqNum order, seqNums without a record are skipped
+void SlpJournalRecover(void (*pRecovered)(uint64_t seqNum, uint64_t appTag, const uint8_t* pData, uint32_t len, uint32_t flags))
+{
+    const SlpJournalRecord_t* pRecord;
+    const SlpJournalBlock_t* pBlock;
+    uint64_t seqNum;
+
+    for (seqNum = sSlpJournal.floorSeqNum; seqNum < sSlpJournal.nextSeqNum; seqNum++) {
+        pBlock = SlpJournalBlock(seqNum);
+        if ((seqNum + 1) != pBlock->journaled) continue;
+        pRecord = (const SlpJournalRecord_t*) (sSlpJournal.pMap + pBlock->pos % sSlpJournal.size);
+        pRecovered(seqNum, pRecord->appTag, (const uint8_t*) (pRecord + 1), pRecord->len, pRecord->flags);
+        GEN_STAT_INC(GEN_STAT_SLP_TX_JOURNAL_RECOVERED_DATA_BLOCKS);
+    }
+}
+
+//appends data block in the form it is sent, waits while journal is full of unacknowledged ones
+void SlpJournalAppend(uint64_t seqNum, uint64_t appTag, const uint8_t* pData, uint32_t len, uint32_t flags)
+{
+    SlpJournalBlock_t* pBlock = SlpJournalBlock(seqNum);
+    uint64_t pos;
+
+    if (!gSlpJournalSettings.enabled) return;
+    pthread_mutex_lock(&sSlpJournal.lock);
+    pos = SlpJournalReserve(SlpJournalRecordSize(len), 0);
+    SlpJournalWrite(pos, SLP_JOURNAL_MAGIC_DATA, pData, len, flags, seqNum, appTag);
+    pBlock->journaled = seqNum + 1;
+    pBlock->pos = pos;
+    if (sSlpJournal.nextSeqNum <= seqNum) sSlpJournal.nextSeqNum = seqNum + 1;
+    pthread_mutex_unlock(&sSlpJournal.lock);
+}
+
+//data blocks before floorSeqNum are acknowledged, their space is reused
+void SlpJournalRelease(uint64_t floorSeqNum)
+{
+    const SlpJournalBlock_t* pBlock;
+    uint64_t seqNum;
+    uint64_t pos;
+
+    if (!gSlpJournalSettings.enabled) return;
+    pthread_mutex_lock(&sSlpJournal.lock);
+    if (floorSeqNum <= sSlpJournal.floorSeqNum) {
+        pthread_mutex_unlock(&sSlpJournal.lock);
+        return;
+    }
+    sSlpJournal.floorSeqNum = floorSeqNum;
+
+    //seqNums without a record are polls
+    sSlpJournal.tail = sSlpJournal.head;
+    for (seqNum = floorSeqNum; seqNum < sSlpJournal.nextSeqNum; seqNum++) {
+        pBlock = SlpJournalBlock(seqNum);
+        if ((seqNum + 1) == pBlock->journaled) {
+            sSlpJournal.tail = pBlock->pos;
+            break;
+        }
+    }
+
+    //without ack record recovery would resend acknowledged data blocks if no new one follows,
+    //it is skipped when journal is full
+    pos = SlpJournalReserve(SlpJournalRecordSize(0), 1);
+    if (UINT64_MAX != pos) {
+        SlpJournalWrite(pos, SLP_JOURNAL_MAGIC_ACK, NULL, 0, 0, floorSeqNum, 0);
+    }
+    pthread_mutex_unlock(&sSlpJournal.lock);
+}
+
+static void SlpJournalSync(uint64_t offset, uint64_t len)
+{
+    uint64_t pageMask = (uint64_t) sysconf(_SC_PAGESIZE) - 1;
+    uint64_t start = offset & ~pageMask;
+
+    if (msync(sSlpJournal.pMap + start, offset + len - start, MS_SYNC) < 0) {
+        perror("journal msync");
+        exit(1);
+    }
+}
+
+//writes records appended so far to disk, concurrent callers share one flush
+void SlpJournalCommit(void)
+{
+    uint64_t head;
+    uint64_t start;
+    uint64_t end;
+
+    if (!gSlpJournalSettings.enabled) return;
+    pthread_mutex_lock(&sSlpJournal.lock);
+    head = sSlpJournal.head;
+    pthread_mutex_unlock(&sSlpJournal.lock);
+
+    pthread_mutex_lock(&sSlpJournalCommitLock);
+    if (head > sSlpJournal.syncedHead) {
+        start = sSlpJournal.syncedHead % sSlpJournal.size;
+        end = head % sSlpJournal.size;
+        if ((head - sSlpJournal.syncedHead) >= sSlpJournal.size) {
+            SlpJournalSync(0, sSlpJournal.size);
+        } else if (start < end) {
+            SlpJournalSync(start, end - start);
+        } else {
+            SlpJournalSync(start, sSlpJournal.size - start);
+            if (0 < end) SlpJournalSync(0, end);
+        }
+        sSlpJournal.syncedHead = head;
+        GEN_STAT_INC(GEN_STAT_SLP_TX_JOURNAL_COMMITS);
+    }
+    pthread_mutex_unlock(&sSlpJournalCommitLock);
+}
+
+//group commit: records of all data blocks appended during one interval are written by one flush
+void* slp_journal_commit()
+{
+    for (;;) {
+        usleep(gSlpJournalSettings.groupCommitUs);
+        SlpJournalCommit();
+    }
+}
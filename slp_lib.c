@@ -0,0 +1,297 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include "common.h"
+#include "gen_if.h"
+#include "gen_stat_if.h"
+#include "msg.h"
+#include "slp_if.h"
+#include "slp_lib_if.h"
+#include "slp.h"
+
+typedef struct SlpLibDelivery_t {
+    uint64_t    slpId;
+    uint64_t    appTag;
+    uint64_t    timeNs;
+    uint32_t    len;
+    uint8_t     appData[SLP_APP_DATA_SIZE];
+} SlpLibDelivery_t;
+
+typedef struct SlpLibState_t {
+    pthread_mutex_t     lock;
+    pthread_cond_t      notEmptyCond;
+    pthread_cond_t      notFullCond;
+    pthread_cond_t      completionCond; //completion queue isn't empty or full anymore
+    int                 open;
+    int                 started;
+    SlpCallbacks_t      callbacks;
+    uint32_t            head; //next delivery to slp_recv
+    uint32_t            nr;
+    SlpLibDelivery_t    deliveries[SLP_LIB_RECV_QUEUE_SIZE];
+    uint32_t            completionHead;
+    uint32_t            nrOfCompletions;
+    SlpCompletion_t     completions[SLP_LIB_COMPLETION_QUEUE_SIZE];
+} SlpLibState_t;
+
+static SlpLibState_t sSlpLibState = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .notEmptyCond = PTHREAD_COND_INITIALIZER,
+    .notFullCond = PTHREAD_COND_INITIALIZER,
+    .completionCond = PTHREAD_COND_INITIALIZER,
+};
+
+SlpAppOps_t gSlpAppOps;
+
+//SLP-rx thread, under gSlpRxLock so deliveries stay in seqNum order,
+//waiting for slp_recv room holds it, NACK timer on gen_timer_run thread doesn't wait for it
+static void SlpLibDeliver(uint64_t slpId, uint64_t appTag, const uint8_t* pAppData, uint32_t len, uint64_t timeNs)
+{
+    SlpLibDelivery_t* pDelivery;
+
+    if (!sSlpLibState.open) return;
+    if (NULL != sSlpLibState.callbacks.pRecv) {
+        sSlpLibState.callbacks.pRecv(sSlpLibState.callbacks.pUser, slpId, appTag, pAppData, len, timeNs);
+        return;
+    }
+
+    pthread_mutex_lock(&sSlpLibState.lock);
+    while (sSlpLibState.open && (SLP_LIB_RECV_QUEUE_SIZE == sSlpLibState.nr)) {
+        pthread_cond_wait(&sSlpLibState.notFullCond, &sSlpLibState.lock);
+    }
+    if (sSlpLibState.open) {
+        pDelivery = &sSlpLibState.deliveries[(sSlpLibState.head + sSlpLibState.nr) % SLP_LIB_RECV_QUEUE_SIZE];
+        pDelivery->slpId = slpId;
+        pDelivery->appTag = appTag;
+        pDelivery->timeNs = timeNs;
+        pDelivery->len = len;
+        memcpy(pDelivery->appData, pAppData, len);
+        sSlpLibState.nr++;
+        pthread_cond_signal(&sSlpLibState.notEmptyCond);
+    }
+    pthread_mutex_unlock(&sSlpLibState.lock);
+}
+
+static void SlpLibInfo(const SlpInfoData_t* pInfo)
+{
+    if (sSlpLibState.open && (NULL != sSlpLibState.callbacks.pInfo)) {
+        sSlpLibState.callbacks.pInfo(sSlpLibState.callbacks.pUser, pInfo);
+    }
+}
+
+//SLP-tx thread, one call per range of an ACK
+static void SlpLibComplete(const SlpCompletion_t* pCompletion)
+{
+    SlpCompletion_t* pLast;
+    SlpInfoData_t info;
+    uint32_t i;
+
+    if (!sSlpLibState.open) return;
+    if (!sSlpLibState.callbacks.completionQueue) {
+        if (NULL == sSlpLibState.callbacks.pInfo) return;
+        info.infoType = pCompletion->infoType;
+        for (i = 0; i < pCompletion->nr; i++) {
+            info.slpId = pCompletion->firstSlpId + i;
+            info.appTag = (SLP_INFO_TYPE_RX_RESET == pCompletion->infoType) ? 0 : pCompletion->firstAppTag + i;
+            sSlpLibState.callbacks.pInfo(sSlpLibState.callbacks.pUser, &info);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&sSlpLibState.lock);
+    //range continuing a not yet reaped one needs no new record, e.g. ACKs of consecutive blocks
+    if (0 < sSlpLibState.nrOfCompletions) {
+        pLast = &sSlpLibState.completions[(sSlpLibState.completionHead + sSlpLibState.nrOfCompletions - 1) % SLP_LIB_COMPLETION_QUEUE_SIZE];
+        if ((pLast->infoType == pCompletion->infoType) && (pLast->firstSlpId + pLast->nr == pCompletion->firstSlpId) &&
+            (pLast->firstAppTag + pLast->nr == pCompletion->firstAppTag) && (UINT32_MAX - pLast->nr >= pCompletion->nr)) {
+            pLast->nr += pCompletion->nr;
+            pthread_mutex_unlock(&sSlpLibState.lock);
+            return;
+        }
+    }
+    while (sSlpLibState.open && (SLP_LIB_COMPLETION_QUEUE_SIZE == sSlpLibState.nrOfCompletions)) {
+        pthread_cond_wait(&sSlpLibState.completionCond, &sSlpLibState.lock);
+    }
+    if (sSlpLibState.open) {
+        sSlpLibState.completions[(sSlpLibState.completionHead + sSlpLibState.nrOfCompletions) % SLP_LIB_COMPLETION_QUEUE_SIZE] = *pCompletion;
+        sSlpLibState.nrOfCompletions++;
+        pthread_cond_broadcast(&sSlpLibState.completionCond);
+    }
+    pthread_mutex_unlock(&sSlpLibState.lock);
+}
+
+static void SlpLibState(uint8_t state)
+{
+    if (sSlpLibState.open && (NULL != sSlpLibState.callbacks.pState)) {
+        sSlpLibState.callbacks.pState(sSlpLibState.callbacks.pUser, state);
+    }
+}
+
+int slp_open(const SlpCallbacks_t* pCallbacks)
+{
+    pthread_mutex_lock(&sSlpLibState.lock);
+    if (sSlpLibState.open) {
+        pthread_mutex_unlock(&sSlpLibState.lock);
+        return -1;
+    }
+    if (NULL != pCallbacks) {
+        sSlpLibState.callbacks = *pCallbacks;
+    } else {
+        memset(&sSlpLibState.callbacks, 0, sizeof(sSlpLibState.callbacks));
+    }
+    sSlpLibState.head = 0;
+    sSlpLibState.nr = 0;
+    sSlpLibState.completionHead = 0;
+    sSlpLibState.nrOfCompletions = 0;
+    sSlpLibState.open = 1;
+    pthread_mutex_unlock(&sSlpLibState.lock);
+
+    //threads are never stopped, a reopened library goes on with them
+    if (!sSlpLibState.started) {
+        sSlpLibState.started = 1;
+        gSlpAppOps.pDeliver = SlpLibDeliver;
+        gSlpAppOps.pInfo = SlpLibInfo;
+        gSlpAppOps.pComplete = SlpLibComplete;
+        gSlpAppOps.pState = SlpLibState;
+        GenInit();
+        GenStartSlpThreads(0);
+    }
+    return 0;
+}
+
+static int SlpLibSend(const uint8_t* pAppData, uint32_t len, uint64_t appTag, uint32_t priority, uint64_t* pSlpId)
+{
+    uint64_t slpId;
+
+    if (!sSlpLibState.open || (0 == len) || (SLP_APP_DATA_SIZE < len)) return -1;
+
+    slpId = SlpTxSubmit(pAppData, len, appTag, priority, GenStatNowNs());
+    if (NULL != pSlpId) *pSlpId = slpId;
+    return 0;
+}
+
+int slp_send(const uint8_t* pAppData, uint32_t len, uint64_t appTag, uint64_t* pSlpId)
+{
+    return SlpLibSend(pAppData, len, appTag, SLP_PRIORITY_BULK, pSlpId);
+}
+
+int slp_send_urgent(const uint8_t* pAppData, uint32_t len, uint64_t appTag, uint64_t* pSlpId)
+{
+    return SlpLibSend(pAppData, len, appTag, SLP_PRIORITY_URGENT, pSlpId);
+}
+
+//contiguous data or 1..SLP_MAX_NR_OF_SEGMENTS segments of 1..SLP_APP_DATA_SIZE bytes in total
+static int SlpLibIovecValid(const SlpIovec_t* pIov)
+{
+    uint32_t len = 0;
+    uint32_t i;
+
+    if (NULL == pIov->pSegs) return (0 < pIov->len) && (SLP_APP_DATA_SIZE >= pIov->len);
+    if ((0 == pIov->nrOfSegs) || (SLP_MAX_NR_OF_SEGMENTS < pIov->nrOfSegs)) return 0;
+    for (i = 0; i < pIov->nrOfSegs; i++) {
+        if (SLP_APP_DATA_SIZE - len < pIov->pSegs[i].len) return 0;
+        len += pIov->pSegs[i].len;
+    }
+    return 0 < len;
+}
+
+int slp_send_sg(const SlpSegment_t* pSegs, uint32_t nrOfSegs, uint64_t appTag,
+    SlpReleaseCallback_t pRelease, void* pReleaseArg, uint64_t* pSlpId)
+{
+    SlpIovec_t iov = {.pSegs = pSegs, .nrOfSegs = nrOfSegs, .appTag = appTag,
+        .pRelease = pRelease, .pReleaseArg = pReleaseArg};
+
+    return (slp_sendv(&iov, 1, pSlpId) < 0) ? -1 : 0;
+}
+
+int slp_sendv(const SlpIovec_t* pIov, int nr, uint64_t* pFirstSlpId)
+{
+    uint64_t firstSlpId;
+    int i;
+
+    if (!sSlpLibState.open || (0 >= nr) || (SLP_LIB_MAX_SENDV_NR < nr)) return -1;
+    if (SLP_NR_OF_PRIORITIES <= pIov[0].priority) return -1;
+    for (i = 0; i < nr; i++) {
+        if (!SlpLibIovecValid(&pIov[i]) || (pIov[i].priority != pIov[0].priority)) return -1;
+    }
+
+    firstSlpId = SlpTxSubmitv(pIov, nr, GenStatNowNs());
+    if (NULL != pFirstSlpId) *pFirstSlpId = firstSlpId;
+    return nr;
+}
+
+int slp_recv(uint8_t* pAppData, uint32_t size, uint64_t* pSlpId, uint64_t* pAppTag, uint64_t* pTimeNs)
+{
+    SlpLibDelivery_t* pDelivery;
+    int len = -1;
+
+    pthread_mutex_lock(&sSlpLibState.lock);
+    while (sSlpLibState.open && (0 == sSlpLibState.nr)) {
+        pthread_cond_wait(&sSlpLibState.notEmptyCond, &sSlpLibState.lock);
+    }
+    if (0 < sSlpLibState.nr) {
+        pDelivery = &sSlpLibState.deliveries[sSlpLibState.head];
+        len = pDelivery->len;
+
+        //SLP-rx has acknowledged the block already, so it stays queued until APP has room for it
+        if (size < pDelivery->len) {
+            pthread_mutex_unlock(&sSlpLibState.lock);
+            return len;
+        }
+        memcpy(pAppData, pDelivery->appData, len);
+        if (NULL != pSlpId) *pSlpId = pDelivery->slpId;
+        if (NULL != pAppTag) *pAppTag = pDelivery->appTag;
+        if (NULL != pTimeNs) *pTimeNs = pDelivery->timeNs;
+        sSlpLibState.head = (sSlpLibState.head + 1) % SLP_LIB_RECV_QUEUE_SIZE;
+        sSlpLibState.nr--;
+        pthread_cond_signal(&sSlpLibState.notFullCond);
+    }
+    pthread_mutex_unlock(&sSlpLibState.lock);
+    return len;
+}
+
+int slp_reap_completions(SlpCompletion_t* pCompletions, int maxNr, int wait)
+{
+    int nr = 0;
+
+    pthread_mutex_lock(&sSlpLibState.lock);
+    while (wait && sSlpLibState.open && (0 == sSlpLibState.nrOfCompletions)) {
+        pthread_cond_wait(&sSlpLibState.completionCond, &sSlpLibState.lock);
+    }
+    if (!sSlpLibState.open) {
+        pthread_mutex_unlock(&sSlpLibState.lock);
+        return -1;
+    }
+    while ((nr < maxNr) && (0 < sSlpLibState.nrOfCompletions)) {
+        pCompletions[nr++] = sSlpLibState.completions[sSlpLibState.completionHead];
+        sSlpLibState.completionHead = (sSlpLibState.completionHead + 1) % SLP_LIB_COMPLETION_QUEUE_SIZE;
+        sSlpLibState.nrOfCompletions--;
+    }
+    if (0 < nr) {
+        pthread_cond_broadcast(&sSlpLibState.completionCond);
+    }
+    pthread_mutex_unlock(&sSlpLibState.lock);
+    return nr;
+}
+
+void slp_close(void)
+{
+    pthread_mutex_lock(&sSlpLibState.lock);
+    sSlpLibState.open = 0;
+    sSlpLibState.nr = 0;
+    sSlpLibState.nrOfCompletions = 0;
+    pthread_cond_broadcast(&sSlpLibState.notEmptyCond);
+    pthread_cond_broadcast(&sSlpLibState.notFullCond);
+    pthread_cond_broadcast(&sSlpLibState.completionCond);
+    pthread_mutex_unlock(&sSlpLibState.lock);
+}
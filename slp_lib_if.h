@@ -0,0 +1,72 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+/*
+ * In-process SLP API of libslp.a and libslp.so: APP hands data blocks directly to SLP-tx and
+ * gets deliveries of SLP-rx by callback or slp_recv, no SysV queues or copies between APP and SLP.
+ * Settings are loaded before slp_open, e.g. by GenConfigLoad: gen_config_if.h.
+ * Callbacks run in SLP threads without SLP locks held and should return quickly, they may call slp_send.
+ * APP may keep its outstanding blocks by appTag in inflightTable of util_if.h, O(1) per block.
+ * Prerequisites: common.h, gen_if.h and slp_if.h.
+ */
+#define SLP_LIB_RECV_QUEUE_SIZE         64 //deliveries waiting for slp_recv, SLP-rx waits when full
+#define SLP_LIB_MAX_SENDV_NR            64 //data blocks of one slp_sendv
+#define SLP_LIB_COMPLETION_QUEUE_SIZE   256 //completion ranges waiting for slp_reap_completions, SLP-tx waits when full
+
+typedef void (*SlpRecvCallback_t)(void* pUser, uint64_t slpId, uint64_t appTag, const uint8_t* pAppData, uint32_t len, uint64_t timeNs);
+typedef void (*SlpInfoCallback_t)(void* pUser, const SlpInfoData_t* pInfo);
+typedef void (*SlpStateCallback_t)(void* pUser, uint8_t state);
+
+typedef struct SlpCallbacks_t {
+    SlpRecvCallback_t   pRecv; //NULL: deliveries are queued for slp_recv
+    SlpInfoCallback_t   pInfo; //NULL: infos are dropped
+    SlpStateCallback_t  pState; //NULL: SLP_ASKS_APP_TO_WAIT/GO_ON are dropped
+    void*               pUser;
+    int                 completionQueue; //1: DONE, DONE_AND_RX_RESET and RX_RESET are reaped instead of pInfo
+} SlpCallbacks_t;
+
+//returns -1 if already open, SLP threads are started by the first open
+int slp_open(const SlpCallbacks_t* pCallbacks);
+
+//returns -1 if not open or len is 0 or over SLP_APP_DATA_SIZE
+//appTag is opaque to SLP, it comes back in completion of the block and with its delivery to receiving APP
+int slp_send(const uint8_t* pAppData, uint32_t len, uint64_t appTag, uint64_t* pSlpId);
+
+//as slp_send but SLP_PRIORITY_URGENT: SLP-tx takes the block ahead of bulk ones waiting for their turn or window room,
+//a part of window is reserved for urgent blocks and they may be sent while APP is asked to wait
+//slpIds stay in submit order, so an urgent block is still delivered after bulk blocks submitted before it
+int slp_send_urgent(const uint8_t* pAppData, uint32_t len, uint64_t appTag, uint64_t* pSlpId);
+
+//data block from segments, e.g. header and body, gathered once into the outgoing message
+//with pRelease set the segments are lent: SLP keeps references for retransmission and calls
+//pRelease(pReleaseArg, slpId) once the block is acked or dropped, APP must not change them before
+//returns -1 if not open or nrOfSegs is 0 or over SLP_MAX_NR_OF_SEGMENTS or total len is invalid
+int slp_send_sg(const SlpSegment_t* pSegs, uint32_t nrOfSegs, uint64_t appTag,
+    SlpReleaseCallback_t pRelease, void* pReleaseArg, uint64_t* pSlpId);
+
+//data blocks get consecutive slpIds from *pFirstSlpId on, by one SLP-tx lock for all of them
+//each block is contiguous or segmented as for slp_send_sg, all blocks have the same priority
+//returns nr of blocks or -1 if not open, nr is 0 or over SLP_LIB_MAX_SENDV_NR or a block is invalid
+int slp_sendv(const SlpIovec_t* pIov, int nr, uint64_t* pFirstSlpId);
+
+//waits for next delivery, returns its length or -1 when closed
+//length over size: nothing is copied and the delivery stays queued, APP calls again with a buffer of that length
+int slp_recv(uint8_t* pAppData, uint32_t size, uint64_t* pSlpId, uint64_t* pAppTag, uint64_t* pTimeNs);
+
+//completion queue: copies at most maxNr oldest ranges, blocks of consecutive slpIds and appTags are in one range
+//wait: blocks until at least one range is available, returns nr of ranges or -1 when closed
+int slp_reap_completions(SlpCompletion_t* pCompletions, int maxNr, int wait);
+
+//stops callbacks and wakes slp_recv and slp_reap_completions, SLP keeps sending blocks in flight until process exits
+void slp_close(void);
@@ -16,6 +16,10 @@ This can be ported easily to other Operating System environments, also into embe
 
 #include "common.h"
 #include "gen_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
+#include "gen_link_if.h"
+#include "gen_timer_if.h"
 #include "util_if.h"
 #include "msg.h"
 #include "slp_if.h"
@@ -23,13 +27,16 @@ This can be ported easily to other Operating System environments, also into embe
 
 pthread_mutex_t gSlpRxLock;
 
-#define SLP_NACK_CHECK_DELAY_US         1000
-#define SLP_NACK_CHECK_LIMIT            10
-#define SLP_NACK_RETRANS_LIMIT          10
+#define SLP_FEC_NR_OF_GROUPS            16
+#define SLP_ACK_BATCH_SIZE              256
+#define SLP_NACK_TOLERANCE_US           (gSlpLinkSettings.nackCheckDelayUs * gSlpLinkSettings.nackCheckLimit)
 
 typedef struct SlpRxBlockData_t {
     void*       pAppDataPtr;
     uint32_t    appLen;
+    uint32_t    ackFlags;
+    uint32_t    flags; //subheader flags of data block, compression already undone
+    uint64_t    appTag;
 }  SlpRxBlockData_t;
 
 
@@ -39,96 +46,106 @@ typedef struct SlpRxState_t {
     int                 nrOfWrongOrderReceivedDataBlocks;
     uint64_t            waitSeqNum;
     uint64_t            lastSentNackSeqNum;
-    int                 lastSentNackSeqNumClearCount;
+    uint32_t            lastSentNackSeqNumClearCount;
+    int                 nackTimerArmed; //gap at waitSeqNum is being waited for to fill
+    uint64_t            selectiveAckGapSeqNum; //gap which selective acks were latest sent for
+    uint32_t            nrOfSelectiveAcks;
+    uint32_t            epoch; //session of this SLP-rx
+    uint32_t            txEpoch; //session of SLP-tx which waitSeqNum belongs to, 0 before first resync
+    uint32_t            pendingEpoch; //session whose data blocks are saved in wrong order until resync, 0 if none
+    int                 reset; //resynchronised, next ack or nack tells it to SLP-tx
+    uint64_t            resyncRequestNs; //latest resync request, they are sent once per round trip
 } SlpRxState_t;
 
 static SlpRxState_t sSlpRxState;
 
+//XOR of received data blocks and parity of one FEC group, protected by gSlpRxLock
+typedef struct SlpRxFecGroup_t {
+    int         inUse;
+    int         parityReceived;
+    int         recovered;
+    uint64_t    firstSeqNum;
+    uint64_t    parityMask;
+    uint64_t    rxMask;
+    uint32_t    appDataLenXor;
+    uint32_t    flagsXor;
+    uint64_t    appTagXor;
+    uint8_t     appDataXor[SLP_APP_DATA_SIZE];
+} SlpRxFecGroup_t;
+
+static SlpRxFecGroup_t sSlpRxFecGroups[SLP_FEC_NR_OF_GROUPS];
+
 typedef struct SlpDataToSendAck_t
 {
     uint64_t seqNum;
+    uint32_t flags;
+    uint32_t txEpoch; //session of seqNum, SLP-tx may have changed before ack is sent
+    uint64_t gapEndSeqNum; //selective ack: first saved seqNum after gap, sent as appTag
 } SlpDataToSendAck_t;
 
-static SlpDataToSendAck_t sSlpDataToSendAck[SLP_MAX_NR_OF_BLOCKS];
-static int sSlpSendAckReadIndex;
-static int sSlpSendAckWriteIndex;
-
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-typedef struct SlpRxDebug_t {
-    uint32_t nrOfReceivedDataBlocks;
-    uint32_t nrOfAcceptedDataBlocks;
-    uint32_t nrOfSentAcks;
-    uint32_t nrOfSentNacks;
-    uint32_t nrOfReceivedRetransmittedDataBlocks;
-    uint32_t nrOfReceivedRetransmittedPolls;
-    uint32_t nrOfAcceptedRetransmittedDataBlocks;
-    uint32_t nrOfAcceptedRetransmittedPolls;
-    uint32_t nrOfReceivedPolls;
-    uint32_t nrOfDroppedSuccessiveDataBlocks;
-    uint32_t nrOfDroppedRandDataBlocks;
-    uint32_t nrOfDroppedRetransmittedDataBlocks;
-    uint32_t nrOfDroppedRetransmittedPolls;
-    uint32_t nrOfDroppedPolls;
-    uint32_t nrOfDataBlocksForwardedToApp;
-} SlpRxDebug_t;
-
-static SlpRxDebug_t sSlpRxDebug;
-#endif
+//written by data, retransmission, poll and FEC receiving, read by slp_rx_send_ack
+static MpscQueue_t sSlpSendAckQueue;
 
 static int sSlpRxDebugPrint;
 
+static GenTimer_t sSlpNackTimer;
+
+static void SlpNackTimerExpired(void* pArg);
+
+void SlpRxInit(void)
+{
+    mpscQueueInit(&sSlpSendAckQueue, SLP_MAX_NR_OF_BLOCKS, sizeof(SlpDataToSendAck_t));
+    sSlpRxState.epoch = SlpNewEpoch();
+    GenTimerSetup(&sSlpNackTimer, SlpNackTimerExpired, NULL);
+}
+
 void* slp_rx_send_ack()
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
     SlpShortMsg_t sbuf;
+    SlpDataToSendAck_t acks[SLP_ACK_BATCH_SIZE];
+    int nr;
+    int i;
 
-    for (;;) {
-        usleep(GEN_THREAD_DELAY_US);
-        while (sSlpSendAckReadIndex != sSlpSendAckWriteIndex) {
-            usleep(GEN_THREAD_DELAY_US);
+    //get the message queue id for the key with value SLP_ACK_MSG_QUEUE_KEY_ID
+    key = SLP_ACK_MSG_QUEUE_KEY_ID;
 
-            //get the message queue id for the key with value SLP_ACK_MSG_QUEUE_KEY_ID
-            key = SLP_ACK_MSG_QUEUE_KEY_ID;
+    for (;;) {
+        //sleep until there is something to acknowledge, then drain all of it
+        nr = mpscQueueWaitBatch(&sSlpSendAckQueue, acks, SLP_ACK_BATCH_SIZE);
 
-            if ((msqid = msgget(key, msgflg)) < 0) {
-                perror("msgget");
-                exit(1);
-            }
+        if ((msqid = msgget(key, msgflg)) < 0) {
+            perror("msgget");
+            exit(1);
+        }
 
-            //send message type SLP_ACK_MSG 
+        for (i = 0; i < nr; i++) {
+            //send message type SLP_ACK_MSG
             sbuf.mtype = SLP_ACK_MSG;
 
             //set ACK data, appDataLen is in flag use
-            if (0 == sSlpRxState.waitSeqNum) {
-                sbuf.slpHeader.subHeader.appDataLen = SLP_FLAGS_RECEIVER_RESET;
-            } else {
-                sbuf.slpHeader.subHeader.appDataLen = 0;
-            }
-            sbuf.slpHeader.subHeader.fill = 0; //not used
+            sbuf.slpHeader.subHeader.appDataLen = acks[i].flags;
+            sbuf.slpHeader.subHeader.flags = 0;
+            sbuf.slpHeader.subHeader.seqNum = acks[i].seqNum;
+            sbuf.slpHeader.subHeader.appTag = acks[i].gapEndSeqNum;
+            sbuf.slpHeader.subHeader.txEpoch = acks[i].txEpoch;
+            sbuf.slpHeader.subHeader.rxEpoch = sSlpRxState.epoch;
 
-            sSlpSendAckReadIndex++;
-            sSlpSendAckReadIndex &= (SLP_MAX_NR_OF_BLOCKS - 1);
-            sbuf.slpHeader.subHeader.seqNum = sSlpDataToSendAck[sSlpSendAckReadIndex].seqNum;
-
-            sbuf.slpHeader.crc =  crcFast(((const uint8_t*) &sbuf.slpHeader.subHeader),
-                sizeof(sbuf.slpHeader.subHeader));
-            sbuf.slpHeader.fill = 0; //not used
+            SlpSetIntegrity(&sbuf.slpHeader, sizeof(sbuf.slpHeader.subHeader));
 
             if (gGenDebugPrint) {
                 pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_rx_send_ack: seqNum %lu, write index %d, read index %d\n",
-                    sbuf.slpHeader.subHeader.seqNum, sSlpSendAckWriteIndex, sSlpSendAckReadIndex);
+                printf("slp_rx_send_ack: seqNum %lu, %d/%d of batch\n",
+                    sbuf.slpHeader.subHeader.seqNum, i + 1, nr);
                 pthread_mutex_unlock(&gGenPrintLock);
             }
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfSentAcks++;
-#endif
+            GEN_STAT_INC(GEN_STAT_SLP_RX_SENT_ACKS);
 
             //send 
-            if (msgsnd(msqid, &sbuf, sizeof(sbuf.slpHeader), 0) < 0) {
+            if (GenLinkSend(GEN_LINK_ACK, sbuf.slpHeader.subHeader.seqNum, msqid, &sbuf, sizeof(sbuf.slpHeader)) < 0) {
                 perror("msgsnd");
                 exit(1);
             }
@@ -154,11 +171,48 @@ static void SlpRemoveInWrongOrderReceivedDataBlock(int pos)
             sSlpRxState.wrongOrderSeqNums[i] =  0;
             sSlpRxState.wrongOrderBlockData[i].pAppDataPtr = NULL;
             sSlpRxState.wrongOrderBlockData[i].appLen = 0;
+            sSlpRxState.wrongOrderBlockData[i].ackFlags = 0;
         }
     }
 
     //Decrement nr in wrong order received blocks
     sSlpRxState.nrOfWrongOrderReceivedDataBlocks--;
+
+    //gap is filled
+    if ((0 == sSlpRxState.nrOfWrongOrderReceivedDataBlocks) && sSlpRxState.nackTimerArmed) {
+        sSlpRxState.nackTimerArmed = 0;
+        GenTimerCancel(&sSlpNackTimer);
+    }
+}
+
+//data block saved beyond waitSeqNum: NACK is sent if gap isn't filled within reorder tolerance,
+//nothing is missing before SLP-tx has told where to continue, gSlpRxLock is locked by caller
+static void SlpGapDetected(void)
+{
+    if (sSlpRxState.nackTimerArmed || (0 != sSlpRxState.pendingEpoch)) return;
+    sSlpRxState.nackTimerArmed = 1;
+    GenTimerArm(&sSlpNackTimer, SLP_NACK_TOLERANCE_US);
+}
+
+//tells SLP-tx that a data block arrived beyond gap from waitSeqNum to gapEndSeqNum, SLP-tx resends gap
+//after fastRetransThreshold of these without waiting for NACK, gSlpRxLock is locked by caller
+static void SlpSendSelectiveAck(uint64_t gapEndSeqNum)
+{
+    SlpDataToSendAck_t ack = {sSlpRxState.waitSeqNum, SLP_FLAGS_SELECTIVE_ACK, sSlpRxState.txEpoch, gapEndSeqNum};
+
+    if ((0 == gSlpLinkSettings.fastRetransThreshold) || (0 != sSlpRxState.pendingEpoch)) return;
+    if (!mpscQueuePush(&sSlpSendAckQueue, &ack)) return;
+    GEN_STAT_INC(GEN_STAT_SLP_RX_SENT_SELECTIVE_ACKS);
+
+    //resend is on its way, NACK is sent only if it doesn't arrive within reorder tolerance either
+    if (sSlpRxState.selectiveAckGapSeqNum != sSlpRxState.waitSeqNum) {
+        sSlpRxState.selectiveAckGapSeqNum = sSlpRxState.waitSeqNum;
+        sSlpRxState.nrOfSelectiveAcks = 0;
+    }
+    sSlpRxState.nrOfSelectiveAcks++;
+    if ((gSlpLinkSettings.fastRetransThreshold == sSlpRxState.nrOfSelectiveAcks) && sSlpRxState.nackTimerArmed) {
+        GenTimerArm(&sSlpNackTimer, SLP_NACK_TOLERANCE_US);
+    }
 }
 
 static void SlpWrongOrderCleanup(void)
@@ -177,180 +231,228 @@ static void SlpWrongOrderCleanup(void)
     }
 }
 
-static int SlpIsNackToBeSent(uint64_t* pSeqNum)
-{
-    int nr;
-
-    pthread_mutex_lock(&gSlpRxLock);
-    SlpWrongOrderCleanup();
-    nr = sSlpRxState.nrOfWrongOrderReceivedDataBlocks;
-    *pSeqNum = sSlpRxState.waitSeqNum;
-    pthread_mutex_unlock(&gSlpRxLock);
-    if (0 < nr) return 1;
-    return 0;
-}
-
-int SlpNackShouldBeSent(uint64_t* pSeqNum)
-{
-    int count;
-
-    for (count = 1; count <= SLP_NACK_CHECK_LIMIT; count++) {
-        usleep(SLP_NACK_CHECK_DELAY_US);
-        if (!SlpIsNackToBeSent(pSeqNum)) return 0;
-    }
-    return 1;
-}
-
-void* slp_rx_send_nack()
+//gap has lasted over reorder tolerance, NACK of same seqNum is repeated after nackRetransLimit tolerances
+static void SlpSendNack(uint64_t seqNum)
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
     SlpShortMsg_t sbuf;
 
-    for (;;) {
-        uint64_t seqNum;
+    sSlpRxState.lastSentNackSeqNumClearCount++;
+    if (gSlpLinkSettings.nackRetransLimit <= sSlpRxState.lastSentNackSeqNumClearCount) {
+        sSlpRxState.lastSentNackSeqNum = GEN_ID_INVALID;
+        sSlpRxState.lastSentNackSeqNumClearCount = 0;
+    }
+    if (sSlpRxState.lastSentNackSeqNum == seqNum) return;
+    sSlpRxState.lastSentNackSeqNum = seqNum;
 
-        if (SlpNackShouldBeSent(&seqNum)) {
-            sSlpRxState.lastSentNackSeqNumClearCount++;
-            if (SLP_NACK_RETRANS_LIMIT <= sSlpRxState.lastSentNackSeqNumClearCount) {
-                sSlpRxState.lastSentNackSeqNum = GEN_ID_INVALID;
-                sSlpRxState.lastSentNackSeqNumClearCount = 0;
-            }
-            if (sSlpRxState.lastSentNackSeqNum == seqNum) continue;
-            sSlpRxState.lastSentNackSeqNum = seqNum;
+    //get the message queue id for the key with value SLP_NACK_MSG_QUEUE_KEY_ID
+    key = SLP_NACK_MSG_QUEUE_KEY_ID;
 
-            //get the message queue id for the key with value SLP_NACK_MSG_QUEUE_KEY_ID
-            key = SLP_NACK_MSG_QUEUE_KEY_ID;
+    if ((msqid = msgget(key, msgflg)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
 
-            if ((msqid = msgget(key, msgflg)) < 0) {
-                perror("msgget");
-                exit(1);
-            }
+    //send message type SLP_NACK_MSG
+    sbuf.mtype = SLP_NACK_MSG;
 
-            //send message type SLP_NACK_MSG
-            sbuf.mtype = SLP_NACK_MSG;
+    //set ACK data, appDataLen is in flag use
+    if (sSlpRxState.reset) {
+        sbuf.slpHeader.subHeader.appDataLen = SLP_FLAGS_RECEIVER_RESET;
+    } else {
+        sbuf.slpHeader.subHeader.appDataLen = 0;
+    }
+    sbuf.slpHeader.subHeader.flags = 0;
+    sbuf.slpHeader.subHeader.seqNum = seqNum;
+    sbuf.slpHeader.subHeader.appTag = 0;
+    sbuf.slpHeader.subHeader.txEpoch = sSlpRxState.txEpoch;
+    sbuf.slpHeader.subHeader.rxEpoch = sSlpRxState.epoch;
+    SlpSetIntegrity(&sbuf.slpHeader, sizeof(sbuf.slpHeader.subHeader));
 
-            //set ACK data, appDataLen is in flag use
-            if (0 == sSlpRxState.waitSeqNum) {
-                sbuf.slpHeader.subHeader.appDataLen = SLP_FLAGS_RECEIVER_RESET;
-            } else {
-                sbuf.slpHeader.subHeader.appDataLen = 0;
-            }
-            sbuf.slpHeader.subHeader.fill = 0; //not used
-            sbuf.slpHeader.subHeader.seqNum = seqNum;
-            sbuf.slpHeader.crc =  crcFast(((const uint8_t*) &sbuf.slpHeader.subHeader),
-                sizeof(sbuf.slpHeader.subHeader));
-            sbuf.slpHeader.fill = 0; //not used
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpSendNack: for getting message having seqNum %lu\n",
+            sbuf.slpHeader.subHeader.seqNum);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
 
-            if (gGenDebugPrint) {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_send_nack: for getting message having seqNum %lu\n",
-                    sbuf.slpHeader.subHeader.seqNum);
-                pthread_mutex_unlock(&gGenPrintLock);
-            }
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_RX_NACK_SENT, seqNum, sbuf.slpHeader.subHeader.appDataLen, 0);
+    GEN_STAT_INC(GEN_STAT_SLP_RX_SENT_NACKS);
+
+    //send
+    if (GenLinkSend(GEN_LINK_NACK, seqNum, msqid, &sbuf, sizeof(sbuf.slpHeader)) < 0) {
+        perror("msgsnd");
+        exit(1);
+    }
+}
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfSentNacks++;
-#endif
+//gap at waitSeqNum may have moved on since it was detected, timer runs as long as there is one,
+//gSlpRxLock may be held long, e.g. while a delivery waits for slp_recv, then the check is retried
+//after one NACK check delay, so gen_timer_run doesn't block other timers like SLP-tx probe
+static void SlpNackTimerExpired(void* pArg)
+{
+    uint64_t seqNum;
+    int gap;
 
-            //send
-            if (msgsnd(msqid, &sbuf, sizeof(sbuf.slpHeader), 0) < 0) {
-                perror("msgsnd");
-                exit(1);
-            }
-        }
+    (void) pArg;
+    if (0 != pthread_mutex_trylock(&gSlpRxLock)) {
+        GenTimerArm(&sSlpNackTimer, gSlpLinkSettings.nackCheckDelayUs);
+        return;
+    }
+    sSlpRxState.nackTimerArmed = 0;
+    SlpWrongOrderCleanup();
+    gap = (0 == sSlpRxState.pendingEpoch) && (0 < sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
+    seqNum = sSlpRxState.waitSeqNum;
+    if (gap) {
+        SlpGapDetected();
+    }
+    pthread_mutex_unlock(&gSlpRxLock);
+
+    if (gap) {
+        SlpSendNack(seqNum);
     }
 }
 
-static void SlpSendAck(uint64_t seqNum)
+//queues ACK for slp_rx_send_ack, called before waitSeqNum is incremented
+static void SlpSendAck(uint64_t seqNum, uint32_t flags)
 {
-    sSlpSendAckWriteIndex++;
-    sSlpSendAckWriteIndex &= (SLP_MAX_NR_OF_BLOCKS - 1);
-    assert(sSlpSendAckWriteIndex != sSlpSendAckReadIndex);
-    sSlpDataToSendAck[sSlpSendAckWriteIndex].seqNum = seqNum;
+    SlpDataToSendAck_t ack;
+
+    ack.seqNum = seqNum;
+    ack.flags = flags;
+    ack.txEpoch = sSlpRxState.txEpoch;
+    ack.gapEndSeqNum = 0;
+    if (sSlpRxState.reset) {
+        ack.flags |= SLP_FLAGS_RECEIVER_RESET;
+        sSlpRxState.reset = 0;
+    }
+
+    //full queue: wait until slp_rx_send_ack has made room, ACKs must not be lost here
+    while (!mpscQueuePush(&sSlpSendAckQueue, &ack)) {
+        usleep(GEN_SMALL_THREAD_DELAY_US);
+    }
+
     if (sSlpRxDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("SlpSendAck: seqNum %lu, write index %d, read index %d\n",
-            sSlpDataToSendAck[sSlpSendAckWriteIndex].seqNum, sSlpSendAckWriteIndex, sSlpSendAckReadIndex);
+        printf("SlpSendAck: seqNum %lu, flags %u\n", ack.seqNum, ack.flags);
         pthread_mutex_unlock(&gGenPrintLock);
     }
 }
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-static void SlpRxDebugPrintStatistics(void)
-{
-    pthread_mutex_lock(&gGenPrintLock);
-    printf(
-        "SLP-rx statistics:\n"
-        " nr of received data blocks %u\n"
-        " nr of accepted data blocks %u\n"
-        " nr of sent acks %u\n"
-        " nr of sent nacks %u\n"
-        " nr of received retransmitted data blocks %u\n"
-        " nr of received retransmitted polls %u\n"
-        " nr of accepted retransmitted data blocks %u\n"
-        " nr of accepted retransmitted polls %u\n"
-        " nr of received polls %u\n"
-        " nr of dropped data blocks by test method a) %u\n"
-        " nr of dropped data blocks by test method b) %u\n"
-        " nr of dropped retransmitted data blocks by test %u\n"
-        " nr of dropped retransmitted polls by test %u\n"
-        " nr of dropped polls by test %u\n"
-        " nr of to APP forwarded data blocks %u\n",
-        sSlpRxDebug.nrOfReceivedDataBlocks, sSlpRxDebug.nrOfAcceptedDataBlocks,
-        sSlpRxDebug.nrOfSentAcks, sSlpRxDebug.nrOfSentNacks,
-        sSlpRxDebug.nrOfReceivedRetransmittedDataBlocks, sSlpRxDebug.nrOfReceivedRetransmittedPolls,
-        sSlpRxDebug.nrOfAcceptedRetransmittedDataBlocks, sSlpRxDebug.nrOfAcceptedRetransmittedPolls,
-        sSlpRxDebug.nrOfReceivedPolls, sSlpRxDebug.nrOfDroppedSuccessiveDataBlocks, sSlpRxDebug.nrOfDroppedRandDataBlocks,
-        sSlpRxDebug.nrOfDroppedRetransmittedDataBlocks, sSlpRxDebug.nrOfDroppedRetransmittedPolls, sSlpRxDebug.nrOfDroppedPolls,
-        sSlpRxDebug.nrOfDataBlocksForwardedToApp);
-    pthread_mutex_unlock(&gGenPrintLock);
+//asks SLP-tx where to continue, at most once per round trip while answer is on its way,
+//seqNum is the oldest saved one of txEpoch session or GEN_ID_INVALID if none is saved
+static void SlpRequestResync(uint32_t txEpoch, uint64_t seqNum)
+{
+    SlpDataToSendAck_t request = {seqNum, SLP_FLAGS_RESYNC_REQUEST, txEpoch, 0};
+    uint64_t nowNs = GenStatNowNs();
+    uint64_t intervalNs = 2000ULL * (GenLinkMaxDelayUs(GEN_LINK_ACK) + GenLinkMaxDelayUs(GEN_LINK_RETRANS)) +
+        1000ULL * gSlpLinkSettings.nackCheckDelayUs * gSlpLinkSettings.nackCheckLimit;
+
+    if ((0 != sSlpRxState.resyncRequestNs) && ((nowNs - sSlpRxState.resyncRequestNs) < intervalNs)) return;
+    sSlpRxState.resyncRequestNs = nowNs;
+    if (!mpscQueuePush(&sSlpSendAckQueue, &request)) {
+        sSlpRxState.resyncRequestNs = 0;
+    }
 }
-#endif
 
-static void SlpForwardReceivedDataToApp(SlpInnerMsg_t* pRbuf)
+//message of another SLP-tx session than the synchronised one is dropped, except that SLP-rx without session
+//saves messages of the first session it hears of until resync, gSlpRxLock is locked by caller
+static int SlpIsStale(const SlpSubHeader_t* pSubHeader)
 {
-    int msqid;
-    int msgflg = IPC_CREAT | MSG_FLAG;
-    key_t key;
-    SlpAppMsg_t sbuf;
+    uint64_t seqNum = pSubHeader->seqNum;
 
-    key = SLP_APP_DATA_RECEIVE_MSG_QUEUE_KEY_ID;
-    if ((msqid = msgget(key, msgflg)) < 0) {
-        perror("msgget");
-        exit(1);
+    if (sSlpRxState.txEpoch == pSubHeader->txEpoch) return 0;
+    if ((0 == sSlpRxState.txEpoch) && (0 == sSlpRxState.pendingEpoch)) {
+        sSlpRxState.pendingEpoch = pSubHeader->txEpoch;
     }
-    sbuf.mtype = SLP_APP_DATA_RECEIVE_MSG;
+    if (sSlpRxState.pendingEpoch == pSubHeader->txEpoch) {
+        if ((0 < sSlpRxState.nrOfWrongOrderReceivedDataBlocks) && (sSlpRxState.wrongOrderSeqNums[0] < seqNum)) {
+            seqNum = sSlpRxState.wrongOrderSeqNums[0];
+        }
+        SlpRequestResync(pSubHeader->txEpoch, seqNum);
+        return 0;
+    }
+    GEN_STAT_INC(GEN_STAT_SLP_RX_STALE_MSGS);
+    SlpRequestResync(pSubHeader->txEpoch, GEN_ID_INVALID);
+    return 1;
+}
 
-    sbuf.data.genId = pRbuf->data.slpHeader.subHeader.seqNum;
-    sbuf.data.len =  pRbuf->data.slpHeader.subHeader.appDataLen;
-    memcpy(sbuf.data.appData, pRbuf->data.appData, pRbuf->data.slpHeader.subHeader.appDataLen);
+//data blocks are saved in wrong order while resync is pending, gSlpRxLock is locked by caller
+static int SlpIsWaited(uint64_t seqNum)
+{
+    return (0 == sSlpRxState.pendingEpoch) && (sSlpRxState.waitSeqNum == seqNum);
+}
+
+static int SlpIsAhead(uint64_t seqNum)
+{
+    return (0 != sSlpRxState.pendingEpoch) || (sSlpRxState.waitSeqNum < seqNum);
+}
+
+static void SlpFecReset(void);
+
+static void SlpHandleInWrongOrderReceivedDataBlocks(uint64_t seqNum);
+
+//answer to resync request: seqNum is the oldest one not acknowledged to SLP-tx, saved data blocks and FEC groups
+//are kept only if they belong to the answering session, gSlpRxLock is locked by caller
+static void SlpResync(const SlpSubHeader_t* pSubHeader)
+{
+    int nr = 0;
+
+    //answer to an earlier SLP-rx or a repeated answer
+    if ((sSlpRxState.epoch != pSubHeader->rxEpoch) || (sSlpRxState.txEpoch == pSubHeader->txEpoch)) return;
+
+    //pending session saved data blocks from seqNum on, older ones were acknowledged to an earlier SLP-rx
+    while ((0 < sSlpRxState.nrOfWrongOrderReceivedDataBlocks) && ((sSlpRxState.pendingEpoch != pSubHeader->txEpoch) ||
+        (sSlpRxState.wrongOrderSeqNums[0] < pSubHeader->seqNum))) {
+        SlpRemoveInWrongOrderReceivedDataBlock(0);
+        nr++;
+    }
+    if (sSlpRxState.pendingEpoch != pSubHeader->txEpoch) {
+        SlpFecReset();
+    }
+    sSlpRxState.pendingEpoch = 0;
+    sSlpRxState.txEpoch = pSubHeader->txEpoch;
+    sSlpRxState.waitSeqNum = pSubHeader->seqNum;
+    sSlpRxState.lastSentNackSeqNum = GEN_ID_INVALID;
+    sSlpRxState.lastSentNackSeqNumClearCount = 0;
+    sSlpRxState.resyncRequestNs = 0;
+    sSlpRxState.reset = 1;
 
     if (gGenDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("SlpForwardReceivedDataToApp: forwarded seqNum(slpId) %lu to APP\n", sbuf.data.genId);
+        printf("SlpResync: SLP-tx session %u continues from seqNum %lu, %d wrong order received data blocks dropped\n",
+            pSubHeader->txEpoch, pSubHeader->seqNum, nr);
         pthread_mutex_unlock(&gGenPrintLock);
     }
-
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-    sSlpRxDebug.nrOfDataBlocksForwardedToApp++;
-    SlpRxDebugPrintStatistics();
-#endif
-
-    //send
-    if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
-        perror("msgsnd");
-        exit(1);
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_RX_RESYNCED, pSubHeader->seqNum, pSubHeader->txEpoch, nr);
+    GEN_STAT_INC(GEN_STAT_SLP_RX_RESYNCS);
+    SlpHandleInWrongOrderReceivedDataBlocks(sSlpRxState.waitSeqNum);
+    if (0 < sSlpRxState.nrOfWrongOrderReceivedDataBlocks) {
+        SlpGapDetected();
     }
 }
 
-static void SlpForwardInWrongOrderReceivedDataToApp(int pos)
+//APP gets data block directly by slp_lib.c or as a copy in SysV queue
+static void SlpDeliverToApp(uint64_t seqNum, uint64_t appTag, const uint8_t* pAppData, uint32_t len, uint32_t flags)
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
     SlpAppMsg_t sbuf;
+    uint64_t nowNs = GenStatNowNs();
+
+    GenStatLatency(GEN_STAT_LATENCY_SEND_TO_ACCEPT, GenStatGetStamp(seqNum, GEN_STAT_STAMP_SEND), nowNs);
+    if (0 != (SLP_SUBHEADER_FLAG_URGENT & flags)) {
+        GenStatLatency(GEN_STAT_LATENCY_URGENT_SUBMIT_TO_ACCEPT, GenStatGetStamp(seqNum, GEN_STAT_STAMP_SUBMIT), nowNs);
+    }
+    GEN_STAT_INC(GEN_STAT_SLP_RX_DATA_BLOCKS_FORWARDED_TO_APP);
+
+    if (NULL != gSlpAppOps.pDeliver) {
+        gSlpAppOps.pDeliver(seqNum, appTag, pAppData, len, nowNs);
+        return;
+    }
 
     key = SLP_APP_DATA_RECEIVE_MSG_QUEUE_KEY_ID;
     if ((msqid = msgget(key, msgflg)) < 0) {
@@ -358,15 +460,11 @@ static void SlpForwardInWrongOrderReceivedDataToApp(int pos)
         exit(1);
     }
     sbuf.mtype = SLP_APP_DATA_RECEIVE_MSG;
-
-    sbuf.data.genId = sSlpRxState.wrongOrderSeqNums[pos];
-    sbuf.data.len = sSlpRxState.wrongOrderBlockData[pos].appLen;
-    memcpy(sbuf.data.appData, sSlpRxState.wrongOrderBlockData[pos].pAppDataPtr, sSlpRxState.wrongOrderBlockData[pos].appLen);
-
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-    sSlpRxDebug.nrOfDataBlocksForwardedToApp++;
-    SlpRxDebugPrintStatistics();
-#endif
+    sbuf.data.genId = seqNum;
+    sbuf.data.appTag = appTag;
+    sbuf.data.len = len;
+    sbuf.data.timeNs = nowNs;
+    memcpy(sbuf.data.appData, pAppData, len);
 
     //send
     if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
@@ -375,26 +473,77 @@ static void SlpForwardInWrongOrderReceivedDataToApp(int pos)
     }
 }
 
-static void SlpSaveInWrongOrderReceivedDataBlock(SlpInnerMsg_t* pRbuf)
+static void SlpForwardReceivedDataToApp(SlpInnerMsg_t* pRbuf)
 {
-    void* pAppData;
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpForwardReceivedDataToApp: forwarded seqNum(slpId) %lu to APP\n", pRbuf->data.slpHeader.subHeader.seqNum);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+
+    SlpDeliverToApp(pRbuf->data.slpHeader.subHeader.seqNum, pRbuf->data.slpHeader.subHeader.appTag,
+        pRbuf->data.appData, pRbuf->data.slpHeader.subHeader.appDataLen, pRbuf->data.slpHeader.subHeader.flags);
+}
+
+static void SlpForwardInWrongOrderReceivedDataToApp(int pos)
+{
+    SlpDeliverToApp(sSlpRxState.wrongOrderSeqNums[pos], sSlpRxState.wrongOrderBlockData[pos].appTag,
+        sSlpRxState.wrongOrderBlockData[pos].pAppDataPtr, sSlpRxState.wrongOrderBlockData[pos].appLen,
+        sSlpRxState.wrongOrderBlockData[pos].flags);
+}
+
+//returns position keeping wrong order received seqNums sorted, -1 if seqNum is already saved
+static int SlpInsertInWrongOrderReceivedPos(uint64_t seqNum)
+{
+    int pos = sSlpRxState.nrOfWrongOrderReceivedDataBlocks;
+    int i;
 
     assert(SLP_MAX_NR_OF_BLOCKS > sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
+
+    //normally seqNum is the newest one, FEC recovered data block may be older
+    while ((0 < pos) && (seqNum <= sSlpRxState.wrongOrderSeqNums[pos - 1])) {
+        if (seqNum == sSlpRxState.wrongOrderSeqNums[pos - 1]) return -1;
+        pos--;
+    }
+    for (i = sSlpRxState.nrOfWrongOrderReceivedDataBlocks; i > pos; i--) {
+        sSlpRxState.wrongOrderBlockData[i] = sSlpRxState.wrongOrderBlockData[i - 1];
+        sSlpRxState.wrongOrderSeqNums[i] = sSlpRxState.wrongOrderSeqNums[i - 1];
+    }
+    sSlpRxState.nrOfWrongOrderReceivedDataBlocks++;
+    SlpGapDetected();
+    SlpSendSelectiveAck((0 == pos) ? seqNum : sSlpRxState.wrongOrderSeqNums[0]);
+    return pos;
+}
+
+static void SlpSaveInWrongOrderReceivedDataBlock(SlpInnerMsg_t* pRbuf, uint32_t ackFlags)
+{
+    void* pAppData;
+    int pos;
+
+    pos = SlpInsertInWrongOrderReceivedPos(pRbuf->data.slpHeader.subHeader.seqNum);
+    if (0 > pos) return;
     pAppData = malloc(pRbuf->data.slpHeader.subHeader.appDataLen);
     assert(NULL != pAppData);
     memcpy(pAppData, pRbuf->data.appData, pRbuf->data.slpHeader.subHeader.appDataLen);
-    sSlpRxState.wrongOrderBlockData[sSlpRxState.nrOfWrongOrderReceivedDataBlocks].pAppDataPtr = pAppData;
-    sSlpRxState.wrongOrderBlockData[sSlpRxState.nrOfWrongOrderReceivedDataBlocks].appLen = pRbuf->data.slpHeader.subHeader.appDataLen;
-    sSlpRxState.wrongOrderSeqNums[sSlpRxState.nrOfWrongOrderReceivedDataBlocks] = pRbuf->data.slpHeader.subHeader.seqNum;
-    sSlpRxState.nrOfWrongOrderReceivedDataBlocks++;
+    sSlpRxState.wrongOrderBlockData[pos].pAppDataPtr = pAppData;
+    sSlpRxState.wrongOrderBlockData[pos].appLen = pRbuf->data.slpHeader.subHeader.appDataLen;
+    sSlpRxState.wrongOrderBlockData[pos].ackFlags = ackFlags;
+    sSlpRxState.wrongOrderBlockData[pos].flags = pRbuf->data.slpHeader.subHeader.flags;
+    sSlpRxState.wrongOrderBlockData[pos].appTag = pRbuf->data.slpHeader.subHeader.appTag;
+    sSlpRxState.wrongOrderSeqNums[pos] = pRbuf->data.slpHeader.subHeader.seqNum;
 }
 static void SlpSaveInWrongOrderReceivedPoll(uint64_t seqNum)
 {
-    assert(SLP_MAX_NR_OF_BLOCKS > sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
-    sSlpRxState.wrongOrderBlockData[sSlpRxState.nrOfWrongOrderReceivedDataBlocks].pAppDataPtr = NULL;
-    sSlpRxState.wrongOrderBlockData[sSlpRxState.nrOfWrongOrderReceivedDataBlocks].appLen = 0;
-    sSlpRxState.wrongOrderSeqNums[sSlpRxState.nrOfWrongOrderReceivedDataBlocks] = seqNum;
-    sSlpRxState.nrOfWrongOrderReceivedDataBlocks++;
+    int pos;
+
+    pos = SlpInsertInWrongOrderReceivedPos(seqNum);
+    if (0 > pos) return;
+    sSlpRxState.wrongOrderBlockData[pos].pAppDataPtr = NULL;
+    sSlpRxState.wrongOrderBlockData[pos].appLen = 0;
+    sSlpRxState.wrongOrderBlockData[pos].ackFlags = 0;
+    sSlpRxState.wrongOrderBlockData[pos].flags = 0;
+    sSlpRxState.wrongOrderBlockData[pos].appTag = 0;
+    sSlpRxState.wrongOrderSeqNums[pos] = seqNum;
 }
 
 static void SlpHandleInWrongOrderReceivedDataBlocks(uint64_t seqNum)
@@ -406,7 +555,7 @@ static void SlpHandleInWrongOrderReceivedDataBlocks(uint64_t seqNum)
         if (0 < sSlpRxState.wrongOrderBlockData[i].appLen) {
             SlpForwardInWrongOrderReceivedDataToApp(i);
         }
-        SlpSendAck(seqNum);
+        SlpSendAck(seqNum, sSlpRxState.wrongOrderBlockData[i].ackFlags);
 
         if (sSlpRxDebugPrint) {
             pthread_mutex_lock(&gGenPrintLock);
@@ -431,6 +580,139 @@ static void SlpHandleInWrongOrderReceivedDataBlocks(uint64_t seqNum)
     }
 }
 
+//handles new data block, gSlpRxLock is locked by caller
+static void SlpAcceptDataBlock(SlpInnerMsg_t* pRbuf, uint32_t ackFlags)
+{
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpAcceptDataBlock: receiving APP data of seqNum %lu, waiting for seqNum %lu, nr in wrong order received blocks %d\n",
+             pRbuf->data.slpHeader.subHeader.seqNum, sSlpRxState.waitSeqNum, sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+
+    if (SlpIsWaited(pRbuf->data.slpHeader.subHeader.seqNum)) {
+        GEN_TRACE_EVENT(GEN_TRACE_SLP_RX_DATA_ACCEPTED, pRbuf->data.slpHeader.subHeader.seqNum, pRbuf->data.slpHeader.subHeader.appDataLen, ackFlags);
+        SlpForwardReceivedDataToApp(pRbuf);
+        SlpSendAck(pRbuf->data.slpHeader.subHeader.seqNum, ackFlags);
+        sSlpRxState.waitSeqNum++;
+        SlpHandleInWrongOrderReceivedDataBlocks(sSlpRxState.waitSeqNum);
+        GEN_STAT_INC(GEN_STAT_SLP_RX_ACCEPTED_DATA_BLOCKS);
+    } else if (SlpIsAhead(pRbuf->data.slpHeader.subHeader.seqNum)) {
+        //at least one data block lost
+        SlpSaveInWrongOrderReceivedDataBlock(pRbuf, ackFlags);
+        GEN_TRACE_EVENT(GEN_TRACE_SLP_RX_WRONG_ORDER_SAVED, pRbuf->data.slpHeader.subHeader.seqNum,
+            sSlpRxState.nrOfWrongOrderReceivedDataBlocks, sSlpRxState.waitSeqNum);
+        GEN_STAT_INC(GEN_STAT_SLP_RX_ACCEPTED_DATA_BLOCKS);
+    }
+}
+
+//returns FEC group of firstSeqNum, slot of an older group is taken into use,
+//NULL when a newer group has the slot already: late retransmission must not wipe it
+static SlpRxFecGroup_t* SlpGetFecGroup(uint64_t firstSeqNum)
+{
+    SlpRxFecGroup_t* pGroup;
+
+    pGroup = &sSlpRxFecGroups[(firstSeqNum / gSlpLinkSettings.fecGroupSize) % SLP_FEC_NR_OF_GROUPS];
+    if (pGroup->inUse && (firstSeqNum < pGroup->firstSeqNum)) return NULL;
+    if (!pGroup->inUse || (firstSeqNum != pGroup->firstSeqNum)) {
+        memset(pGroup, 0, sizeof(*pGroup));
+        pGroup->inUse = 1;
+        pGroup->firstSeqNum = firstSeqNum;
+    }
+    return pGroup;
+}
+
+//groups of previous SLP-tx session are forgotten
+static void SlpFecReset(void)
+{
+    memset(sSlpRxFecGroups, 0, sizeof(sSlpRxFecGroups));
+}
+
+//rebuilds lost data block when parity and all but one data block of the group are received
+static void SlpFecTryRecover(SlpRxFecGroup_t* pGroup)
+{
+    SlpInnerMsg_t rbuf;
+    uint64_t missing;
+
+    if (!pGroup->parityReceived || pGroup->recovered) return;
+
+    //nothing lost or too many lost
+    missing = pGroup->parityMask & ~pGroup->rxMask;
+    if ((0 == missing) || (0 != (missing & (missing - 1)))) return;
+
+    pGroup->recovered = 1;
+    pGroup->rxMask |= missing;
+    if (SLP_APP_DATA_SIZE < pGroup->appDataLenXor) return;
+
+    rbuf.mtype = SLP_INNER_APP_DATA_MSG;
+    rbuf.data.slpHeader.subHeader.seqNum = pGroup->firstSeqNum + __builtin_ctzll(missing);
+    rbuf.data.slpHeader.subHeader.appDataLen = pGroup->appDataLenXor;
+    rbuf.data.slpHeader.subHeader.flags = pGroup->flagsXor;
+    rbuf.data.slpHeader.subHeader.appTag = pGroup->appTagXor;
+    memcpy(rbuf.data.appData, pGroup->appDataXor, pGroup->appDataLenXor);
+    if (!SlpDecompress(&rbuf.data)) return;
+
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpFecTryRecover: seqNum %lu recovered, waiting for seqNum %lu\n",
+            rbuf.data.slpHeader.subHeader.seqNum, sSlpRxState.waitSeqNum);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_RX_FEC_RECOVERED, rbuf.data.slpHeader.subHeader.seqNum,
+        rbuf.data.slpHeader.subHeader.appDataLen, pGroup->firstSeqNum);
+    GEN_STAT_INC(GEN_STAT_SLP_RX_FEC_RECOVERED_DATA_BLOCKS);
+
+    SlpAcceptDataBlock(&rbuf, SLP_FLAGS_FEC_RECOVERED);
+}
+
+//gSlpRxLock is locked by caller
+static void SlpFecDataBlockReceived(const SlpData_t* pData)
+{
+    SlpRxFecGroup_t* pGroup;
+    uint64_t seqNum = pData->slpHeader.subHeader.seqNum;
+    uint64_t firstSeqNum;
+    uint64_t bit;
+    uint32_t i;
+
+    if ((0 == gSlpLinkSettings.fecGroupSize) || (0 == pData->slpHeader.subHeader.appDataLen)) return;
+    firstSeqNum = seqNum - (seqNum % gSlpLinkSettings.fecGroupSize);
+    bit = 1ULL << (seqNum - firstSeqNum);
+
+    pGroup = SlpGetFecGroup(firstSeqNum);
+    if ((NULL == pGroup) || (0 != (bit & pGroup->rxMask))) return;
+
+    pGroup->rxMask |= bit;
+    pGroup->appDataLenXor ^= pData->slpHeader.subHeader.appDataLen;
+    pGroup->flagsXor ^= pData->slpHeader.subHeader.flags;
+    pGroup->appTagXor ^= pData->slpHeader.subHeader.appTag;
+    for (i = 0; i < pData->slpHeader.subHeader.appDataLen; i++) {
+        pGroup->appDataXor[i] ^= pData->appData[i];
+    }
+    SlpFecTryRecover(pGroup);
+}
+
+//gSlpRxLock is locked by caller
+static void SlpFecParityReceived(const SlpFecData_t* pData)
+{
+    SlpRxFecGroup_t* pGroup;
+    uint32_t i;
+
+    if ((0 == gSlpLinkSettings.fecGroupSize) || (SLP_APP_DATA_SIZE < pData->slpHeader.subHeader.appDataLen)) return;
+
+    pGroup = SlpGetFecGroup(pData->slpHeader.subHeader.seqNum);
+    if ((NULL == pGroup) || pGroup->parityReceived) return;
+
+    pGroup->parityReceived = 1;
+    pGroup->parityMask = pData->fecHeader.seqNumMask;
+    pGroup->appDataLenXor ^= pData->fecHeader.appDataLenXor;
+    pGroup->flagsXor ^= pData->fecHeader.flagsXor;
+    pGroup->appTagXor ^= pData->fecHeader.appTagXor;
+    for (i = 0; i < pData->slpHeader.subHeader.appDataLen; i++) {
+        pGroup->appDataXor[i] ^= pData->parity[i];
+    }
+    SlpFecTryRecover(pGroup);
+}
+
 void* slp_rx_receive_app_data()
 {
     int msqid;
@@ -453,65 +735,27 @@ void* slp_rx_receive_app_data()
             exit(1);
         }
 
-        usleep(SLP_SIMULATED_TRANSFER_DELAY_US);
-
-#ifdef GEN_SLP_TEST_LOST_APP_DATA
-        //10 successive APP data blocks per 256 are lost
-        if ((100 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)) || (101 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100))  ||
-            (102 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)) || (103 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100))  ||
-            (104 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)) || (105 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100))  ||
-            (106 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)) || (107 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100))  ||
-            (108 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)) || (109 == (rbuf.data.slpHeader.subHeader.seqNum % 0x100)))  {
-            pthread_mutex_lock(&gGenPrintLock);
-            printf("slp_rx_receive_app_data/test executed: APP data lost having seqNum %lu, nr in wrong order received blocks %d\n",
-                rbuf.data.slpHeader.subHeader.seqNum, sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
-            pthread_mutex_unlock(&gGenPrintLock);
-            usleep(10000);
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfDroppedSuccessiveDataBlocks++;
-#endif
-            continue;
-        }
-#endif
-#ifdef GEN_SLP_TEST_RAND_LOST
-        if (SlpTestRandOfThisSeqNum(rbuf.data.slpHeader.subHeader.seqNum, 3)) {
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfDroppedRandDataBlocks++;
-#endif
-            continue;
-        }
-#endif
-        if (rbuf.data.slpHeader.crc == crcFast(((const uint8_t*) &rbuf.data.slpHeader.subHeader),
+        //integrity check must pass, corrupted length must not take it beyond the buffer
+        if ((SLP_APP_DATA_SIZE >= rbuf.data.slpHeader.subHeader.appDataLen) && SlpIsIntegrityOk(&rbuf.data.slpHeader,
             sizeof(rbuf.data.slpHeader.subHeader) + rbuf.data.slpHeader.subHeader.appDataLen)) {
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfReceivedDataBlocks++;
-#endif
+            GEN_STAT_INC(GEN_STAT_SLP_RX_RECEIVED_DATA_BLOCKS);
 
             pthread_mutex_lock(&gSlpRxLock);
-            if (gGenDebugPrint) {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_rx_receive_app_data: receiving APP data of seqNum %lu, waiting for seqNum %lu, nr in wrong order received blocks %d\n",
-                     rbuf.data.slpHeader.subHeader.seqNum, sSlpRxState.waitSeqNum, sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
-                pthread_mutex_unlock(&gGenPrintLock);
+            if (SlpIsStale(&rbuf.data.slpHeader.subHeader)) {
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
             }
 
-            //zero seqNums are always accepted due to possible device resets
-            if (!sSlpRxState.waitSeqNum || !rbuf.data.slpHeader.subHeader.seqNum || (sSlpRxState.waitSeqNum == rbuf.data.slpHeader.subHeader.seqNum)) {
-                SlpForwardReceivedDataToApp(&rbuf);
-                SlpSendAck(rbuf.data.slpHeader.subHeader.seqNum);
-                sSlpRxState.waitSeqNum++;
-                SlpHandleInWrongOrderReceivedDataBlocks(sSlpRxState.waitSeqNum);
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-                sSlpRxDebug.nrOfAcceptedDataBlocks++;
-#endif
-            } else if (sSlpRxState.waitSeqNum < rbuf.data.slpHeader.subHeader.seqNum) {
-                //at least one data block lost
-                SlpSaveInWrongOrderReceivedDataBlock(&rbuf);
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-                sSlpRxDebug.nrOfAcceptedDataBlocks++;
-#endif
+            //FEC parity is calculated over data blocks as sent, i.e. before decompression
+            SlpFecDataBlockReceived(&rbuf.data);
+
+            //compressed data is restored to original APP data
+            if (!SlpDecompress(&rbuf.data)) {
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
             }
+            SlpAcceptDataBlock(&rbuf, 0);
             pthread_mutex_unlock(&gSlpRxLock);
 
             //print received last byte of received APP data
@@ -552,69 +796,72 @@ void* slp_rx_receive_retrans()
             exit(1);
         }
 
-        usleep(SLP_SIM_CTRL_MSG_TRANS_DELAY_US);
+        //integrity check must pass, corrupted length must not take it beyond the buffer
+        if ((SLP_APP_DATA_SIZE >= rbuf.data.slpHeader.subHeader.appDataLen) && SlpIsIntegrityOk(&rbuf.data.slpHeader,
+            sizeof(rbuf.data.slpHeader.subHeader) + rbuf.data.slpHeader.subHeader.appDataLen)) {
 
-#ifdef GEN_SLP_TEST_RAND_LOST
-        {
-            int callId;
+            //answer to resync request comes ahead of resent window
+            pthread_mutex_lock(&gSlpRxLock);
+            if (0 != (SLP_SUBHEADER_FLAG_RESYNC & rbuf.data.slpHeader.subHeader.flags)) {
+                SlpResync(&rbuf.data.slpHeader.subHeader);
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
+            }
+            if (SlpIsStale(&rbuf.data.slpHeader.subHeader)) {
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
+            }
 
             if (0 < rbuf.data.slpHeader.subHeader.appDataLen) {
-                callId = 4;
+                GEN_STAT_INC(GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_DATA_BLOCKS);
             } else {
-                callId = 5;
+                GEN_STAT_INC(GEN_STAT_SLP_RX_RECEIVED_RETRANSMITTED_POLLS);
             }
-
-            if (SlpTestRandOfThisSeqNum(rbuf.data.slpHeader.subHeader.seqNum, callId)) {
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-                if (0 < rbuf.data.slpHeader.subHeader.appDataLen) {
-                    sSlpRxDebug.nrOfDroppedRetransmittedDataBlocks++;
-                } else {
-                    sSlpRxDebug.nrOfDroppedRetransmittedPolls++;
+            SlpFecDataBlockReceived(&rbuf.data);
+
+            //window resent after resync may come ahead of the oldest data block
+            if (SlpIsAhead(rbuf.data.slpHeader.subHeader.seqNum)) {
+                if (0 == rbuf.data.slpHeader.subHeader.appDataLen) {
+                    SlpSaveInWrongOrderReceivedPoll(rbuf.data.slpHeader.subHeader.seqNum);
+                } else if (SlpDecompress(&rbuf.data)) {
+                    SlpSaveInWrongOrderReceivedDataBlock(&rbuf, 0);
                 }
-#endif
+                pthread_mutex_unlock(&gSlpRxLock);
                 continue;
             }
-        }
-#endif
-
-        //crc must match
-        if (rbuf.data.slpHeader.crc == crcFast(((const uint8_t*) &rbuf.data.slpHeader.subHeader),
-            sizeof(rbuf.data.slpHeader.subHeader) + rbuf.data.slpHeader.subHeader.appDataLen)) {
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            if (0 < rbuf.data.slpHeader.subHeader.appDataLen) {
-                sSlpRxDebug.nrOfReceivedRetransmittedDataBlocks++;
-            } else {
-                sSlpRxDebug.nrOfReceivedRetransmittedPolls++;
+            //retransmitted data block was received already, e.g. tail loss probe after lost ACKs,
+            //the latest ACK is sent again so that SLP-tx releases what it still waits for
+            if (sSlpRxState.waitSeqNum != rbuf.data.slpHeader.subHeader.seqNum) {
+                if (gGenDebugPrint) {
+                    pthread_mutex_lock(&gGenPrintLock);
+                    printf("slp_of_rec_dev_receive_retransmit: received seqNum %lu is older than waited seqNum %lu, nr in wrong order received data blocks %d\n",
+                        rbuf.data.slpHeader.subHeader.seqNum, sSlpRxState.waitSeqNum, sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
+                    pthread_mutex_unlock(&gGenPrintLock);
+                }
+                if (0 < sSlpRxState.waitSeqNum) {
+                    SlpSendAck(sSlpRxState.waitSeqNum - 1, 0);
+                }
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
             }
-#endif
-
-            //nothing to do if no wrong order received data blocks or retransmitted data block is not the oldest one
-            pthread_mutex_lock(&gSlpRxLock);
-            if ((0 == sSlpRxState.nrOfWrongOrderReceivedDataBlocks) ||
-                (sSlpRxState.waitSeqNum != rbuf.data.slpHeader.subHeader.seqNum))
-            {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_of_rec_dev_receive_retransmit: received seqNum %lu isn´t waiting for seqNum %lu or not in wrong order received data blocks %d\n",
-                    rbuf.data.slpHeader.subHeader.seqNum, sSlpRxState.waitSeqNum, sSlpRxState.nrOfWrongOrderReceivedDataBlocks);
-                pthread_mutex_unlock(&gGenPrintLock);
+            //compressed data is restored to original APP data
+            if (!SlpDecompress(&rbuf.data)) {
                 pthread_mutex_unlock(&gSlpRxLock);
                 continue;
             }
             if (0 < rbuf.data.slpHeader.subHeader.appDataLen) {
                 SlpForwardReceivedDataToApp(&rbuf);
             }
-            SlpSendAck(rbuf.data.slpHeader.subHeader.seqNum);
+            SlpSendAck(rbuf.data.slpHeader.subHeader.seqNum, 0);
             sSlpRxState.waitSeqNum++;
             SlpHandleInWrongOrderReceivedDataBlocks(sSlpRxState.waitSeqNum);
             pthread_mutex_unlock(&gSlpRxLock);
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
             if (0 < rbuf.data.slpHeader.subHeader.appDataLen) {
-                sSlpRxDebug.nrOfAcceptedRetransmittedDataBlocks++;
+                GEN_STAT_INC(GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_DATA_BLOCKS);
             } else {
-                sSlpRxDebug.nrOfAcceptedRetransmittedPolls++;
+                GEN_STAT_INC(GEN_STAT_SLP_RX_ACCEPTED_RETRANSMITTED_POLLS);
             }
-#endif
         }
     }
 }
@@ -642,24 +889,10 @@ void* slp_rx_receive_poll()
             exit(1);
         }
 
-        usleep(SLP_SIM_CTRL_MSG_TRANS_DELAY_US);
-
-#ifdef GEN_SLP_TEST_RAND_LOST
-        if (SlpTestRandOfThisSeqNum(rbuf.slpHeader.subHeader.seqNum, 6)) {
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfDroppedPolls++;
-#endif
-            continue;
-        }
-#endif
-
-        //crc must match
-        if (rbuf.slpHeader.crc == crcFast(((const uint8_t*) &rbuf.slpHeader.subHeader),
-            sizeof(rbuf.slpHeader.subHeader))) {
+        //integrity check must pass
+        if (SlpIsIntegrityOk(&rbuf.slpHeader, sizeof(rbuf.slpHeader.subHeader))) {
 
-#ifdef GEN_SLP_RX_DEBUG_STATISTICS
-            sSlpRxDebug.nrOfReceivedPolls++;
-#endif
+            GEN_STAT_INC(GEN_STAT_SLP_RX_RECEIVED_POLLS);
 
             pthread_mutex_lock(&gSlpRxLock);
             if (gGenDebugPrint) {
@@ -669,9 +902,12 @@ void* slp_rx_receive_poll()
                 pthread_mutex_unlock(&gGenPrintLock);
             }
 
-            //zero seqNums are always accepted due to possible device resets
-            if (!sSlpRxState.waitSeqNum || !rbuf.slpHeader.subHeader.seqNum || (sSlpRxState.waitSeqNum == rbuf.slpHeader.subHeader.seqNum)) {
-                SlpSendAck(rbuf.slpHeader.subHeader.seqNum);
+            if (SlpIsStale(&rbuf.slpHeader.subHeader)) {
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
+            }
+            if (SlpIsWaited(rbuf.slpHeader.subHeader.seqNum)) {
+                SlpSendAck(rbuf.slpHeader.subHeader.seqNum, 0);
                 sSlpRxState.waitSeqNum++;
                 if (gGenDebugPrint) {
                      pthread_mutex_lock(&gGenPrintLock);
@@ -680,7 +916,7 @@ void* slp_rx_receive_poll()
                      pthread_mutex_unlock(&gGenPrintLock);
                 }
                 SlpHandleInWrongOrderReceivedDataBlocks(sSlpRxState.waitSeqNum);
-            } else if (sSlpRxState.waitSeqNum < rbuf.slpHeader.subHeader.seqNum) {
+            } else if (SlpIsAhead(rbuf.slpHeader.subHeader.seqNum)) {
                 //at least one data block lost
                 SlpSaveInWrongOrderReceivedPoll(rbuf.slpHeader.subHeader.seqNum);
             }
@@ -688,3 +924,48 @@ void* slp_rx_receive_poll()
         }
     }
 }
+
+void* slp_rx_receive_fec()
+{
+    int msqid;
+    key_t key;
+    SlpFecMsg_t rbuf;
+    int retVal;
+
+    //get the message queue id for the key with value SLP_FEC_MSG_QUEUE_KEY_ID
+    key = SLP_FEC_MSG_QUEUE_KEY_ID;
+
+    //receive continuously message type SLP_FEC_MSG
+    for (;;) {
+        usleep(GEN_THREAD_DELAY_US);
+        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
+            usleep(GEN_THREAD_DELAY_US);
+        }
+        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_FEC_MSG, 0);
+        if (0 > retVal) {
+            perror("msgrcv");
+            exit(1);
+        }
+
+        //integrity check must pass, corrupted length must not take it beyond the buffer
+        if ((SLP_APP_DATA_SIZE >= rbuf.data.slpHeader.subHeader.appDataLen) && SlpIsIntegrityOk(&rbuf.data.slpHeader,
+            sizeof(rbuf.data.slpHeader.subHeader) + sizeof(rbuf.data.fecHeader) + rbuf.data.slpHeader.subHeader.appDataLen)) {
+
+            GEN_STAT_INC(GEN_STAT_SLP_RX_RECEIVED_FEC_PARITY_BLOCKS);
+
+            pthread_mutex_lock(&gSlpRxLock);
+            if (SlpIsStale(&rbuf.data.slpHeader.subHeader)) {
+                pthread_mutex_unlock(&gSlpRxLock);
+                continue;
+            }
+            if (gGenDebugPrint) {
+                pthread_mutex_lock(&gGenPrintLock);
+                printf("slp_rx_receive_fec: parity of first seqNum %lu, seqNum mask 0x%lx, waiting for seqNum %lu\n",
+                     rbuf.data.slpHeader.subHeader.seqNum, rbuf.data.fecHeader.seqNumMask, sSlpRxState.waitSeqNum);
+                pthread_mutex_unlock(&gGenPrintLock);
+            }
+            SlpFecParityReceived(&rbuf.data);
+            pthread_mutex_unlock(&gSlpRxLock);
+        }
+    }
+}
@@ -16,55 +16,86 @@ This can be ported easily to other Operating System environments, also into embe
 
 #include "common.h"
 #include "gen_if.h"
+#include "gen_trace_if.h"
+#include "gen_stat_if.h"
+#include "gen_link_if.h"
+#include "gen_timer_if.h"
 #include "util_if.h"
 #include "msg.h"
 #include "slp_if.h"
 #include "slp.h"
 
-pthread_mutex_t gSlpTxLock;
-
-typedef struct SlpTxBlockData_t {
-    void*	pAppDataPtr;
-    uint32_t    appLen;
-}  SlpTxBlockData_t;
+#define SLP_ACK_RELEASE_BATCH_SIZE      64
 
+//saved data blocks are in the window of slp_txwin.c
 typedef struct SlpTxState_t {
-    uint64_t            seqNums[SLP_MAX_NR_OF_BLOCKS];
-    SlpTxBlockData_t    blockData[SLP_MAX_NR_OF_BLOCKS];
-    int                 nrOfDataBlocks;
-    uint64_t            seqNumCount;
     int                 primaryAppWait;
     int                 secondaryAppWait;
-    int                 dataBlockSendingDecided;
-    int                 pollSendingDecided;
+    uint8_t             sentAppState; //latest SLP_ASKS_APP_TO_WAIT/GO_ON sent to APP
+    int                 appStateSending; //a thread sends APP states, others leave theirs to it
+    int                 appStateChanged; //wait flags changed while APP states were being sent
+    uint32_t            epoch; //session of this SLP-tx, seqNums of earlier ones are stale
+    atomic_uint         rxEpoch; //session of SLP-rx known from its latest resync request, read by all senders
 } SlpTxState_t;
 
 static SlpTxState_t sSlpTxState;
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-typedef struct SlpTxDebug_t {
-    pthread_mutex_t timeLock;
-    struct tm startTimeInfo;
-    int    startTimeSet;
-    struct tm timeInfo;
-    uint32_t nrOfReceivedDataBlocksFromApp;
-    uint32_t nrOfSentDataBlocks;
-    uint32_t nrOfRetransmittedDataBlocks;
-    uint32_t nrOfRetransmittedPolls;
-    uint32_t nrOfReceivedAcks;
-    uint32_t nrOfReceivedNacks;
-    uint32_t nrOfSentPolls;
-    uint32_t nrOfDroppedSuccessiveAcks;
-    uint32_t nrOfDroppedRandAcks;
-    uint32_t nrOfDroppedNacks;
-} SlpTxDebug_t;
-
-static SlpTxDebug_t sSlpTxDebug;
-#endif
+//gap which selective acks are counted for, used by slp_tx_receive_ack,
+//nackedSeqNum is atomic as slp_tx_receive_nack writes it
+typedef struct SlpFastRetransState_t {
+    uint64_t                gapSeqNum;
+    uint32_t                nrOfSelectiveAcks;
+    uint64_t                resentEndSeqNum; //earlier seqNums were resent already, gap starting before it is resent from it
+    atomic_uint_fast64_t    nackedSeqNum; //latest retransmitted by NACK
+} SlpFastRetransState_t;
+
+static SlpFastRetransState_t sSlpFastRetransState;
+
+//srttNs is written by slp_tx_receive_ack and read by probe timer callback, nrOfProbes is written by both,
+//retransmittedEndSeqNum only grows by all retransmitting threads, so all of them are atomic
+typedef struct SlpProbeState_t {
+    atomic_uint_fast64_t    srttNs; //smoothed time from sending a data block to its ACK, 0 before first sample
+    atomic_uint             nrOfProbes; //probes sent since the latest ACK progress
+    atomic_uint_fast64_t    retransmittedEndSeqNum; //earlier seqNums may have been retransmitted, their ACKs give no sample
+} SlpProbeState_t;
+
+static SlpProbeState_t sSlpProbeState;
+
+//parity of the group being sent, used only under sSlpTxSubmitLock
+static SlpFecMsg_t sSlpTxFecMsg;
+
+//slp_send callers and slp_tx_receive_app_data submit in turn, seqNums leave in reserved order
+static pthread_mutex_t sSlpTxSubmitLock = PTHREAD_MUTEX_INITIALIZER;
+
+//APP wait flags and their sending state change under it, states are sent to APP without it
+static pthread_mutex_t sSlpTxAppWaitLock = PTHREAD_MUTEX_INITIALIZER;
+
+//urgent submitters waiting for sSlpTxSubmitLock, bulk ones let them go first
+static atomic_int sSlpTxUrgentWaiters;
+
+//bulk submitters sleep on the condition until window release or urgent submitter may have given them turn
+static pthread_mutex_t sSlpTxBulkTurnLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sSlpTxBulkTurnCond = PTHREAD_COND_INITIALIZER;
+static int sSlpTxNrOfBulkWaiters; //used under sSlpTxBulkTurnLock
+
+//urgent data blocks in window, APP wait and go on limits count only bulk ones,
+//otherwise APP asked to wait would never go on while urgent blocks keep coming
+static atomic_int sSlpTxNrOfUrgentDataBlocks;
+
+//data block being submitted is gathered straight into its message, used only under sSlpTxSubmitLock
+static SlpInnerMsg_t sSlpTxInnerMsg;
+static uint8_t sSlpTxGatherBuf[SLP_APP_DATA_SIZE]; //compression input of several segments
 
 static int sSlpTxDebugPrint;
 
-static void SlpPollAckReceived(uint64_t seqNum);
+static int SlpRetransmit(uint64_t seqNum);
+static void SlpResync(const SlpSubHeader_t* pRequest);
+static void SlpProbeAckReceived(uint64_t seqNum);
+static void SlpProbeRetransmitted(uint64_t seqNum);
+static void SlpProbeDataBlockSent(void);
+static void SlpProbeTimerExpired(void* pArg);
+
+static GenTimer_t sSlpProbeTimer;
 
 static void SlpSendState(uint8_t state)
 {
@@ -73,6 +104,11 @@ static void SlpSendState(uint8_t state)
     key_t key;
     SlpStateMsg_t sbuf;
 
+    if (NULL != gSlpAppOps.pState) {
+        gSlpAppOps.pState(state);
+        return;
+    }
+
     //get the message queue id
     key = SLP_APP_STATE_MSG_QUEUE_KEY_ID;
 
@@ -100,41 +136,78 @@ static void SlpSendState(uint8_t state)
     }
 }
 
-static void SlpSendInfo(uint8_t infoType, uint64_t slpId, uint64_t appId)
+/*
+Called without SLP-tx locks after wait flags changed, as APP state callback may call slp_send.
+One thread at a time sends, always the latest state and only when it differs from the one sent,
+so APP can't get states in other order than they changed. Changes made meanwhile, also by
+slp_send of the callback itself, are left to the sending thread, which loops until none is left.
+*/
+static void SlpTxSendAppState(void)
+{
+    uint8_t state;
+
+    pthread_mutex_lock(&sSlpTxAppWaitLock);
+    sSlpTxState.appStateChanged = 1;
+    if (sSlpTxState.appStateSending) {
+        pthread_mutex_unlock(&sSlpTxAppWaitLock);
+        return;
+    }
+    sSlpTxState.appStateSending = 1;
+    while (sSlpTxState.appStateChanged) {
+        sSlpTxState.appStateChanged = 0;
+        state = (sSlpTxState.primaryAppWait || sSlpTxState.secondaryAppWait) ? SLP_ASKS_APP_TO_WAIT : SLP_ASKS_APP_TO_GO_ON;
+        if (state == sSlpTxState.sentAppState) continue;
+        sSlpTxState.sentAppState = state;
+        pthread_mutex_unlock(&sSlpTxAppWaitLock);
+        SlpSendState(state);
+        pthread_mutex_lock(&sSlpTxAppWaitLock);
+    }
+    sSlpTxState.appStateSending = 0;
+    pthread_mutex_unlock(&sSlpTxAppWaitLock);
+}
+
+static void SlpSendInfo(uint8_t infoType, uint64_t slpId, uint64_t appTag)
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
     SlpInfoMsg_t sbuf;
 
-    //get the message queue id
-    key = SLP_APP_INFO_MSG_QUEUE_KEY_ID;
-
-    if ((msqid = msgget(key, msgflg)) < 0) {
-        perror("msgget");
-        exit(1);
-    }
-
     //set message type
     sbuf.mtype = SLP_APP_INFO_MSG;
 
     //set msg parameters
     sbuf.data.infoType = infoType;
-    sbuf.data.appId = appId;
+    sbuf.data.appTag = appTag;
     sbuf.data.slpId = slpId;
 
     if (sSlpTxDebugPrint) {
+        uint64_t oldestSeqNum;
+        int nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+
         pthread_mutex_lock(&gGenPrintLock);
-        if (0 < sSlpTxState.nrOfDataBlocks) {
+        if (0 < nr) {
             printf("SlpSendInfo: nr of data blocks %d, seqNums %lu..%lu..%lu\n",
-                sSlpTxState.nrOfDataBlocks,
-                sSlpTxState.seqNums[0], slpId, sSlpTxState.seqNums[sSlpTxState.nrOfDataBlocks - 1]);
+                nr, oldestSeqNum, slpId, oldestSeqNum + nr - 1);
         } else {
-            printf("SlpSendInfo: nr of data blocks %d\n", sSlpTxState.nrOfDataBlocks);
+            printf("SlpSendInfo: nr of data blocks %d\n", nr);
         }
         pthread_mutex_unlock(&gGenPrintLock);
     }
 
+    if (NULL != gSlpAppOps.pInfo) {
+        gSlpAppOps.pInfo(&sbuf.data);
+        return;
+    }
+
+    //get the message queue id
+    key = SLP_APP_INFO_MSG_QUEUE_KEY_ID;
+
+    if ((msqid = msgget(key, msgflg)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+
     //send
     if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
         perror("msgsnd");
@@ -142,125 +215,109 @@ static void SlpSendInfo(uint8_t infoType, uint64_t slpId, uint64_t appId)
     }
 }
 
-static void SlpRemoveDataBlock(int pos)
+//SysV APP gets one info per slpId, in-process APP one call per range
+static void SlpSendCompletion(const SlpCompletion_t* pCompletion)
 {
-    int i;
+    uint32_t i;
 
-    // Deleting element
-    for (i = pos; i < sSlpTxState.nrOfDataBlocks; i++) {
-        if (i < (sSlpTxState.nrOfDataBlocks - 1)) {
-            sSlpTxState.blockData[i] = sSlpTxState.blockData[i+1];
-            sSlpTxState.seqNums[i] = sSlpTxState.seqNums[i+1];
-        } else {
-            sSlpTxState.seqNums[i] = 0;
-            sSlpTxState.blockData[i].pAppDataPtr = NULL;
-            sSlpTxState.blockData[i].appLen = 0;
-        }
+    if (0 == pCompletion->nr) return;
+    if (NULL != gSlpAppOps.pComplete) {
+        gSlpAppOps.pComplete(pCompletion);
+        return;
+    }
+    for (i = 0; i < pCompletion->nr; i++) {
+        SlpSendInfo(pCompletion->infoType, pCompletion->firstSlpId + i,
+            (SLP_INFO_TYPE_RX_RESET == pCompletion->infoType) ? 0 : pCompletion->firstAppTag + i);
     }
+}
 
-    //Decrement nr of data blocks
-    sSlpTxState.nrOfDataBlocks--;
+//extends pending range when both seqNum and appTag continue it, otherwise sends it and starts a new one
+static void SlpAddCompletion(SlpCompletion_t* pPending, uint8_t infoType, uint64_t seqNum, uint64_t appTag)
+{
+    if ((0 < pPending->nr) && (infoType == pPending->infoType) && (pPending->firstSlpId + pPending->nr == seqNum) &&
+        ((SLP_INFO_TYPE_RX_RESET == infoType) || (pPending->firstAppTag + pPending->nr == appTag))) {
+        pPending->nr++;
+        return;
+    }
+    SlpSendCompletion(pPending);
+    pPending->firstSlpId = seqNum;
+    pPending->firstAppTag = appTag;
+    pPending->nr = 1;
+    pPending->infoType = infoType;
 }
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-void* slp_tx_debug_get_time()
+//called outside of gSlpTxLock for a block already released from the window
+//completion is added to pending range, caller sends it after the ACK is handled
+static void SlpEndDataBlock(const SlpTxReleased_t* pReleased, uint32_t flags, SlpCompletion_t* pPending)
 {
-    time_t rawTime;
-    struct tm* pTimeInfo;
+    if (NULL != pReleased->pAppDataPtr) {
+        GenStatLatency(GEN_STAT_LATENCY_SEND_TO_ACK_RELEASE, GenStatGetStamp(pReleased->seqNum, GEN_STAT_STAMP_SEND), GenStatNowNs());
 
-    if (pthread_mutex_init(&sSlpTxDebug.timeLock, NULL) != 0)
-    {
-        printf("\n slp tx debug mutex init failed\n");
-        exit(1);
-    }
-    for (;;) {
-        time(&rawTime);
-        pTimeInfo = localtime(&rawTime);
-        pthread_mutex_lock(&sSlpTxDebug.timeLock);
-        if (!sSlpTxDebug.startTimeSet) {
-            sSlpTxDebug.startTimeSet = 1;
-            sSlpTxDebug.startTimeInfo = *pTimeInfo;
-        }
-        sSlpTxDebug.timeInfo = *pTimeInfo;
-        pthread_mutex_unlock(&sSlpTxDebug.timeLock);
-        sleep(1);
-    }
-}
-
-static void SlpTxDebugPrintStatistics(void)
-{
-    pthread_mutex_lock(&gGenPrintLock);
-    pthread_mutex_lock(&sSlpTxDebug.timeLock);
-    printf("%s", asctime(&sSlpTxDebug.startTimeInfo));
-    printf("%s", asctime(&sSlpTxDebug.timeInfo));
-    pthread_mutex_unlock(&sSlpTxDebug.timeLock);
-    printf(
-        "SLP-tx statistics:\n"
-        " nr of data blocks received from APP %u\n"
-        " nr of sent data blocks %u\n"
-        " nr of received acks %u\n"
-        " nr of received nacks %u\n"
-        " nr of retransmitted data blocks %u\n"
-        " nr of retransmitted polls %u\n"
-        " nr of sent polls %u\n"
-        " nr of dropped acks by test method a) %u\n"
-        " nr of dropped acks by test method b) %u\n"
-        " nr of dropped nacks by test %u\n",
-        sSlpTxDebug.nrOfReceivedDataBlocksFromApp, sSlpTxDebug.nrOfSentDataBlocks,
-        sSlpTxDebug.nrOfReceivedAcks, sSlpTxDebug.nrOfReceivedNacks,
-        sSlpTxDebug.nrOfRetransmittedDataBlocks, sSlpTxDebug.nrOfRetransmittedPolls, sSlpTxDebug.nrOfSentPolls,
-        sSlpTxDebug.nrOfDroppedSuccessiveAcks, sSlpTxDebug.nrOfDroppedRandAcks, sSlpTxDebug.nrOfDroppedNacks);
-    pthread_mutex_unlock(&gGenPrintLock);
-}
-#endif
-
-static void SlpEndDataBlock(int pos, uint32_t flags)
-{
-    if (NULL != sSlpTxState.blockData[pos].pAppDataPtr) {
-        //ordinary APP data ack received: send DONE msg to APP
+        //ordinary APP data ack received: DONE to APP
         if (0 != (SLP_FLAGS_RECEIVER_RESET & flags)) {
-            SlpSendInfo(SLP_INFO_TYPE_DONE_AND_RX_RESET, sSlpTxState.seqNums[pos], 0);
+            SlpAddCompletion(pPending, SLP_INFO_TYPE_DONE_AND_RX_RESET, pReleased->seqNum, pReleased->appTag);
         } else {
-            SlpSendInfo(SLP_INFO_TYPE_DONE, sSlpTxState.seqNums[pos], 0);
+            SlpAddCompletion(pPending, SLP_INFO_TYPE_DONE, pReleased->seqNum, pReleased->appTag);
+        }
+
+        //referenced APP segments go back to APP, copies are freed
+        if (0 != (SLP_TX_WIN_FLAG_REF & pReleased->flags)) {
+            const SlpTxRef_t* pRef = pReleased->pAppDataPtr;
+
+            pRef->pRelease(pRef->pReleaseArg, pReleased->seqNum);
+        }
+
+        if (0 != (SLP_SUBHEADER_FLAG_URGENT & pReleased->flags)) {
+            atomic_fetch_sub_explicit(&sSlpTxNrOfUrgentDataBlocks, 1, memory_order_relaxed);
         }
 
         //Free dynamically allocated APP memory
-        free(sSlpTxState.blockData[pos].pAppDataPtr);
+        free(pReleased->pAppDataPtr);
     } else {
-        //poll ack received: send possible receiver reset to APP
+        //poll ack received: possible receiver reset to APP
         if (0 != (SLP_FLAGS_RECEIVER_RESET & flags)) {
-            SlpSendInfo(SLP_INFO_TYPE_RX_RESET, sSlpTxState.seqNums[pos], 0);
+            SlpAddCompletion(pPending, SLP_INFO_TYPE_RX_RESET, pReleased->seqNum, 0);
         }
-        //ack info to poll sending
-        SlpPollAckReceived(sSlpTxState.seqNums[pos]);
     }
-
-    //remove data block from SLP bookkeeping
-    SlpRemoveDataBlock(pos);
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-    SlpTxDebugPrintStatistics();
-#endif
 }
 
-static void SlpSave(SlpAppMsg_t* pRbuf, uint64_t seqNum, int nr)
+//saves data in the form it is sent, so retransmission doesn't compress again
+static void SlpSave(const uint8_t* pData, uint32_t len, uint32_t flags, uint64_t appTag, uint64_t seqNum)
 {
     void* pAppData;
 
-    pAppData = malloc(pRbuf->data.len);
+    pAppData = malloc(len);
     assert(NULL != pAppData);
-    memcpy(pAppData, pRbuf->data.appData, pRbuf->data.len);
-    assert(SLP_MAX_NR_OF_BLOCKS > nr);
-    sSlpTxState.blockData[nr].pAppDataPtr = pAppData;
-    sSlpTxState.blockData[nr].appLen = pRbuf->data.len;
-    sSlpTxState.seqNums[nr] = seqNum;
+    memcpy(pAppData, pData, len);
+    if (0 != (SLP_SUBHEADER_FLAG_URGENT & flags)) {
+        atomic_fetch_add_explicit(&sSlpTxNrOfUrgentDataBlocks, 1, memory_order_relaxed);
+    }
+    SlpTxWinPublish(seqNum, pAppData, len, flags, appTag);
+}
+
+//saves only segment descriptors, APP keeps buffers until release callback
+static void SlpSaveRef(const SlpIovec_t* pIov, const SlpSegment_t* pSegs, uint32_t nrOfSegs, uint32_t len, uint32_t flags, uint64_t seqNum)
+{
+    SlpTxRef_t* pRef;
+
+    pRef = malloc(sizeof(*pRef) + nrOfSegs * sizeof(pRef->segs[0]));
+    assert(NULL != pRef);
+    pRef->pRelease = pIov->pRelease;
+    pRef->pReleaseArg = pIov->pReleaseArg;
+    pRef->nrOfSegs = nrOfSegs;
+    memcpy(pRef->segs, pSegs, nrOfSegs * sizeof(pRef->segs[0]));
+    if (0 != (SLP_SUBHEADER_FLAG_URGENT & flags)) {
+        atomic_fetch_add_explicit(&sSlpTxNrOfUrgentDataBlocks, 1, memory_order_relaxed);
+    }
+    SlpTxWinPublish(seqNum, pRef, len, SLP_TX_WIN_FLAG_REF | flags, pIov->appTag);
 }
 
-static void SlpSendInnerMsg(SlpAppMsg_t* pRbuf, uint64_t seqNum)
+//APP data of pSbuf is already set by caller, e.g. gathered from segments
+static void SlpSendInnerMsg(SlpInnerMsg_t* pSbuf, uint32_t len, uint32_t flags, uint64_t appTag, uint64_t seqNum)
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
-    SlpInnerMsg_t sbuf;
 
     //get the message queue id for the key with value SLP_APP_DATA_MSG_QUEUE_KEY_ID
     key = SLP_INNER_APP_DATA_MSG_QUEUE_KEY_ID;
@@ -271,178 +328,417 @@ static void SlpSendInnerMsg(SlpAppMsg_t* pRbuf, uint64_t seqNum)
     }
 
     //send message type SLP_APP_DATA_MSG
-    sbuf.mtype = SLP_INNER_APP_DATA_MSG;
+    pSbuf->mtype = SLP_INNER_APP_DATA_MSG;
 
     //set SLP header and APP data
-    sbuf.data.slpHeader.subHeader.appDataLen =  pRbuf->data.len;
-    sbuf.data.slpHeader.subHeader.fill = 0; //not used
-
-    sbuf.data.slpHeader.subHeader.seqNum =  seqNum;
-    memcpy(sbuf.data.appData, pRbuf->data.appData, pRbuf->data.len);
-    if (SLP_APP_DATA_SIZE > pRbuf->data.len) {
-        memset(sbuf.data.appData + pRbuf->data.len, 0, SLP_APP_DATA_SIZE - pRbuf->data.len);
+    pSbuf->data.slpHeader.subHeader.appDataLen =  len;
+    pSbuf->data.slpHeader.subHeader.flags = flags;
+
+    pSbuf->data.slpHeader.subHeader.seqNum =  seqNum;
+    pSbuf->data.slpHeader.subHeader.appTag = appTag;
+    pSbuf->data.slpHeader.subHeader.txEpoch = sSlpTxState.epoch;
+    pSbuf->data.slpHeader.subHeader.rxEpoch = atomic_load_explicit(&sSlpTxState.rxEpoch, memory_order_acquire);
+    if (SLP_APP_DATA_SIZE > len) {
+        memset(pSbuf->data.appData + len, 0, SLP_APP_DATA_SIZE - len);
     }
-    sbuf.data.slpHeader.crc =  crcFast(((const uint8_t*) &sbuf.data.slpHeader.subHeader),
-         sizeof(sbuf.data.slpHeader.subHeader) + sbuf.data.slpHeader.subHeader.appDataLen);
-    sbuf.data.slpHeader.fill = 0; //not used
+    SlpSetIntegrity(&pSbuf->data.slpHeader,
+        sizeof(pSbuf->data.slpHeader.subHeader) + pSbuf->data.slpHeader.subHeader.appDataLen);
 
     if (sSlpTxDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
         printf("SlpSendInnerMsg: sent seqNum %lu and %u bytes with last byte %u\n",
-            sbuf.data.slpHeader.subHeader.seqNum, sbuf.data.slpHeader.subHeader.appDataLen, sbuf.data.appData[sbuf.data.slpHeader.subHeader.appDataLen - 1]);
+            pSbuf->data.slpHeader.subHeader.seqNum, pSbuf->data.slpHeader.subHeader.appDataLen, pSbuf->data.appData[pSbuf->data.slpHeader.subHeader.appDataLen - 1]);
         pthread_mutex_unlock(&gGenPrintLock);
     }
     if (gGenDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("SlpSendInnerMsg: seqNum %lu and len %u sent\n", sbuf.data.slpHeader.subHeader.seqNum, sbuf.data.slpHeader.subHeader.appDataLen);
+        printf("SlpSendInnerMsg: seqNum %lu and len %u sent\n", pSbuf->data.slpHeader.subHeader.seqNum, pSbuf->data.slpHeader.subHeader.appDataLen);
         pthread_mutex_unlock(&gGenPrintLock);
     }
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-    sSlpTxDebug.nrOfSentDataBlocks++;
-#endif
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_DATA_SENT, seqNum, len, flags);
+    GEN_STAT_INC(GEN_STAT_SLP_TX_SENT_DATA_BLOCKS);
 
     //send
-    if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
+    if (GenLinkSend(GEN_LINK_DATA, seqNum, msqid, pSbuf, sizeof(pSbuf->data)) < 0) {
         perror("msgsnd");
         exit(1);
     }
 }
 
-void* slp_tx_receive_app_data()
+static void SlpSendFecParity(void)
 {
     int msqid;
+    int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
-    SlpAppMsg_t rbuf;
-    int retVal;
+    SlpFecMsg_t* pSbuf = &sSlpTxFecMsg;
+
+    key = SLP_FEC_MSG_QUEUE_KEY_ID;
+    if ((msqid = msgget(key, msgflg)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    pSbuf->mtype = SLP_FEC_MSG;
+    pSbuf->data.slpHeader.subHeader.txEpoch = sSlpTxState.epoch;
+    pSbuf->data.slpHeader.subHeader.rxEpoch = atomic_load_explicit(&sSlpTxState.rxEpoch, memory_order_acquire);
+    SlpSetIntegrity(&pSbuf->data.slpHeader,
+        sizeof(pSbuf->data.slpHeader.subHeader) + sizeof(pSbuf->data.fecHeader) + pSbuf->data.slpHeader.subHeader.appDataLen);
+
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpSendFecParity: first seqNum %lu, seqNum mask 0x%lx, len %u\n",
+            pSbuf->data.slpHeader.subHeader.seqNum, pSbuf->data.fecHeader.seqNumMask, pSbuf->data.slpHeader.subHeader.appDataLen);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_FEC_PARITY_SENT, pSbuf->data.slpHeader.subHeader.seqNum,
+        pSbuf->data.slpHeader.subHeader.appDataLen, pSbuf->data.fecHeader.seqNumMask);
+    GEN_STAT_INC(GEN_STAT_SLP_TX_SENT_FEC_PARITY_BLOCKS);
+
+    //send
+    if (GenLinkSend(GEN_LINK_FEC, pSbuf->data.slpHeader.subHeader.seqNum, msqid, pSbuf, sizeof(pSbuf->data)) < 0) {
+        perror("msgsnd");
+        exit(1);
+    }
+
+    //next group starts from empty parity
+    pSbuf->data.fecHeader.seqNumMask = 0;
+}
+
+//adds sent data block to XOR parity of its group, groups are aligned to multiples of fecGroupSize
+static void SlpFecAdd(const uint8_t* pData, uint32_t len, uint32_t flags, uint64_t appTag, uint64_t seqNum)
+{
+    SlpFecData_t* pFec = &sSlpTxFecMsg.data;
+    uint32_t groupSize = gSlpLinkSettings.fecGroupSize;
+    uint64_t firstSeqNum;
+    uint32_t i;
+
+    if (0 == groupSize) return;
+    assert((8 * sizeof(pFec->fecHeader.seqNumMask)) >= groupSize);
+    firstSeqNum = seqNum - (seqNum % groupSize);
+
+    //send parity of previous group if it was left incomplete
+    if (pFec->fecHeader.seqNumMask && (firstSeqNum != pFec->slpHeader.subHeader.seqNum)) {
+        SlpSendFecParity();
+    }
+
+    if (0 == pFec->fecHeader.seqNumMask) {
+        pFec->slpHeader.subHeader.seqNum = firstSeqNum;
+        pFec->slpHeader.subHeader.appDataLen = 0;
+        pFec->slpHeader.subHeader.flags = 0;
+        pFec->slpHeader.subHeader.appTag = 0;
+        pFec->fecHeader.appDataLenXor = 0;
+        pFec->fecHeader.flagsXor = 0;
+        pFec->fecHeader.appTagXor = 0;
+        memset(pFec->parity, 0, sizeof(pFec->parity));
+    }
+
+    pFec->fecHeader.seqNumMask |= 1ULL << (seqNum - firstSeqNum);
+    pFec->fecHeader.appDataLenXor ^= len;
+    pFec->fecHeader.flagsXor ^= flags;
+    pFec->fecHeader.appTagXor ^= appTag;
+    for (i = 0; i < len; i++) {
+        pFec->parity[i] ^= pData[i];
+    }
+    if (pFec->slpHeader.subHeader.appDataLen < len) {
+        pFec->slpHeader.subHeader.appDataLen = len;
+    }
+
+    if ((groupSize - 1) == (seqNum - firstSeqNum)) {
+        SlpSendFecParity();
+    }
+}
+
+//APP data block from slp_tx_receive_app_data or slp_send, returns seqNum (slpId) of it
+uint64_t SlpTxSubmit(const uint8_t* pAppData, uint32_t appLen, uint64_t appTag, uint32_t priority, uint64_t submitNs)
+{
+    SlpIovec_t iov = {.pAppData = pAppData, .len = appLen, .appTag = appTag, .priority = priority};
+
+    return SlpTxSubmitv(&iov, 1, submitNs);
+}
+
+//saved bulk data blocks, urgent ones are counted as released only after they left the window
+static uint32_t SlpTxNrOfBulkDataBlocks(void)
+{
+    int nr = SlpTxWinNrOfDataBlocks(NULL) - atomic_load_explicit(&sSlpTxNrOfUrgentDataBlocks, memory_order_relaxed);
+
+    return (0 < nr) ? (uint32_t) nr : 0;
+}
+
+//bulk submitter waits until no urgent one waits for the lock and its blocks fit into window
+//without the urgent reserve, so that urgent blocks don't queue behind a full window of bulk ones
+static void SlpTxWaitForBulkTurn(uint32_t nr)
+{
+    pthread_mutex_lock(&sSlpTxBulkTurnLock);
+    while ((0 < atomic_load_explicit(&sSlpTxUrgentWaiters, memory_order_acquire)) ||
+        ((SLP_MAX_NR_OF_BLOCKS - SLP_URGENT_RESERVED_BLOCKS) < (SlpTxWinNrOfDataBlocks(NULL) + nr))) {
+        sSlpTxNrOfBulkWaiters++;
+        pthread_cond_wait(&sSlpTxBulkTurnCond, &sSlpTxBulkTurnLock);
+        sSlpTxNrOfBulkWaiters--;
+    }
+    pthread_mutex_unlock(&sSlpTxBulkTurnLock);
+}
+
+//window got room or urgent submitter got the lock: waiting bulk submitters check their turn again
+static void SlpTxBulkTurnChanged(void)
+{
+    pthread_mutex_lock(&sSlpTxBulkTurnLock);
+    if (0 < sSlpTxNrOfBulkWaiters) {
+        pthread_cond_broadcast(&sSlpTxBulkTurnCond);
+    }
+    pthread_mutex_unlock(&sSlpTxBulkTurnLock);
+}
+
+//APP data blocks from slp_sendv get consecutive seqNums by one reservation and lock,
+//returns seqNum (slpId) of the first one
+uint64_t SlpTxSubmitv(const SlpIovec_t* pIov, uint32_t nr, uint64_t submitNs)
+{
+    SlpInnerMsg_t* pMsg = &sSlpTxInnerMsg;
+    const SlpSegment_t* pSegs;
+    SlpSegment_t seg;
+    uint32_t nrOfSegs;
+    uint32_t appLen;
+    uint32_t len;
+    uint32_t flags;
+    uint32_t i;
+    int urgent = (SLP_PRIORITY_URGENT == pIov[0].priority);
+    uint32_t nrOfDataBlocks;
+    int appWaitChanged;
+    uint64_t copiedMask = 0; //lent blocks saved as compressed copies, released after submit lock
+    uint64_t firstSeqNum;
     uint64_t seqNum;
+    uint64_t nowNs;
 
-    //get the message queue id for the key with value APP_DATA_MSG_QUEUE_KEY_ID
-    key = SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID;
+    if (urgent) {
+        atomic_fetch_add_explicit(&sSlpTxUrgentWaiters, 1, memory_order_acq_rel);
+        pthread_mutex_lock(&sSlpTxSubmitLock);
+        atomic_fetch_sub_explicit(&sSlpTxUrgentWaiters, 1, memory_order_acq_rel);
+        SlpTxBulkTurnChanged();
+    } else {
+        SlpTxWaitForBulkTurn(nr);
+        pthread_mutex_lock(&sSlpTxSubmitLock);
+    }
+    assert((8 * sizeof(copiedMask)) >= nr);
 
-    //receive continuously message type APP_DATA_MSG
-    for (;;) {
-        usleep(GEN_THREAD_DELAY_US);
+    //reserve seqNums, submitters take turns under sSlpTxSubmitLock so the range is consecutive
+    firstSeqNum = SlpTxWinReserveRange(nr);
+    GEN_STAT_ADD(GEN_STAT_SLP_TX_DATA_BLOCKS_RECEIVED_FROM_APP, nr);
+    if (urgent) {
+        GEN_STAT_ADD(GEN_STAT_SLP_TX_URGENT_DATA_BLOCKS_RECEIVED_FROM_APP, nr);
+    }
+    nowNs = GenStatNowNs();
 
-        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
-            usleep(GEN_THREAD_DELAY_US);
-        }
-        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_DATA_SEND_MSG, 0);
-        if (0 > retVal) {
-            perror("msgrcv");
-            exit(1);
+    for (i = 0; i < nr; i++) {
+        seqNum = firstSeqNum + i;
+        if (NULL != pIov[i].pSegs) {
+            pSegs = pIov[i].pSegs;
+            nrOfSegs = pIov[i].nrOfSegs;
+        } else {
+            seg.pData = pIov[i].pAppData;
+            seg.len = pIov[i].len;
+            pSegs = &seg;
+            nrOfSegs = 1;
         }
 
-        if ((0 == rbuf.data.len) || (SLP_APP_DATA_SIZE < rbuf.data.len)) {
-            pthread_mutex_lock(&gGenPrintLock);
-            printf("slp_tx_receive_app_data: incorrect rbuf.appData.len %u",
-                rbuf.data.len);
-            pthread_mutex_unlock(&gGenPrintLock);
-            exit(1);
+        //compress once into message, send and possible retransmissions use the same form
+        flags = urgent ? SLP_SUBHEADER_FLAG_URGENT : 0;
+        if (gSlpLinkSettings.compression) {
+            const uint8_t* pIn = pSegs[0].pData;
+
+            appLen = pSegs[0].len;
+            if (1 < nrOfSegs) {
+                appLen = SlpTxGather(sSlpTxGatherBuf, pSegs, nrOfSegs);
+                pIn = sSlpTxGatherBuf;
+            }
+            if (SlpCompress(pIn, appLen, (SlpCompressedData_t*) pMsg->data.appData, &len)) {
+                flags |= SLP_SUBHEADER_FLAG_COMPRESSED;
+                GEN_STAT_INC(GEN_STAT_SLP_TX_COMPRESSED_DATA_BLOCKS);
+            }
         }
+        if (0 == (SLP_SUBHEADER_FLAG_COMPRESSED & flags)) {
+            len = appLen = SlpTxGather(pMsg->data.appData, pSegs, nrOfSegs);
+        }
+        assert((0 < appLen) && (SLP_APP_DATA_SIZE >= appLen));
 
-        //wait for poll sending
-        for (;;) {
-            pthread_mutex_lock(&gSlpTxLock);
-            if (sSlpTxState.pollSendingDecided) {
-                pthread_mutex_unlock(&gSlpTxLock);
-                usleep(SLP_WAIT_FOR_POLL_SENDING_US);
-            } else {
-                break;
+        //save data block for possible retransmission, by reference when APP lends its buffers
+        GenStatStamp(seqNum, GEN_STAT_STAMP_SUBMIT, submitNs);
+        if ((NULL != pIov[i].pRelease) && (0 == (SLP_SUBHEADER_FLAG_COMPRESSED & flags))) {
+            SlpSaveRef(&pIov[i], pSegs, nrOfSegs, len, flags, seqNum);
+        } else {
+            SlpSave(pMsg->data.appData, len, flags, pIov[i].appTag, seqNum);
+            if (NULL != pIov[i].pRelease) {
+                copiedMask |= 1ULL << i;
             }
         }
-        sSlpTxState.dataBlockSendingDecided = 1;
 
+        SlpJournalAppend(seqNum, pIov[i].appTag, pMsg->data.appData, len, flags);
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-        sSlpTxDebug.nrOfReceivedDataBlocksFromApp++;
-#endif
+        //send APP data block to SLP-rx
+        GenStatStamp(seqNum, GEN_STAT_STAMP_SEND, nowNs);
+        GenStatLatency(urgent ? GEN_STAT_LATENCY_URGENT_SUBMIT_TO_SEND : GEN_STAT_LATENCY_SUBMIT_TO_SEND, submitNs, nowNs);
+        SlpSendInnerMsg(pMsg, len, flags, pIov[i].appTag, seqNum);
+        SlpFecAdd(pMsg->data.appData, len, flags, pIov[i].appTag, seqNum);
+    }
 
-        //Read seqNumCount and nr of data blocks, save data block and increment counters during mutex is locked
-        seqNum = sSlpTxState.seqNumCount;
+    //with submit durability data blocks are on disk when slp_send or slp_sendv returns
+    if (SLP_JOURNAL_DURABILITY_SUBMIT == gSlpJournalSettings.durability) {
+        SlpJournalCommit();
+    }
 
-        //save data block for possible retransmission
-        SlpSave(&rbuf, seqNum, sSlpTxState.nrOfDataBlocks);
+    SlpProbeDataBlockSent();
+    pthread_mutex_lock(&sSlpTxAppWaitLock);
+    nrOfDataBlocks = SlpTxNrOfBulkDataBlocks();
+    appWaitChanged = !sSlpTxState.primaryAppWait && (gSlpLinkSettings.appWaitLimit <= nrOfDataBlocks);
+    if (appWaitChanged) {
+        sSlpTxState.primaryAppWait = 1;
+    }
+    pthread_mutex_unlock(&sSlpTxAppWaitLock);
 
-        //increment and release mutex
-        sSlpTxState.nrOfDataBlocks++;
-        sSlpTxState.seqNumCount++;
-        sSlpTxState.dataBlockSendingDecided = 0;
-        pthread_mutex_unlock(&gSlpTxLock);
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpTxSubmitv: seqNums %lu..%lu, nr of bulk data blocks %u, asked to wait %d\n",
+            firstSeqNum, firstSeqNum + nr - 1, nrOfDataBlocks, sSlpTxState.primaryAppWait);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+    pthread_mutex_unlock(&sSlpTxSubmitLock);
 
-        if (!sSlpTxState.primaryAppWait && (SLP_APP_WAIT_LIMIT <= sSlpTxState.nrOfDataBlocks)) {
-            sSlpTxState.primaryAppWait = 1;
-            if (!sSlpTxState.secondaryAppWait) {
-                SlpSendState(SLP_ASKS_APP_TO_WAIT);
-            }
+    //copied lent blocks go back to APP without SLP-tx locks, its release callback may call slp_send
+    for (i = 0; i < nr; i++) {
+        if (0 != (copiedMask & (1ULL << i))) {
+            pIov[i].pRelease(pIov[i].pReleaseArg, firstSeqNum + i);
         }
+    }
 
-        //send info to APP
-        SlpSendInfo(SLP_INFO_TYPE_APP_DATA_RECEIVED, seqNum, rbuf.data.genId);
+    if (appWaitChanged) {
+        SlpTxSendAppState();
+    }
+    return firstSeqNum;
+}
 
-        //send APP data block to SLP-rx
-        SlpSendInnerMsg(&rbuf, seqNum);
+//unacknowledged data block of previous run is saved again, it is resent once SLP threads run,
+//seqNums without a record were torn, they are saved without APP data and resent as bare seqNums
+static void SlpTxRecovered(uint64_t seqNum, uint64_t appTag, const uint8_t* pData, uint32_t len, uint32_t flags)
+{
+    uint64_t reservedSeqNum;
+    uint64_t nowNs = GenStatNowNs();
+
+    while ((reservedSeqNum = SlpTxWinReserve()) < seqNum) {
+        SlpTxWinPublish(reservedSeqNum, NULL, 0, 0, 0);
+    }
+    assert(reservedSeqNum == seqNum);
+    SlpSave(pData, len, flags, appTag, seqNum);
+    GenStatStamp(seqNum, GEN_STAT_STAMP_SUBMIT, nowNs);
+    GenStatStamp(seqNum, GEN_STAT_STAMP_SEND, nowNs);
+}
+
+//new SLP-tx session, it continues from journal of previous run if enabled,
+//called before any SLP thread is started
+void SlpTxInit(void)
+{
+    sSlpTxState.epoch = SlpNewEpoch();
+    GenTimerSetup(&sSlpProbeTimer, SlpProbeTimerExpired, NULL);
+    if (!gSlpJournalSettings.enabled) return;
+    pthread_mutex_lock(&sSlpTxSubmitLock);
+    SlpTxWinRestart(SlpJournalOpen());
+    SlpJournalRecover(SlpTxRecovered);
+
+    //recovered data blocks are only saved here, sending them could fill a SysV queue nobody reads yet:
+    //first probe goes when timer thread runs, SLP-rx asks to resync and resync resends the older ones
+    if (0 < SlpTxWinNrOfDataBlocks(NULL)) {
+        GenTimerArm(&sSlpProbeTimer, 0);
+    }
+    pthread_mutex_unlock(&sSlpTxSubmitLock);
+}
+
+//APP data blocks of one priority from their SysV queue
+static void SlpTxReceiveAppData(key_t key, long mtype, uint32_t priority)
+{
+    int msqid;
+    SlpAppMsg_t rbuf;
+    int retVal;
 
-        if (gGenDebugPrint) {
+    //receive continuously message type mtype
+    for (;;) {
+        usleep(GEN_THREAD_DELAY_US);
+
+        while ((msqid = msgget(key, MSG_FLAG)) < 0) {
+            usleep(GEN_THREAD_DELAY_US);
+        }
+        retVal = msgrcv(msqid, &rbuf, sizeof(rbuf.data), mtype, 0);
+        if (0 > retVal) {
+            perror("msgrcv");
+            exit(1);
+        }
+
+        if ((0 == rbuf.data.len) || (SLP_APP_DATA_SIZE < rbuf.data.len)) {
             pthread_mutex_lock(&gGenPrintLock);
-            printf("slp_tx_receive_app_data: seqNum %lu, nr of data blocks %u, asked to wait %d\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait);
+            printf("SlpTxReceiveAppData: incorrect rbuf.appData.len %u",
+                rbuf.data.len);
             pthread_mutex_unlock(&gGenPrintLock);
+            exit(1);
         }
+
+        SlpTxSubmit(rbuf.data.appData, rbuf.data.len, rbuf.data.genId, priority, rbuf.data.timeNs);
     }
 }
 
-#ifdef GEN_SLP_TEST_RAND_LOST
-int SlpTestRandOfThisSeqNum(uint64_t seqNum, int testCase)
+//APP data blocks from SysV queue, not started when APP uses slp_send
+void* slp_tx_receive_app_data()
 {
-    long r = rand();
-    long chance;
+    SlpTxReceiveAppData(SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID, SLP_APP_DATA_SEND_MSG, SLP_PRIORITY_BULK);
+    return NULL;
+}
 
-    //control chance to lower in case of high frequence messages: SLP_APP_DATA_MSG and SLP_ACK_MSG
-    if ((1 == testCase) || (3 == testCase)) {
-        chance = 0x100;
-    } else {
-        chance = 0x10;
-    }
+//urgent APP data blocks have own SysV queue, they don't wait behind bulk data backlog
+void* slp_tx_receive_urgent_app_data()
+{
+    SlpTxReceiveAppData(SLP_APP_URGENT_DATA_SEND_MSG_QUEUE_KEY_ID, SLP_APP_URGENT_DATA_SEND_MSG, SLP_PRIORITY_URGENT);
+    return NULL;
+}
 
-    if ((r % chance) == (seqNum % chance)) {
-        pthread_mutex_lock(&gGenPrintLock);
-        if (1 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: ack lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else if (2 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: nack lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else if (3 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: data block lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else if (4 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: retransmitted data block lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else if (5 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: retransmitted poll lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-               seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else if (6 == testCase) {
-            printf("SlpTestRandOfThisSeqNum/test executed: poll lost having seqNum %lu, nr of data blocks %d, asked to wait %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, r);
-        } else {
-            printf("SlpTestRandOfThisSeqNum/test executed: item lost having seqNum %lu, nr of data blocks %d, asked to wait %d, testCase %d, used random number %ld\n",
-                seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait, testCase, r);
-        }
-        pthread_mutex_unlock(&gGenPrintLock);
-        return 1;
+//data blocks arriving beyond gap from seqNum to gapEndSeqNum show that gap was lost rather than reordered,
+//it is resent once after fastRetransThreshold selective acks, NACK of SLP-rx covers a lost resend
+static void SlpSelectiveAckReceived(uint64_t seqNum, uint64_t gapEndSeqNum)
+{
+    uint64_t oldestSeqNum;
+    uint64_t endSeqNum;
+    int nr;
+
+    if (seqNum != sSlpFastRetransState.gapSeqNum) {
+        sSlpFastRetransState.gapSeqNum = seqNum;
+        sSlpFastRetransState.nrOfSelectiveAcks = 0;
+    }
+    sSlpFastRetransState.nrOfSelectiveAcks++;
+    if (gSlpLinkSettings.fastRetransThreshold != sSlpFastRetransState.nrOfSelectiveAcks) return;
+
+    //gap may have been acknowledged meanwhile, it ends at the latest to the newest saved data block,
+    //its start may have been resent by NACK or with the previous gap when that was filled only partly
+    nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+    if (seqNum < oldestSeqNum) return;
+    endSeqNum = (gapEndSeqNum < (oldestSeqNum + nr)) ? gapEndSeqNum : (oldestSeqNum + nr);
+    if (seqNum == atomic_load_explicit(&sSlpFastRetransState.nackedSeqNum, memory_order_relaxed)) {
+        seqNum++;
     }
-    return 0;
+    if (seqNum < sSlpFastRetransState.resentEndSeqNum) {
+        seqNum = sSlpFastRetransState.resentEndSeqNum;
+    }
+    for (nr = 0; (seqNum + nr) < endSeqNum; nr++) {
+        SlpRetransmit(seqNum + nr);
+    }
+    if (0 == nr) return;
+    sSlpFastRetransState.resentEndSeqNum = endSeqNum;
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_FAST_RETRANSMIT, seqNum, nr, sSlpFastRetransState.nrOfSelectiveAcks);
+    GEN_STAT_ADD(GEN_STAT_SLP_TX_FAST_RETRANSMITTED_DATA_BLOCKS, nr);
 }
-#endif
 
 void* slp_tx_receive_ack()
 {
     int msqid;
     key_t key;
     SlpShortMsg_t rbuf;
+    SlpTxReleased_t released[SLP_ACK_RELEASE_BATCH_SIZE];
     int retVal;
-    int     pos;
+    int appWaitChanged;
 
     //get the message queue id for the key with value SLP_ACK_MSG_QUEUE_KEY_ID
     key = SLP_ACK_MSG_QUEUE_KEY_ID;
@@ -459,100 +755,113 @@ void* slp_tx_receive_ack()
             exit(1);
         }
 
-        usleep(SLP_SIM_CTRL_MSG_TRANS_DELAY_US);
-
-#ifdef GEN_SLP_TEST_LOST_ACKS
-        //10 successive ACKs per 256 are lost
-        if ((100 == (rbuf.slpHeader.subHeader.seqNum % 0x100)) || (101 == (rbuf.slpHeader.subHeader.seqNum % 0x100))  ||
-           (102 == (rbuf.slpHeader.subHeader.seqNum % 0x100)) || (103 == (rbuf.slpHeader.subHeader.seqNum % 0x100))  ||
-           (104 == (rbuf.slpHeader.subHeader.seqNum % 0x100)) || (105 == (rbuf.slpHeader.subHeader.seqNum % 0x100))  ||
-           (106 == (rbuf.slpHeader.subHeader.seqNum % 0x100)) || (107 == (rbuf.slpHeader.subHeader.seqNum % 0x100))  ||
-           (108 == (rbuf.slpHeader.subHeader.seqNum % 0x100)) || (109 == (rbuf.slpHeader.subHeader.seqNum % 0x100)))  {
-            pthread_mutex_lock(&gGenPrintLock);
-            printf("slp_tx_receive_ack/test executed: ACK lost having seqNum %lu, nr of data blocks %d, asked to wait %d\n",
-                rbuf.slpHeader.subHeader.seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait);
-            pthread_mutex_unlock(&gGenPrintLock);
-            usleep(10000);
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-            sSlpTxDebug.nrOfDroppedSuccessiveAcks++;
-#endif
-            continue;
-        }
-#endif
-#ifdef GEN_SLP_TEST_RAND_LOST
-        if (SlpTestRandOfThisSeqNum(rbuf.slpHeader.subHeader.seqNum, 1)) {
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-            sSlpTxDebug.nrOfDroppedRandAcks++;
-#endif
-            continue;
-        }
-#endif
-        //crc must match
-        if (rbuf.slpHeader.crc == crcFast(((const uint8_t*) &rbuf.slpHeader.subHeader),
-            sizeof(rbuf.slpHeader.subHeader))) {
-            int     pos;
+        //integrity check must pass
+        if (SlpIsIntegrityOk(&rbuf.slpHeader, sizeof(rbuf.slpHeader.subHeader))) {
+            uint64_t seqNum = rbuf.slpHeader.subHeader.seqNum;
+            uint64_t oldestSeqNum;
+            uint32_t nrOfReleased = 0;
+            SlpCompletion_t pending = {0, 0, 0, 0};
+            int     nr;
             int     i;
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-            sSlpTxDebug.nrOfReceivedAcks++;
-#endif
+            if (0 != (SLP_FLAGS_RESYNC_REQUEST & rbuf.slpHeader.subHeader.appDataLen)) {
+                SlpResync(&rbuf.slpHeader.subHeader);
+                continue;
+            }
 
-            pthread_mutex_lock(&gSlpTxLock);
+            //acks of data blocks of an earlier session have nothing to release
+            if (sSlpTxState.epoch != rbuf.slpHeader.subHeader.txEpoch) continue;
 
-            //find saved data block having this seqNum
-            pos = binarySearch(sSlpTxState.seqNums, 0, sSlpTxState.nrOfDataBlocks - 1, rbuf.slpHeader.subHeader.seqNum);
-            if (0 > pos)
-            {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_tx_receive_ack: seqNum %lu not found!!!, nr of data blocks %d, oldest seqNum %lu\n",
-                    rbuf.slpHeader.subHeader.seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.seqNums[0]);
-                pthread_mutex_unlock(&gGenPrintLock);
-                pthread_mutex_unlock(&gSlpTxLock);
+            if (0 != (SLP_FLAGS_SELECTIVE_ACK & rbuf.slpHeader.subHeader.appDataLen)) {
+                SlpSelectiveAckReceived(seqNum, rbuf.slpHeader.subHeader.appTag);
                 continue;
             }
 
-            //print all data blocks from beginning to seqNum of this ACK
-            if (gGenDebugPrint) {
-                pthread_mutex_lock(&gGenPrintLock);
-                for (i = 0; i <= pos; i++) {
-                    printf("slp_tx_receive_ack: seqNums %lu/%lu, pos %d, nr of data blocks %d, asked to wait %d\n",
-                        rbuf.slpHeader.subHeader.seqNum,  sSlpTxState.seqNums[i], i, sSlpTxState.nrOfDataBlocks, sSlpTxState.primaryAppWait);
-                }
-                pthread_mutex_unlock(&gGenPrintLock);
+            GEN_STAT_INC(GEN_STAT_SLP_TX_RECEIVED_ACKS);
+            if (0 != (SLP_FLAGS_FEC_RECOVERED & rbuf.slpHeader.subHeader.appDataLen)) {
+                GEN_STAT_INC(GEN_STAT_SLP_TX_FEC_RECOVERED_DATA_BLOCKS);
             }
 
-            //end all blocks from pos down to beginning
-            for (i = pos; i >= 0; i--) {
-                //subHeader.appDataLen is in flag use: SLP_FLAGS_RECEIVER_RESET
-                SlpEndDataBlock(i, rbuf.slpHeader.subHeader.appDataLen);
-            }
+            //release all blocks from the oldest one up to seqNum of this ACK in batches,
+            //completions to APP and frees are done outside of gSlpTxLock
+            for (;;) {
+                nr = SlpTxWinRelease(seqNum, released, SLP_ACK_RELEASE_BATCH_SIZE);
+                if (0 > nr) {
+                    int nrOfDataBlocks = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
 
-            pthread_mutex_unlock(&gSlpTxLock);
+                    //ACK repeated for a probe whose original ACK arrived after all
+                    if (seqNum < oldestSeqNum) break;
+                    pthread_mutex_lock(&gGenPrintLock);
+                    printf("slp_tx_receive_ack: seqNum %lu not found!!!, nr of data blocks %d, oldest seqNum %lu\n",
+                        seqNum, nrOfDataBlocks, oldestSeqNum);
+                    pthread_mutex_unlock(&gGenPrintLock);
+                    break;
+                }
 
-            if (sSlpTxState.primaryAppWait && (SLP_APP_RESTART_LIMIT >= sSlpTxState.nrOfDataBlocks)) {
-                sSlpTxState.primaryAppWait = 0;
-                if (!sSlpTxState.secondaryAppWait) {
-                    SlpSendState(SLP_ASKS_APP_TO_GO_ON);
+                for (i = 0; i < nr; i++) {
+                    if (gGenDebugPrint) {
+                        pthread_mutex_lock(&gGenPrintLock);
+                        printf("slp_tx_receive_ack: seqNums %lu/%lu, asked to wait %d\n",
+                            seqNum, released[i].seqNum, sSlpTxState.primaryAppWait);
+                        pthread_mutex_unlock(&gGenPrintLock);
+                    }
+                    //subHeader.appDataLen is in flag use: SLP_FLAGS_RECEIVER_RESET
+                    SlpEndDataBlock(&released[i], rbuf.slpHeader.subHeader.appDataLen, &pending);
                 }
+                nrOfReleased += nr;
+                if ((0 == nr) || (seqNum == released[nr - 1].seqNum)) break;
+            }
+            SlpSendCompletion(&pending);
+            if (0 < nrOfReleased) {
+                SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+                SlpJournalRelease(oldestSeqNum);
+                SlpProbeAckReceived(seqNum);
+                SlpTxBulkTurnChanged();
+            }
+            GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_ACK_RECEIVED, seqNum, nrOfReleased, rbuf.slpHeader.subHeader.appDataLen);
+            if (0 > nr) continue;
+
+            pthread_mutex_lock(&sSlpTxAppWaitLock);
+            appWaitChanged = 0;
+            if (sSlpTxState.primaryAppWait && (gSlpLinkSettings.appRestartLimit >= SlpTxNrOfBulkDataBlocks())) {
+                sSlpTxState.primaryAppWait = 0;
+                appWaitChanged = 1;
             }
-#ifdef SLP_SECONDARY_APP_WAIT
             if (sSlpTxState.secondaryAppWait) {
                 sSlpTxState.secondaryAppWait = 0;
-                if (!sSlpTxState.primaryAppWait) {
-                    SlpSendState(SLP_ASKS_APP_TO_GO_ON);
-                }
+                appWaitChanged = 1;
+            }
+            pthread_mutex_unlock(&sSlpTxAppWaitLock);
+            if (appWaitChanged) {
+                SlpTxSendAppState();
             }
-#endif
         }
     }
 }
 
-static void SlpRetransmit(int pos)
+//returns 0 if seqNum isn't saved anymore
+static int SlpRetransmit(uint64_t seqNum)
 {
     int msqid;
     int msgflg = IPC_CREAT | MSG_FLAG;
     key_t key;
     SlpInnerMsg_t sbuf;
+    uint32_t appLen;
+    uint32_t flags;
+    uint64_t appTag;
+    int isPoll;
+
+    //copy saved data block, poll sending saves pure seqNum without any APP data
+    if (!SlpTxWinCopy(seqNum, sbuf.data.appData, &appLen, &flags, &appTag, &isPoll)) {
+        return 0;
+    }
+
+    //sanity check
+    if (!isPoll) {
+        assert(0 < appLen);
+    } else {
+        assert(0 == appLen);
+    }
 
     //get the message queue id for the key with value SLP_RETRANS_MSG_QUEUE_KEY_ID
     key = SLP_RETRANS_MSG_QUEUE_KEY_ID;
@@ -566,35 +875,24 @@ static void SlpRetransmit(int pos)
     sbuf.mtype = SLP_RETRANS_MSG;
 
     //set SLP header and APP data
-    sbuf.data.slpHeader.subHeader.appDataLen =  sSlpTxState.blockData[pos].appLen;
-    sbuf.data.slpHeader.subHeader.fill = 0; //not used
+    sbuf.data.slpHeader.subHeader.appDataLen = appLen;
+    sbuf.data.slpHeader.subHeader.flags = flags;
 
-    sbuf.data.slpHeader.subHeader.seqNum =  sSlpTxState.seqNums[pos];
+    sbuf.data.slpHeader.subHeader.seqNum = seqNum;
+    sbuf.data.slpHeader.subHeader.appTag = appTag;
+    sbuf.data.slpHeader.subHeader.txEpoch = sSlpTxState.epoch;
+    sbuf.data.slpHeader.subHeader.rxEpoch = atomic_load_explicit(&sSlpTxState.rxEpoch, memory_order_acquire);
 
-    //sanity check
-    if (NULL != sSlpTxState.blockData[pos].pAppDataPtr) {
-        assert(0 < sSlpTxState.blockData[pos].appLen);
-    } else {
-        assert(0 == sSlpTxState.blockData[pos].appLen);
+    if (SLP_APP_DATA_SIZE > appLen) {
+        memset(sbuf.data.appData + appLen, 0, SLP_APP_DATA_SIZE - appLen);
     }
 
-    //poll sending saves pure seqNum without any APP data when pAppDataPtr is set NULL
-    if (NULL != sSlpTxState.blockData[pos].pAppDataPtr) {
-        memcpy(sbuf.data.appData, sSlpTxState.blockData[pos].pAppDataPtr, sSlpTxState.blockData[pos].appLen);
-        if (SLP_APP_DATA_SIZE > sSlpTxState.blockData[pos].appLen) {
-            memset(sbuf.data.appData + sSlpTxState.blockData[pos].appLen, 0, SLP_APP_DATA_SIZE - sSlpTxState.blockData[pos].appLen);
-        }
-    } else {
-        memset(sbuf.data.appData, 0, SLP_APP_DATA_SIZE);
-    }
-
-    sbuf.data.slpHeader.crc =  crcFast(((const uint8_t*) &sbuf.data.slpHeader.subHeader),
-         sizeof(sbuf.data.slpHeader.subHeader) + sbuf.data.slpHeader.subHeader.appDataLen);
-    sbuf.data.slpHeader.fill = 0; //not used
+    SlpSetIntegrity(&sbuf.data.slpHeader,
+        sizeof(sbuf.data.slpHeader.subHeader) + sbuf.data.slpHeader.subHeader.appDataLen);
 
     if (gGenDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        if (0 < sSlpTxState.blockData[pos].appLen) {
+        if (0 < appLen) {
             printf("SlpRetransmit: retransmit APP data block message having seqNum %lu of %u bytes with last byte %u\n",
                 sbuf.data.slpHeader.subHeader.seqNum, sbuf.data.slpHeader.subHeader.appDataLen, sbuf.data.appData[sbuf.data.slpHeader.subHeader.appDataLen - 1]);
         } else {
@@ -604,28 +902,95 @@ static void SlpRetransmit(int pos)
         pthread_mutex_unlock(&gGenPrintLock);
     }
 
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-    if (0 < sSlpTxState.blockData[pos].appLen) {
-        sSlpTxDebug.nrOfRetransmittedDataBlocks++;
+    SlpProbeRetransmitted(seqNum);
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_RETRANSMITTED, seqNum, appLen, flags);
+    if (0 < appLen) {
+        GEN_STAT_INC(GEN_STAT_SLP_TX_RETRANSMITTED_DATA_BLOCKS);
     } else {
-        sSlpTxDebug.nrOfRetransmittedPolls++;
+        GEN_STAT_INC(GEN_STAT_SLP_TX_RETRANSMITTED_POLLS);
     }
-#endif
 
     //send
-    if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
+    if (GenLinkSend(GEN_LINK_RETRANS, seqNum, msqid, &sbuf, sizeof(sbuf.data)) < 0) {
+        perror("msgsnd");
+        exit(1);
+    }
+    return 1;
+}
+
+//tells SLP-rx of rxEpoch to continue from seqNum, sent in retransmission queue ahead of resent window
+static void SlpSendResync(uint64_t seqNum, uint32_t rxEpoch)
+{
+    int msqid;
+    int msgflg = IPC_CREAT | MSG_FLAG;
+    key_t key;
+    SlpShortMsg_t sbuf;
+
+    key = SLP_RETRANS_MSG_QUEUE_KEY_ID;
+    if ((msqid = msgget(key, msgflg)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    sbuf.mtype = SLP_RETRANS_MSG;
+    sbuf.slpHeader.subHeader.appDataLen = 0;
+    sbuf.slpHeader.subHeader.flags = SLP_SUBHEADER_FLAG_RESYNC;
+    sbuf.slpHeader.subHeader.seqNum = seqNum;
+    sbuf.slpHeader.subHeader.appTag = 0;
+    sbuf.slpHeader.subHeader.txEpoch = sSlpTxState.epoch;
+    sbuf.slpHeader.subHeader.rxEpoch = rxEpoch;
+    SlpSetIntegrity(&sbuf.slpHeader, sizeof(sbuf.slpHeader.subHeader));
+
+    if (GenLinkSend(GEN_LINK_RETRANS, seqNum, msqid, &sbuf, sizeof(sbuf.slpHeader)) < 0) {
         perror("msgsnd");
         exit(1);
     }
 }
 
+/*
+SLP-rx of rxEpoch doesn't know this session: it was reset or this SLP-tx was.
+It continues from the oldest unacknowledged seqNum and the whole window is resent after the answer,
+so in-flight data blocks reach it within one round trip without waiting for NACKs or polls.
+Data blocks acknowledged by an earlier SLP-rx were delivered already and aren't resent.
+A repeated request of the same SLP-rx gets only the answer, possible gaps are NACKed after it.
+*/
+static void SlpResync(const SlpSubHeader_t* pRequest)
+{
+    uint32_t rxEpoch = pRequest->rxEpoch;
+    uint64_t oldestSeqNum;
+    uint64_t seqNum;
+    int nr;
+
+    nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+    SlpSendResync(oldestSeqNum, rxEpoch);
+    if (rxEpoch == atomic_load_explicit(&sSlpTxState.rxEpoch, memory_order_acquire)) {
+        nr = 0;
+    } else if ((sSlpTxState.epoch == pRequest->txEpoch) && (pRequest->seqNum < (oldestSeqNum + nr))) {
+        //SLP-rx has saved data blocks of this session from seqNum on, only older ones are resent
+        nr = (pRequest->seqNum > oldestSeqNum) ? (int) (pRequest->seqNum - oldestSeqNum) : 0;
+    }
+    atomic_store_explicit(&sSlpTxState.rxEpoch, rxEpoch, memory_order_release);
+    for (seqNum = oldestSeqNum; seqNum < (oldestSeqNum + nr); seqNum++) {
+        SlpRetransmit(seqNum);
+    }
+
+    if (gGenDebugPrint) {
+        pthread_mutex_lock(&gGenPrintLock);
+        printf("SlpResync: SLP-rx session %u continues from seqNum %lu, %d data blocks resent\n", rxEpoch, oldestSeqNum, nr);
+        pthread_mutex_unlock(&gGenPrintLock);
+    }
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_RESYNC_SENT, oldestSeqNum, nr, rxEpoch);
+    GEN_STAT_INC(GEN_STAT_SLP_TX_RESYNCS);
+}
+
 void* slp_tx_receive_nack()
 {
     int msqid;
     key_t key;
     SlpShortMsg_t rbuf;
     int retVal;
-    int     pos;
+    int found;
+    int appWaitChanged;
+    uint64_t oldestSeqNum;
 
     //get the message queue id for the key with value SLP_NACK_MSG_QUEUE_KEY_ID
     key = SLP_NACK_MSG_QUEUE_KEY_ID;
@@ -642,38 +1007,11 @@ void* slp_tx_receive_nack()
             exit(1);
         }
 
-        usleep(SLP_SIM_SMALL_CTRL_MSG_TRANS_DELAY_US);
-
-#ifdef GEN_SLP_TEST_RAND_LOST
-        if (SlpTestRandOfThisSeqNum(rbuf.slpHeader.subHeader.seqNum, 2)) {
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-            sSlpTxDebug.nrOfDroppedNacks++;
-#endif
-            continue;
-        }
-#endif
-
-        //crc must match
-        if (rbuf.slpHeader.crc == crcFast(((const uint8_t*) &rbuf.slpHeader.subHeader),
-            sizeof(rbuf.slpHeader.subHeader))) {
-
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-           sSlpTxDebug.nrOfReceivedNacks++;
-#endif
+        //integrity check must pass, nacks of an earlier session are stale
+        if (SlpIsIntegrityOk(&rbuf.slpHeader, sizeof(rbuf.slpHeader.subHeader)) &&
+            (sSlpTxState.epoch == rbuf.slpHeader.subHeader.txEpoch)) {
 
-            //find saved data block having this seqNum
-            pthread_mutex_lock(&gSlpTxLock);
-            pos = binarySearch(sSlpTxState.seqNums, 0, sSlpTxState.nrOfDataBlocks - 1, rbuf.slpHeader.subHeader.seqNum);
-            if (0 > pos)
-            {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_receive_nack: seqNum %lu not found!!!, nr of data blocks %d, oldest seqNum %lu\n",
-                    rbuf.slpHeader.subHeader.seqNum, sSlpTxState.nrOfDataBlocks, sSlpTxState.seqNums[0]);
-                pthread_mutex_unlock(&gGenPrintLock);
-                pthread_mutex_unlock(&gSlpTxLock);
-                continue;
-            }
-            assert(rbuf.slpHeader.subHeader.seqNum == sSlpTxState.seqNums[pos]);
+           GEN_STAT_INC(GEN_STAT_SLP_TX_RECEIVED_NACKS);
 
             if (gGenDebugPrint) {
                 pthread_mutex_lock(&gGenPrintLock);
@@ -682,191 +1020,129 @@ void* slp_tx_receive_nack()
                 pthread_mutex_unlock(&gGenPrintLock);
             }
 
-            //retransmit
-            SlpRetransmit(pos);
-            pthread_mutex_unlock(&gSlpTxLock);
+            //retransmit saved data block having this seqNum
+            atomic_store_explicit(&sSlpFastRetransState.nackedSeqNum, rbuf.slpHeader.subHeader.seqNum, memory_order_relaxed);
+            found = SlpRetransmit(rbuf.slpHeader.subHeader.seqNum);
+            GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_NACK_RECEIVED, rbuf.slpHeader.subHeader.seqNum, found, rbuf.slpHeader.subHeader.appDataLen);
+            if (!found) {
+                int nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+
+                pthread_mutex_lock(&gGenPrintLock);
+                printf("slp_receive_nack: seqNum %lu not found!!!, nr of data blocks %d, oldest seqNum %lu\n",
+                    rbuf.slpHeader.subHeader.seqNum, nr, oldestSeqNum);
+                pthread_mutex_unlock(&gGenPrintLock);
+                continue;
+            }
 
             if (0 != (SLP_FLAGS_RECEIVER_RESET & rbuf.slpHeader.subHeader.appDataLen)) {
-                SlpSendInfo(SLP_INFO_TYPE_RX_RESET, sSlpTxState.seqNums[pos], 0);
+                SlpCompletion_t completion = {rbuf.slpHeader.subHeader.seqNum, 0, 1, SLP_INFO_TYPE_RX_RESET};
+
+                SlpSendCompletion(&completion);
             }
-#ifdef SLP_SECONDARY_APP_WAIT
-            if (!sSlpTxState.secondaryAppWait) {
+            pthread_mutex_lock(&sSlpTxAppWaitLock);
+            appWaitChanged = gSlpLinkSettings.secondaryAppWait && !sSlpTxState.secondaryAppWait;
+            if (appWaitChanged) {
                 sSlpTxState.secondaryAppWait = 1;
-                if (!sSlpTxState.primaryAppWait) {
-                    SlpSendState(SLP_ASKS_APP_TO_WAIT);
-                }
             }
-#endif
+            pthread_mutex_unlock(&sSlpTxAppWaitLock);
+            if (appWaitChanged) {
+                SlpTxSendAppState();
+            }
         }
     }
 }
 
-#define SLP_POLL_PTHREAD_PERIOD_US     1000
-#define SLP_POLL_CHECK_TIME_US         (3*SLP_SIMULATED_TRANSFER_DELAY_US)
-#define SLP_POLL_ACK_TIMEOUT_MS        (SLP_POLL_CHECK_TIME_US/SLP_POLL_PTHREAD_PERIOD_US)
+#define SLP_PROBE_MAX_BACKOFF           4 //probe timeout doubles at most this many times
 
-typedef struct SlpPollState_t {
-    int      waitForPollAck;
-    uint64_t pollAckWaitSeqNum;
-    int      pollTimeoutCount;
-} SlpPollState_t;
+//two smoothed round trips, doubled for each probe left without ACK progress,
+//round trip of the emulated link is assumed until the first ACK
+static uint32_t SlpProbeTimeoutUs(void)
+{
+    uint64_t us = 2 * atomic_load_explicit(&sSlpProbeState.srttNs, memory_order_relaxed) / 1000;
+    uint32_t shift = atomic_load_explicit(&sSlpProbeState.nrOfProbes, memory_order_relaxed);
 
-SlpPollState_t sSlpPrevPollState;
+    if (0 == us) {
+        us = 2 * (GenLinkMaxDelayUs(GEN_LINK_DATA) + GenLinkMaxDelayUs(GEN_LINK_ACK));
+    }
 
+    if (us < gSlpLinkSettings.probeMinTimeoutUs) {
+        us = gSlpLinkSettings.probeMinTimeoutUs;
+    }
+    if (SLP_PROBE_MAX_BACKOFF < shift) {
+        shift = SLP_PROBE_MAX_BACKOFF;
+    }
+    us <<= shift;
+    return (UINT32_MAX < us) ? UINT32_MAX : (uint32_t) us;
+}
 
-static void SlpPollAckReceived(uint64_t seqNum)
+//ACK released data blocks: round trip sample of seqNum, probe waits again for two round trips
+static void SlpProbeAckReceived(uint64_t seqNum)
 {
-    if (seqNum == sSlpPrevPollState.pollAckWaitSeqNum) {
-        sSlpPrevPollState.waitForPollAck = 0;
+    uint64_t sendNs = GenStatGetStamp(seqNum, GEN_STAT_STAMP_SEND);
+    uint64_t srttNs = atomic_load_explicit(&sSlpProbeState.srttNs, memory_order_relaxed);
+    int64_t deltaNs;
+
+    if ((0 != sendNs) && (seqNum >= atomic_load_explicit(&sSlpProbeState.retransmittedEndSeqNum, memory_order_relaxed))) {
+        deltaNs = (int64_t) (GenStatNowNs() - sendNs) - (int64_t) srttNs;
+        srttNs = (0 == srttNs) ? (srttNs + deltaNs) : (srttNs + deltaNs / 8);
+        atomic_store_explicit(&sSlpProbeState.srttNs, srttNs, memory_order_relaxed);
+    }
+    atomic_store_explicit(&sSlpProbeState.nrOfProbes, 0, memory_order_relaxed);
+    if (0 < SlpTxWinNrOfDataBlocks(NULL)) {
+        GenTimerArm(&sSlpProbeTimer, SlpProbeTimeoutUs());
+    } else {
+        GenTimerCancel(&sSlpProbeTimer);
     }
 }
 
-static int SlpShouldPollBeSent(uint64_t* pSeqNum, int* pNr)
+//ACKs up to retransmitted seqNum give no round trip sample, NACK, ACK and timer threads may race to raise the end
+static void SlpProbeRetransmitted(uint64_t seqNum)
 {
-    int retVal = 0;
-    int checkThis = 0;
-    int nr;
-    uint64_t seqNum;
-    uint64_t prevSeqNum;
+    uint64_t endSeqNum = atomic_load_explicit(&sSlpProbeState.retransmittedEndSeqNum, memory_order_relaxed);
 
-    if (sSlpPrevPollState.waitForPollAck) {
-        if (SLP_POLL_ACK_TIMEOUT_MS > sSlpPrevPollState.pollTimeoutCount) {
-            sSlpPrevPollState.pollTimeoutCount++;
-            return 0;
-        }
+    while ((endSeqNum <= seqNum) &&
+        !atomic_compare_exchange_weak_explicit(&sSlpProbeState.retransmittedEndSeqNum, &endSeqNum, seqNum + 1,
+            memory_order_relaxed, memory_order_relaxed)) {
     }
-    sSlpPrevPollState.waitForPollAck = 0;
-
-    //read essential values
-    pthread_mutex_lock(&gSlpTxLock);
-    nr = sSlpTxState.nrOfDataBlocks;
-    seqNum = sSlpTxState.seqNums[0];
-    pthread_mutex_unlock(&gSlpTxLock);
+}
 
-    if (0 < nr) {
-        prevSeqNum = seqNum;
-        checkThis = 1;
+//sent data block is covered by probe timer unless ACKs already keep it running
+static void SlpProbeDataBlockSent(void)
+{
+    if (!GenTimerIsArmed(&sSlpProbeTimer)) {
+        GenTimerArm(&sSlpProbeTimer, SlpProbeTimeoutUs());
     }
+}
 
-    //wait
-    usleep(SLP_POLL_CHECK_TIME_US);
+/*
+No ACK progress for two round trips while data blocks are unacknowledged: tail of a burst or its ACKs were lost
+and there are no later data blocks whose arrival would reveal the gap. The newest saved data block is resent
+as probe. SLP-rx saves it beyond the gap and NACKs or selective acks it, or acknowledges it again if it was
+received already, so the tail recovers without a poll taking a seqNum of its own.
+*/
+static void SlpProbeTimerExpired(void* pArg)
+{
+    uint64_t oldestSeqNum;
+    uint64_t seqNum;
+    int nr;
 
-    if (checkThis) {
-        //read essential values again
-        pthread_mutex_lock(&gSlpTxLock);
-        nr = sSlpTxState.nrOfDataBlocks;
-        seqNum = sSlpTxState.seqNums[0];
-        pthread_mutex_unlock(&gSlpTxLock);
+    (void) pArg;
+    nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+    if (0 == nr) return;
 
-        if (0 < nr) {
-            //send poll if still same oldest seqNum
-            //because probably communication is stuck
-            if (prevSeqNum == seqNum) {
-                retVal = 1;
-            }
-        }
+    //newest reserved seqNum may not be saved yet
+    for (seqNum = oldestSeqNum + nr; seqNum > oldestSeqNum; seqNum--) {
+        if (SlpRetransmit(seqNum - 1)) break;
     }
-    if (!retVal) return 0;
-    sSlpPrevPollState.pollTimeoutCount = 0;
-    sSlpPrevPollState.waitForPollAck = 1;
-    *pSeqNum = seqNum;
-    *pNr = nr;
     if (gGenDebugPrint) {
         pthread_mutex_lock(&gGenPrintLock);
-        printf("SlpShouldPollBeSent: is returning 1, read seqNum %lu and nr %d\n",
-            seqNum, nr);
+        printf("SlpProbeTimerExpired: probe seqNum %lu, oldest seqNum %lu, nr %d, srtt %lu ns\n",
+            seqNum - 1, oldestSeqNum, nr, (uint64_t) atomic_load_explicit(&sSlpProbeState.srttNs, memory_order_relaxed));
         pthread_mutex_unlock(&gGenPrintLock);
     }
-    return 1;
-}
-
-void* slp_tx_send_poll()
-{
-    uint64_t seqNum;
-    int nr;
-
-    for (;;) {
-        usleep(SLP_POLL_PTHREAD_PERIOD_US);
-        if (SlpShouldPollBeSent(&seqNum, &nr)) {
-            struct msqid_ds qbuf;
-            int msqid;
-            int msgflg = IPC_CREAT | MSG_FLAG;
-            key_t key;
-            SlpShortMsg_t sbuf;
-
-            key = SLP_POLL_MSG_QUEUE_KEY_ID;
-            if ((msqid = msgget(key, msgflg)) < 0) {
-                perror("msgget");
-                exit(1);
-            }
+    GEN_TRACE_EVENT(GEN_TRACE_SLP_TX_PROBE_SENT, seqNum - 1, nr, oldestSeqNum);
+    GEN_STAT_INC(GEN_STAT_SLP_TX_SENT_PROBES);
 
-            //Compare originally read: seqNum and nr to real values and cancel sending if changed,
-            //save data block and increment counters during mutex is locked
-            if ((seqNum != sSlpTxState.seqNums[0]) || (nr != sSlpTxState.nrOfDataBlocks)) {
-                if (gGenDebugPrint) {
-                    pthread_mutex_lock(&gGenPrintLock);
-                    printf("slp_send_possible_poll: sending cancelled due to changed seqNum or nr, seqNums %lu/%lu and nrs %d/%d\n",
-                        seqNum, sSlpTxState.seqNums[0], nr, sSlpTxState.nrOfDataBlocks);
-                    pthread_mutex_unlock(&gGenPrintLock);
-                }
-                pthread_mutex_unlock(&gSlpTxLock);
-                continue;
-            }
-
-            //cancel sending if data block sending decided
-            pthread_mutex_lock(&gSlpTxLock);
-            if (sSlpTxState.dataBlockSendingDecided) {
-                pthread_mutex_unlock(&gSlpTxLock);
-                continue;
-            }
-            sSlpTxState.pollSendingDecided = 1;
-
-            //save data block for ack
-            assert(SLP_MAX_NR_OF_BLOCKS > sSlpTxState.nrOfDataBlocks);
-            sSlpTxState.blockData[sSlpTxState.nrOfDataBlocks].pAppDataPtr = NULL;
-            sSlpTxState.blockData[sSlpTxState.nrOfDataBlocks].appLen = 0;
-            seqNum = sSlpTxState.seqNumCount;
-            sSlpTxState.seqNums[sSlpTxState.nrOfDataBlocks] = seqNum;
-
-            //increment and release mutex
-            sSlpTxState.nrOfDataBlocks++;
-            sSlpTxState.seqNumCount++;
-            sSlpTxState.pollSendingDecided = 0;
-            pthread_mutex_unlock(&gSlpTxLock);
-
-            sSlpPrevPollState.pollAckWaitSeqNum = seqNum;
-
-            if (!sSlpTxState.primaryAppWait && (SLP_APP_WAIT_LIMIT <= sSlpTxState.nrOfDataBlocks)) {
-                sSlpTxState.primaryAppWait = 1;
-                if (!sSlpTxState.secondaryAppWait) {
-                    SlpSendState(SLP_ASKS_APP_TO_WAIT);
-                }
-            }
-
-            //set data to buffer to be sent
-            sbuf.mtype = SLP_POLL_MSG;
-            sbuf.slpHeader.subHeader.fill = 0; //not used
-            sbuf.slpHeader.subHeader.appDataLen = 0;
-            sbuf.slpHeader.subHeader.seqNum = seqNum;
-            sbuf.slpHeader.crc =  crcFast(((const uint8_t*) &sbuf.slpHeader.subHeader),
-                sizeof(sbuf.slpHeader.subHeader));
-            sbuf.slpHeader.fill = 0; //not used
-
-            if (sSlpTxDebugPrint) {
-                pthread_mutex_lock(&gGenPrintLock);
-                printf("slp_tx_send_poll: seqNum %lu, nr %d\n", seqNum, nr);
-                pthread_mutex_unlock(&gGenPrintLock);
-            }
-
-#ifdef GEN_SLP_TX_DEBUG_STATISTICS
-            sSlpTxDebug.nrOfSentPolls++;
-#endif
-
-            //send
-            if (msgsnd(msqid, &sbuf, sizeof(sbuf.slpHeader), 0) < 0) {
-                perror("msgsnd");
-                exit(1);
-            }
-        }
-    }
+    atomic_fetch_add_explicit(&sSlpProbeState.nrOfProbes, 1, memory_order_relaxed);
+    GenTimerArm(&sSlpProbeTimer, SlpProbeTimeoutUs());
 }
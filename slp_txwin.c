@@ -0,0 +1,170 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+#include "common.h"
+#include "gen_if.h"
+#include "msg.h"
+#include "slp_if.h"
+#include "slp.h"
+
+pthread_mutex_t gSlpTxLock;
+
+typedef struct SlpTxBlock_t {
+    atomic_uint_fast64_t    published; //seqNum + 1 when block is saved, 0 when slot is free
+    void*                   pAppDataPtr; //NULL for poll
+    uint32_t                appLen;
+    uint32_t                flags; //subHeader flags of saved data, e.g. compressed
+    uint64_t                appTag;
+} SlpTxBlock_t;
+
+//Block of seqNum is in slot seqNum % SLP_MAX_NR_OF_BLOCKS
+typedef struct SlpTxWin_t {
+    atomic_uint_fast64_t    seqNumCount; //next seqNum to reserve
+    uint8_t                 pad[64 - sizeof(atomic_uint_fast64_t)];
+    atomic_uint_fast64_t    oldestSeqNum; //changed only under gSlpTxLock
+    SlpTxBlock_t            blocks[SLP_MAX_NR_OF_BLOCKS];
+} SlpTxWin_t;
+
+static SlpTxWin_t sSlpTxWin;
+
+static SlpTxBlock_t* SlpTxWinBlock(uint64_t seqNum)
+{
+    return &sSlpTxWin.blocks[seqNum & (SLP_MAX_NR_OF_BLOCKS - 1)];
+}
+
+//returns next seqNum, waits if window is full until oldest blocks are acknowledged
+uint64_t SlpTxWinReserve(void)
+{
+    return SlpTxWinReserveRange(1);
+}
+
+//returns first of nr consecutive seqNums, waits until the last one fits into window
+uint64_t SlpTxWinReserveRange(uint32_t nr)
+{
+    uint64_t seqNum;
+
+    assert((0 < nr) && (SLP_MAX_NR_OF_BLOCKS >= nr));
+    seqNum = atomic_fetch_add_explicit(&sSlpTxWin.seqNumCount, nr, memory_order_relaxed);
+    while ((seqNum + nr - 1 - atomic_load_explicit(&sSlpTxWin.oldestSeqNum, memory_order_acquire)) >= SLP_MAX_NR_OF_BLOCKS) {
+        usleep(GEN_SMALL_THREAD_DELAY_US);
+    }
+    return seqNum;
+}
+
+//copies segments one after another, returns total length
+uint32_t SlpTxGather(uint8_t* pDst, const SlpSegment_t* pSegs, uint32_t nrOfSegs)
+{
+    uint32_t len = 0;
+    uint32_t i;
+
+    for (i = 0; i < nrOfSegs; i++) {
+        memcpy(pDst + len, pSegs[i].pData, pSegs[i].len);
+        len += pSegs[i].len;
+    }
+    return len;
+}
+
+//saves reserved block, window takes ownership of malloc'ed pAppDataPtr,
+//with SLP_TX_WIN_FLAG_REF it is SlpTxRef_t whose segments stay APP's
+void SlpTxWinPublish(uint64_t seqNum, void* pAppDataPtr, uint32_t appLen, uint32_t flags, uint64_t appTag)
+{
+    SlpTxBlock_t* pBlock = SlpTxWinBlock(seqNum);
+
+    pBlock->pAppDataPtr = pAppDataPtr;
+    pBlock->appLen = appLen;
+    pBlock->flags = flags;
+    pBlock->appTag = appTag;
+    atomic_store_explicit(&pBlock->published, seqNum + 1, memory_order_release);
+}
+
+/*
+Releases blocks from the oldest one up to seqNum (cumulative ack), at most maxNr at a time.
+Released APP data is handed to caller to be freed outside of the lock.
+Returns nr of released blocks, -1 if seqNum isn't in window.
+*/
+int SlpTxWinRelease(uint64_t seqNum, SlpTxReleased_t* pReleased, int maxNr)
+{
+    SlpTxBlock_t* pBlock;
+    uint64_t oldestSeqNum;
+    int nr = 0;
+
+    pthread_mutex_lock(&gSlpTxLock);
+    oldestSeqNum = atomic_load_explicit(&sSlpTxWin.oldestSeqNum, memory_order_relaxed);
+    if ((seqNum < oldestSeqNum) || (seqNum >= atomic_load_explicit(&sSlpTxWin.seqNumCount, memory_order_relaxed))) {
+        pthread_mutex_unlock(&gSlpTxLock);
+        return -1;
+    }
+
+    //stop at first reserved but not yet saved block, it hasn't been sent
+    while ((oldestSeqNum <= seqNum) && (nr < maxNr)) {
+        pBlock = SlpTxWinBlock(oldestSeqNum);
+        if ((oldestSeqNum + 1) != atomic_load_explicit(&pBlock->published, memory_order_acquire)) break;
+        pReleased[nr].seqNum = oldestSeqNum;
+        pReleased[nr].pAppDataPtr = pBlock->pAppDataPtr;
+        pReleased[nr].flags = pBlock->flags;
+        pReleased[nr].appTag = pBlock->appTag;
+        pBlock->pAppDataPtr = NULL;
+        atomic_store_explicit(&pBlock->published, 0, memory_order_relaxed);
+        oldestSeqNum++;
+        nr++;
+    }
+    atomic_store_explicit(&sSlpTxWin.oldestSeqNum, oldestSeqNum, memory_order_release);
+    pthread_mutex_unlock(&gSlpTxLock);
+    return nr;
+}
+
+//copies saved block for retransmission, returns 0 if seqNum isn't in window
+int SlpTxWinCopy(uint64_t seqNum, uint8_t* pAppData, uint32_t* pAppLen, uint32_t* pFlags, uint64_t* pAppTag, int* pIsPoll)
+{
+    SlpTxBlock_t* pBlock = SlpTxWinBlock(seqNum);
+
+    pthread_mutex_lock(&gSlpTxLock);
+    if ((seqNum < atomic_load_explicit(&sSlpTxWin.oldestSeqNum, memory_order_relaxed)) ||
+        ((seqNum + 1) != atomic_load_explicit(&pBlock->published, memory_order_acquire))) {
+        pthread_mutex_unlock(&gSlpTxLock);
+        return 0;
+    }
+    *pIsPoll = (NULL == pBlock->pAppDataPtr);
+    *pAppLen = pBlock->appLen;
+    *pFlags = pBlock->flags & ~SLP_TX_WIN_FLAG_REF;
+    *pAppTag = pBlock->appTag;
+    if (0 != (SLP_TX_WIN_FLAG_REF & pBlock->flags)) {
+        const SlpTxRef_t* pRef = pBlock->pAppDataPtr;
+
+        SlpTxGather(pAppData, pRef->segs, pRef->nrOfSegs);
+    } else if (!*pIsPoll) {
+        memcpy(pAppData, pBlock->pAppDataPtr, pBlock->appLen);
+    }
+    pthread_mutex_unlock(&gSlpTxLock);
+    return 1;
+}
+
+//lock free snapshot: nr of reserved but not acknowledged blocks and the oldest seqNum
+int SlpTxWinNrOfDataBlocks(uint64_t* pOldestSeqNum)
+{
+    uint64_t oldestSeqNum = atomic_load_explicit(&sSlpTxWin.oldestSeqNum, memory_order_acquire);
+    uint64_t seqNumCount = atomic_load_explicit(&sSlpTxWin.seqNumCount, memory_order_relaxed);
+
+    if (NULL != pOldestSeqNum) *pOldestSeqNum = oldestSeqNum;
+    if (seqNumCount < oldestSeqNum) return 0;
+    return (int) (seqNumCount - oldestSeqNum);
+}
+
+//empty window continues from seqNum, e.g. from the oldest data block recovered from journal
+void SlpTxWinRestart(uint64_t seqNum)
+{
+    assert(0 == SlpTxWinNrOfDataBlocks(NULL));
+    atomic_store_explicit(&sSlpTxWin.oldestSeqNum, seqNum, memory_order_relaxed);
+    atomic_store_explicit(&sSlpTxWin.seqNumCount, seqNum, memory_order_release);
+}
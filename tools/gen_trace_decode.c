@@ -0,0 +1,130 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+//Decodes trace file written by gen_trace.c, records of all threads are merged in time order.
+//usage: gen_trace_decode [-c] [trace file]
+//  -c  Chrome trace JSON (chrome://tracing, Perfetto) instead of text
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../common.h"
+#include "../gen_if.h"
+#include "../gen_trace_if.h"
+
+typedef struct DecodeRecord_t {
+    GenTraceRecord_t    record;
+    uint32_t            tid;
+} DecodeRecord_t;
+
+static int DecodeCompare(const void* pA, const void* pB)
+{
+    const DecodeRecord_t* pRa = pA;
+    const DecodeRecord_t* pRb = pB;
+
+    if (pRa->record.timeNs < pRb->record.timeNs) return -1;
+    if (pRa->record.timeNs > pRb->record.timeNs) return 1;
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* pFileName = GEN_TRACE_FILE_NAME;
+    const GenTraceFile_t* pFile;
+    const GenTraceRing_t* pRing;
+    DecodeRecord_t* pRecords;
+    struct stat st;
+    uint64_t writeIndex;
+    uint64_t first;
+    uint64_t startNs;
+    uint64_t index;
+    unsigned int nrOfRings;
+    unsigned int r;
+    int chrome = 0;
+    int nr = 0;
+    int fd;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-c")) {
+            chrome = 1;
+        } else {
+            pFileName = argv[i];
+        }
+    }
+
+    fd = open(pFileName, O_RDONLY);
+    if ((0 > fd) || (0 > fstat(fd, &st))) {
+        perror(pFileName);
+        exit(1);
+    }
+    if (sizeof(GenTraceFile_t) > (size_t) st.st_size) {
+        fprintf(stderr, "%s: too short trace file\n", pFileName);
+        exit(1);
+    }
+    pFile = mmap(NULL, sizeof(GenTraceFile_t), PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == pFile) {
+        perror("mmap");
+        exit(1);
+    }
+    if ((GEN_TRACE_MAGIC != pFile->magic) || (GEN_TRACE_VERSION != pFile->version) ||
+        (GEN_TRACE_RING_SIZE != pFile->ringSize) || (GEN_TRACE_MAX_NR_OF_RINGS != pFile->maxNrOfRings)) {
+        fprintf(stderr, "%s: incompatible trace file\n", pFileName);
+        exit(1);
+    }
+
+    nrOfRings = atomic_load(&((GenTraceFile_t*) pFile)->nrOfRings);
+    if (GEN_TRACE_MAX_NR_OF_RINGS < nrOfRings) nrOfRings = GEN_TRACE_MAX_NR_OF_RINGS;
+    pRecords = malloc((size_t) nrOfRings * GEN_TRACE_RING_SIZE * sizeof(DecodeRecord_t) + 1);
+    assert(NULL != pRecords);
+
+    //only the newest GEN_TRACE_RING_SIZE records of each thread are left
+    for (r = 0; r < nrOfRings; r++) {
+        pRing = &pFile->rings[r];
+        writeIndex = atomic_load(&((GenTraceRing_t*) pRing)->writeIndex);
+        first = (GEN_TRACE_RING_SIZE < writeIndex) ? (writeIndex - GEN_TRACE_RING_SIZE) : 0;
+        for (index = first; index < writeIndex; index++) {
+            pRecords[nr].record = pRing->records[index & (GEN_TRACE_RING_SIZE - 1)];
+            pRecords[nr].tid = pRing->tid;
+            nr++;
+        }
+    }
+    qsort(pRecords, nr, sizeof(DecodeRecord_t), DecodeCompare);
+    startNs = (0 < nr) ? pRecords[0].record.timeNs : 0;
+
+    if (chrome) {
+        printf("{\"traceEvents\":[\n");
+    }
+    for (i = 0; i < nr; i++) {
+        const GenTraceRecord_t* pRecord = &pRecords[i].record;
+
+        if (chrome) {
+            printf("%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                "\"args\":{\"seqNum\":%lu,\"%s\":%u,\"%s\":%lu}}\n",
+                (0 < i) ? "," : "", GenTraceEventName(pRecord->eventId), pRecords[i].tid,
+                (pRecord->timeNs - startNs) / 1000.0, pRecord->seqNum,
+                GenTraceArgName(pRecord->eventId, 1), pRecord->arg1, GenTraceArgName(pRecord->eventId, 2), pRecord->arg2);
+        } else {
+            printf("%12.6f tid %u %s: seqNum %lu, %s %u, %s %lu\n",
+                (pRecord->timeNs - startNs) / 1e9, pRecords[i].tid, GenTraceEventName(pRecord->eventId),
+                pRecord->seqNum, GenTraceArgName(pRecord->eventId, 1), pRecord->arg1,
+                GenTraceArgName(pRecord->eventId, 2), pRecord->arg2);
+        }
+    }
+    if (chrome) {
+        printf("],\"displayTimeUnit\":\"ms\"}\n");
+    }
+    free(pRecords);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+//In-flight tracking benchmark: N messages are kept outstanding while each step saves a new one,
+//looks up a random outstanding one and removes the oldest one as in-order delivery does.
+//inflightTable of util.c is compared to sorted arrays with binarySearch and shifting removal like app.c had before.
+//Sorted arrays get at most BENCH_MAX_SORTED_OPS steps, each of them moves the whole array.
+//usage: inflight_bench [nr of outstanding messages] [nr of steps]
+
+#include <time.h>
+#include "../common.h"
+#include "../util_if.h"
+
+#define BENCH_MAX_SORTED_OPS    1000
+
+typedef struct BenchElem_t {
+    void*       pAppDataPtr;
+    uint32_t    appLen;
+} BenchElem_t;
+
+typedef struct BenchSorted_t {
+    uint64_t*       pIds;
+    BenchElem_t*    pElems;
+    int             nr;
+} BenchSorted_t;
+
+static double BenchNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void BenchSortedRemove(BenchSorted_t* pSorted, int pos)
+{
+    memmove(&pSorted->pIds[pos], &pSorted->pIds[pos + 1], (pSorted->nr - pos - 1) * sizeof(pSorted->pIds[0]));
+    memmove(&pSorted->pElems[pos], &pSorted->pElems[pos + 1], (pSorted->nr - pos - 1) * sizeof(pSorted->pElems[0]));
+    pSorted->nr--;
+}
+
+static double BenchSortedRun(uint32_t nrOfOutstanding, uint64_t nrOfOps, uint64_t* pChecksum)
+{
+    BenchSorted_t sorted;
+    unsigned int seed = 1;
+    uint64_t id;
+    double start;
+    int pos;
+
+    sorted.pIds = malloc((nrOfOutstanding + 1) * sizeof(sorted.pIds[0]));
+    sorted.pElems = malloc((nrOfOutstanding + 1) * sizeof(sorted.pElems[0]));
+    assert((NULL != sorted.pIds) && (NULL != sorted.pElems));
+    for (sorted.nr = 0; sorted.nr < (int) nrOfOutstanding; sorted.nr++) {
+        sorted.pIds[sorted.nr] = sorted.nr;
+        sorted.pElems[sorted.nr].appLen = sorted.nr;
+    }
+
+    start = BenchNow();
+    for (id = nrOfOutstanding; id < nrOfOutstanding + nrOfOps; id++) {
+        sorted.pIds[sorted.nr] = id;
+        sorted.pElems[sorted.nr].appLen = (uint32_t) id;
+        sorted.nr++;
+        pos = binarySearch(sorted.pIds, 0, sorted.nr - 1, id - (rand_r(&seed) % nrOfOutstanding));
+        assert(0 <= pos);
+        *pChecksum += sorted.pElems[pos].appLen;
+        pos = binarySearch(sorted.pIds, 0, sorted.nr - 1, id - nrOfOutstanding);
+        assert(0 <= pos);
+        BenchSortedRemove(&sorted, pos);
+    }
+    start = BenchNow() - start;
+    free(sorted.pIds);
+    free(sorted.pElems);
+    return start;
+}
+
+static double BenchTableRun(uint32_t nrOfOutstanding, uint64_t nrOfOps, uint64_t* pChecksum)
+{
+    InflightTable_t table;
+    BenchElem_t* pElem;
+    BenchElem_t elem;
+    unsigned int seed = 1;
+    uint32_t size = 1;
+    uint64_t id;
+    double start;
+
+    //one step has nrOfOutstanding + 1 messages for a moment
+    while (size <= nrOfOutstanding) size <<= 1;
+    inflightTableInit(&table, size, sizeof(BenchElem_t));
+    for (id = 0; id < nrOfOutstanding; id++) {
+        pElem = inflightTableAdd(&table, id);
+        pElem->appLen = (uint32_t) id;
+    }
+
+    start = BenchNow();
+    for (id = nrOfOutstanding; id < nrOfOutstanding + nrOfOps; id++) {
+        pElem = inflightTableAdd(&table, id);
+        assert(NULL != pElem);
+        pElem->appLen = (uint32_t) id;
+        pElem = inflightTableFind(&table, id - (rand_r(&seed) % nrOfOutstanding));
+        assert(NULL != pElem);
+        *pChecksum += pElem->appLen;
+        if (!inflightTableRemove(&table, id - nrOfOutstanding, &elem)) {
+            assert(0);
+        }
+    }
+    start = BenchNow() - start;
+    assert(nrOfOutstanding == table.nr);
+    free(table.pCells);
+    return start;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t nrOfOutstanding = (1 < argc) ? strtoul(argv[1], NULL, 0) : 1000000;
+    uint64_t nrOfOps = (2 < argc) ? strtoull(argv[2], NULL, 0) : 10000000;
+    uint64_t sortedOps;
+    uint64_t checksum = 0;
+    double secs;
+
+    if ((0 == nrOfOutstanding) || (INT32_MAX / 2 < nrOfOutstanding) || (0 == nrOfOps)) {
+        fprintf(stderr, "usage: %s [nr of outstanding messages] [nr of steps]\n", argv[0]);
+        exit(1);
+    }
+    sortedOps = (BENCH_MAX_SORTED_OPS < nrOfOps) ? BENCH_MAX_SORTED_OPS : nrOfOps;
+
+    printf("variant,outstanding,steps,seconds,ns_per_step\n");
+    secs = BenchSortedRun(nrOfOutstanding, sortedOps, &checksum);
+    printf("sorted,%u,%lu,%.3f,%.0f\n", nrOfOutstanding, sortedOps, secs, secs * 1e9 / sortedOps);
+    secs = BenchTableRun(nrOfOutstanding, nrOfOps, &checksum);
+    printf("table,%u,%lu,%.3f,%.0f\n", nrOfOutstanding, nrOfOps, secs, secs * 1e9 / nrOfOps);
+
+    //keeps lookups from being optimized away
+    return (0 == checksum) ? 1 : 0;
+}
@@ -0,0 +1,556 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+//End-to-end SLP benchmark: runs SLP-tx and SLP-rx threads of the library over ideal emulated links
+//with optional data block loss, and replaces APP by a sender keeping a window of blocks
+//in flight and a receiver verifying content and order of every delivered block.
+//Built by make sim the same code runs in virtual time of gen_sim.c, see gen_sim_if.h.
+//usage: slp_bench [-s payload bytes] [-n nr of blocks] [-w window] [-l loss ppm] [-d link delay us]
+//                 [-r seed] [-b sysv|inproc] [-v batch] [-g] [-u urgent period ms] [-f csv|json]
+//-v sends batches by slp_sendv, inproc backend only
+//-g sends block index and rest of payload as two lent segments, window counts blocks until released
+//-u sends also an urgent block per period and reports its latencies, e.g. with a window over
+//   SLP_MAX_NR_OF_BLOCKS bulk blocks keep SLP-tx window full: -w 100000 -d 100000 -u 20
+
+#include <time.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include "../common.h"
+#include "../gen_if.h"
+#include "../gen_config_if.h"
+#include "../msg.h"
+#include "../slp_if.h"
+#include "../slp_lib_if.h"
+#include "../gen_stat_if.h"
+#include "../gen_link_if.h"
+
+#define BENCH_DEFAULT_NR_OF_BLOCKS  100000
+#define BENCH_DEFAULT_WINDOW        64
+#define BENCH_MIN_PAYLOAD_SIZE      sizeof(uint64_t) //block index is at the beginning of payload
+#define BENCH_URGENT_APP_TAG        (1ULL << 31) //appTags of urgent blocks are above bulk ones of the run
+
+typedef struct BenchSettings_t {
+    uint32_t    payloadSize;
+    uint64_t    nrOfBlocks;
+    uint32_t    window;
+    uint32_t    lossPpm;
+    uint32_t    delayUs;
+    uint64_t    seed; //0: link defaults
+    const char* pBackend; //sysv: APP <=> SLP by SysV queues, inproc: slp_lib_if.h
+    uint32_t    batch; //blocks per slp_sendv, 1: slp_send
+    int         segmented; //header and body segments released by SLP, inproc backend only
+    uint32_t    urgentPeriodMs; //0: no urgent blocks
+    int         json;
+} BenchSettings_t;
+
+static BenchSettings_t sBenchSettings = {
+    1024,
+    BENCH_DEFAULT_NR_OF_BLOCKS,
+    BENCH_DEFAULT_WINDOW,
+    0,
+    0,
+    0,
+    "sysv",
+    1,
+    0,
+    0,
+    0
+};
+
+#ifdef GEN_SIM
+#define BENCH_TIME_BASE             "virtual"
+#else
+#define BENCH_TIME_BASE             "wall"
+#endif
+
+//appTags of a run start from its start time, older ones are resent from SLP journal of a killed run
+static uint64_t sBenchAppTagBase;
+
+static atomic_uint_fast64_t sBenchNrOfSent;
+static atomic_uint_fast64_t sBenchNrOfDelivered;
+static atomic_uint_fast64_t sBenchNrOfReleased;
+static atomic_uint_fast64_t sBenchNrOfUrgentSent;
+static atomic_int sBenchDone;
+static atomic_int sBenchWaitState;
+
+//sender sleeps while window is full or SLP asks to wait
+static pthread_mutex_t sBenchLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sBenchCond = PTHREAD_COND_INITIALIZER;
+
+static void BenchUsage(const char* pName)
+{
+    fprintf(stderr, "usage: %s [-s payload bytes] [-n nr of blocks] [-w window] [-l loss ppm] [-d link delay us] [-r seed] [-b sysv|inproc] [-v batch] [-g] [-u urgent period ms] [-f csv|json]\n", pName);
+    exit(EXIT_FAILURE);
+}
+
+static uint64_t BenchCpuNs(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ull +
+        (uint64_t) (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ull;
+}
+
+static void BenchFill(uint8_t* pData, uint32_t len, uint64_t index)
+{
+    uint32_t i;
+
+    memcpy(pData, &index, sizeof(index));
+    for (i = sizeof(index); i < len; i++) {
+        pData[i] = (uint8_t) (i + index);
+    }
+}
+
+//queues left over by a previous run would mix old messages into this one
+static void BenchRemoveMsgQueues(void)
+{
+    key_t key;
+    int msqid;
+
+    for (key = SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID; key <= SLP_APP_URGENT_DATA_SEND_MSG_QUEUE_KEY_ID; key++) {
+        if ((msqid = msgget(key, MSG_FLAG)) >= 0) {
+            msgctl(msqid, IPC_RMID, NULL);
+        }
+    }
+}
+
+//lent segments of a block stay in its slot until SLP releases it
+typedef struct BenchSlot_t {
+    uint64_t    index;
+    uint8_t     body[SLP_APP_DATA_SIZE];
+    SlpSegment_t segs[2];
+} BenchSlot_t;
+
+static void BenchReleased(void* pArg, uint64_t slpId)
+{
+    (void) pArg;
+    (void) slpId;
+    pthread_mutex_lock(&sBenchLock);
+    atomic_fetch_add(&sBenchNrOfReleased, 1);
+    pthread_cond_signal(&sBenchCond);
+    pthread_mutex_unlock(&sBenchLock);
+}
+
+//in-process sender, window is checked once per batch
+static void BenchSendBatches(void)
+{
+    static uint8_t appData[SLP_LIB_MAX_SENDV_NR][SLP_APP_DATA_SIZE];
+    SlpIovec_t iov[SLP_LIB_MAX_SENDV_NR];
+    BenchSlot_t* pSlots = NULL;
+    BenchSlot_t* pSlot;
+    uint64_t index;
+    uint32_t nr;
+    uint32_t i;
+
+    if (sBenchSettings.segmented) {
+        pSlots = malloc(sBenchSettings.window * sizeof(*pSlots));
+        assert(NULL != pSlots);
+    }
+    for (index = 0; index < sBenchSettings.nrOfBlocks; index += nr) {
+        nr = sBenchSettings.batch;
+        if (sBenchSettings.nrOfBlocks - index < nr) nr = sBenchSettings.nrOfBlocks - index;
+
+        pthread_mutex_lock(&sBenchLock);
+        while ((atomic_load(&sBenchNrOfSent) - atomic_load(&sBenchNrOfDelivered) + nr > sBenchSettings.window) ||
+            ((NULL != pSlots) && (atomic_load(&sBenchNrOfSent) - atomic_load(&sBenchNrOfReleased) + nr > sBenchSettings.window)) ||
+            atomic_load(&sBenchWaitState)) {
+            pthread_cond_wait(&sBenchCond, &sBenchLock);
+        }
+        pthread_mutex_unlock(&sBenchLock);
+
+        memset(iov, 0, nr * sizeof(iov[0]));
+        for (i = 0; i < nr; i++) {
+            iov[i].appTag = sBenchAppTagBase + index + i;
+            if (NULL == pSlots) {
+                BenchFill(appData[i], sBenchSettings.payloadSize, index + i);
+                iov[i].pAppData = appData[i];
+                iov[i].len = sBenchSettings.payloadSize;
+                continue;
+            }
+            //blocks are released in order, so slot of index + i is free again
+            pSlot = &pSlots[(index + i) % sBenchSettings.window];
+            BenchFill(pSlot->body, sBenchSettings.payloadSize, index + i);
+            pSlot->index = index + i;
+            pSlot->segs[0].pData = (const uint8_t*) &pSlot->index;
+            pSlot->segs[0].len = sizeof(pSlot->index);
+            pSlot->segs[1].pData = pSlot->body + sizeof(pSlot->index);
+            pSlot->segs[1].len = sBenchSettings.payloadSize - sizeof(pSlot->index);
+            iov[i].pSegs = pSlot->segs;
+            iov[i].nrOfSegs = (0 < pSlot->segs[1].len) ? 2 : 1;
+            iov[i].pRelease = BenchReleased;
+        }
+        atomic_fetch_add(&sBenchNrOfSent, nr);
+        if ((1 == nr) && (NULL == pSlots)) {
+            if (slp_send(iov[0].pAppData, iov[0].len, iov[0].appTag, NULL) < 0) {
+                fprintf(stderr, "slp_send failed\n");
+                exit(1);
+            }
+        } else if (slp_sendv(iov, nr, NULL) < 0) {
+            fprintf(stderr, "slp_sendv failed\n");
+            exit(1);
+        }
+    }
+}
+
+static void* bench_send_data()
+{
+    int msqid;
+    static SlpAppMsg_t sbuf;
+    uint64_t index;
+
+    if (0 == strcmp(sBenchSettings.pBackend, "inproc")) {
+        BenchSendBatches();
+        return NULL;
+    }
+
+    if ((msqid = msgget(SLP_APP_DATA_SEND_MSG_QUEUE_KEY_ID, IPC_CREAT | MSG_FLAG)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    sbuf.mtype = SLP_APP_DATA_SEND_MSG;
+    sbuf.data.len = sBenchSettings.payloadSize;
+
+    for (index = 0; index < sBenchSettings.nrOfBlocks; index++) {
+        pthread_mutex_lock(&sBenchLock);
+        while ((atomic_load(&sBenchNrOfSent) - atomic_load(&sBenchNrOfDelivered) >= sBenchSettings.window) ||
+            atomic_load(&sBenchWaitState)) {
+            pthread_cond_wait(&sBenchCond, &sBenchLock);
+        }
+        pthread_mutex_unlock(&sBenchLock);
+
+        sbuf.data.genId = sBenchAppTagBase + index;
+        BenchFill(sbuf.data.appData, sbuf.data.len, index);
+        atomic_fetch_add(&sBenchNrOfSent, 1);
+        sbuf.data.timeNs = GenStatNowNs();
+        if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
+            perror("msgsnd");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+//urgent blocks go by slp_send_urgent or urgent SysV queue, they don't count in window
+static void* bench_send_urgent_data()
+{
+    int inproc = (0 == strcmp(sBenchSettings.pBackend, "inproc"));
+    int msqid = -1;
+    static SlpAppMsg_t sbuf;
+    uint64_t index;
+
+    if (!inproc && (msqid = msgget(SLP_APP_URGENT_DATA_SEND_MSG_QUEUE_KEY_ID, IPC_CREAT | MSG_FLAG)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    sbuf.mtype = SLP_APP_URGENT_DATA_SEND_MSG;
+    sbuf.data.len = sBenchSettings.payloadSize;
+
+    for (index = 0; !atomic_load(&sBenchDone); index++) {
+        usleep(sBenchSettings.urgentPeriodMs * 1000);
+        sbuf.data.genId = sBenchAppTagBase + BENCH_URGENT_APP_TAG + index;
+        BenchFill(sbuf.data.appData, sbuf.data.len, index);
+        atomic_fetch_add(&sBenchNrOfUrgentSent, 1);
+        if (inproc) {
+            if (slp_send_urgent(sbuf.data.appData, sbuf.data.len, sbuf.data.genId, NULL) < 0) {
+                fprintf(stderr, "slp_send_urgent failed\n");
+                exit(1);
+            }
+            continue;
+        }
+        sbuf.data.timeNs = GenStatNowNs();
+        if (msgsnd(msqid, &sbuf, sizeof(sbuf.data), 0) < 0) {
+            perror("msgsnd");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+static void* bench_receive_info()
+{
+    int msqid;
+    SlpInfoMsg_t rbuf;
+
+    if ((msqid = msgget(SLP_APP_INFO_MSG_QUEUE_KEY_ID, IPC_CREAT | MSG_FLAG)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    //DONE infos are only drained, delivery completes a block
+    for (;;) {
+        if (0 > msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_INFO_MSG, 0)) {
+            perror("msgrcv");
+            exit(1);
+        }
+    }
+    return NULL;
+}
+
+static void BenchStateReceived(void* pUser, uint8_t state)
+{
+    (void) pUser;
+    pthread_mutex_lock(&sBenchLock);
+    atomic_store(&sBenchWaitState, state);
+    pthread_cond_signal(&sBenchCond);
+    pthread_mutex_unlock(&sBenchLock);
+}
+
+static void* bench_receive_state()
+{
+    int msqid;
+    SlpStateMsg_t rbuf;
+
+    if ((msqid = msgget(SLP_APP_STATE_MSG_QUEUE_KEY_ID, IPC_CREAT | MSG_FLAG)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    for (;;) {
+        if (0 > msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_STATE_MSG, 0)) {
+            perror("msgrcv");
+            exit(1);
+        }
+        BenchStateReceived(NULL, rbuf.data.state);
+    }
+    return NULL;
+}
+
+static void* bench_receive_data()
+{
+    int msqid = -1;
+    static SlpAppMsg_t rbuf;
+    static uint8_t expected[SLP_APP_DATA_SIZE];
+    uint64_t index;
+    uint64_t urgentIndex = 0;
+    uint64_t nrOfRecovered = 0;
+    uint64_t nowNs;
+    int inproc = (0 == strcmp(sBenchSettings.pBackend, "inproc"));
+    int len;
+
+    if (!inproc && (msqid = msgget(SLP_APP_DATA_RECEIVE_MSG_QUEUE_KEY_ID, IPC_CREAT | MSG_FLAG)) < 0) {
+        perror("msgget");
+        exit(1);
+    }
+    for (index = 0; index < sBenchSettings.nrOfBlocks;) {
+        if (inproc) {
+            len = slp_recv(rbuf.data.appData, sizeof(rbuf.data.appData), &rbuf.data.genId, &rbuf.data.appTag, &rbuf.data.timeNs);
+            if (0 > len) {
+                fprintf(stderr, "slp_recv failed\n");
+                exit(1);
+            }
+            rbuf.data.len = len;
+        } else if (0 > msgrcv(msqid, &rbuf, sizeof(rbuf.data), SLP_APP_DATA_RECEIVE_MSG, 0)) {
+            perror("msgrcv");
+            exit(1);
+        }
+
+        //blocks of a killed run come first, their content is of its settings
+        if (rbuf.data.appTag < sBenchAppTagBase) {
+            nrOfRecovered++;
+            continue;
+        }
+        if (0 < nrOfRecovered) {
+            fprintf(stderr, "bench_receive_data: %lu data blocks of previous run delivered from SLP journal\n", nrOfRecovered);
+            nrOfRecovered = 0;
+        }
+
+        //urgent blocks are in order among themselves, SLP records their latencies
+        if (rbuf.data.appTag >= sBenchAppTagBase + BENCH_URGENT_APP_TAG) {
+            BenchFill(expected, sBenchSettings.payloadSize, urgentIndex);
+            assert(sBenchSettings.payloadSize == rbuf.data.len);
+            assert(sBenchAppTagBase + BENCH_URGENT_APP_TAG + urgentIndex == rbuf.data.appTag);
+            assert(0 == memcmp(expected, rbuf.data.appData, rbuf.data.len));
+            urgentIndex++;
+            continue;
+        }
+
+        nowNs = GenStatNowNs();
+        GenStatLatency(GEN_STAT_LATENCY_ACCEPT_TO_DELIVERY, rbuf.data.timeNs, nowNs);
+        GenStatLatency(GEN_STAT_LATENCY_SUBMIT_TO_DELIVERY, GenStatGetStamp(rbuf.data.genId, GEN_STAT_STAMP_SUBMIT), nowNs);
+
+        //failed assert if content differs or order is broken
+        BenchFill(expected, sBenchSettings.payloadSize, index);
+        assert(sBenchSettings.payloadSize == rbuf.data.len);
+        assert(sBenchAppTagBase + index == rbuf.data.appTag);
+        assert(0 == memcmp(expected, rbuf.data.appData, rbuf.data.len));
+        GEN_STAT_INC(GEN_STAT_APP_DELIVERED_DATA_BLOCKS);
+        pthread_mutex_lock(&sBenchLock);
+        atomic_fetch_add(&sBenchNrOfDelivered, 1);
+        pthread_cond_signal(&sBenchCond);
+        pthread_mutex_unlock(&sBenchLock);
+        index++;
+    }
+    return NULL;
+}
+
+static void BenchCreateThread(void* (*pFunc)(), pthread_t* pThread)
+{
+    int retVal = pthread_create(pThread, NULL, pFunc, NULL);
+
+    if (retVal) {
+        fprintf(stderr, "Error - pthread_create() returned value: %d\n", retVal);
+        exit(EXIT_FAILURE);
+    }
+}
+
+//urgent columns follow the others when urgent blocks are sent: their submit to send and to SLP-rx accept
+//latencies and for comparison submit to send latency of bulk blocks
+static void BenchReportUrgent(const GenStatSnapshot_t* pSnapshot)
+{
+    const GenStatLatency_t* b = &pSnapshot->latencies[GEN_STAT_LATENCY_SUBMIT_TO_SEND];
+    const GenStatLatency_t* u = &pSnapshot->latencies[GEN_STAT_LATENCY_URGENT_SUBMIT_TO_SEND];
+    const GenStatLatency_t* a = &pSnapshot->latencies[GEN_STAT_LATENCY_URGENT_SUBMIT_TO_ACCEPT];
+
+    if (sBenchSettings.json) {
+        printf(", \"urgent_period_ms\": %u, \"urgent_blocks\": %lu, \"submit_to_send_p99_ns\": %lu, \"submit_to_send_max_ns\": %lu, "
+            "\"urgent_submit_to_send_p50_ns\": %lu, \"urgent_submit_to_send_p99_ns\": %lu, \"urgent_submit_to_send_max_ns\": %lu, "
+            "\"urgent_submit_to_accept_p50_ns\": %lu, \"urgent_submit_to_accept_p99_ns\": %lu, \"urgent_submit_to_accept_max_ns\": %lu",
+            sBenchSettings.urgentPeriodMs, (uint64_t) atomic_load(&sBenchNrOfUrgentSent), b->p99Ns, b->maxNs,
+            u->p50Ns, u->p99Ns, u->maxNs, a->p50Ns, a->p99Ns, a->maxNs);
+    } else {
+        printf(",%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+            sBenchSettings.urgentPeriodMs, (uint64_t) atomic_load(&sBenchNrOfUrgentSent), b->p99Ns, b->maxNs,
+            u->p50Ns, u->p99Ns, u->maxNs, a->p50Ns, a->p99Ns, a->maxNs);
+    }
+}
+
+static void BenchReport(uint64_t wallNs, uint64_t cpuNs, const GenStatSnapshot_t* pSnapshot)
+{
+    const BenchSettings_t* s = &sBenchSettings;
+    const GenStatLatency_t* l = &pSnapshot->latencies[GEN_STAT_LATENCY_SUBMIT_TO_DELIVERY];
+    double seconds = wallNs / 1e9;
+    double blocksPerS = s->nrOfBlocks / seconds;
+    double mbPerS = s->nrOfBlocks * (double) s->payloadSize / seconds / 1e6;
+    double cpuNsPerBlock = (double) cpuNs / s->nrOfBlocks;
+
+    if (s->json) {
+        printf("{\"backend\": \"%s\", \"time_base\": \"%s\", \"payload_bytes\": %u, \"blocks\": %lu, \"window\": %u, \"batch\": %u, \"loss_ppm\": %u, \"delay_us\": %u, \"seed\": %lu, "
+            "\"seconds\": %.3f, \"blocks_per_s\": %.0f, \"mb_per_s\": %.2f, \"cpu_ns_per_block\": %.0f, "
+            "\"retransmitted_blocks\": %lu, \"latency_p50_ns\": %lu, \"latency_p99_ns\": %lu, "
+            "\"latency_p999_ns\": %lu, \"latency_max_ns\": %lu",
+            s->pBackend, BENCH_TIME_BASE, s->payloadSize, s->nrOfBlocks, s->window, s->batch, s->lossPpm, s->delayUs, s->seed,
+            seconds, blocksPerS, mbPerS, cpuNsPerBlock,
+            pSnapshot->counters[GEN_STAT_SLP_TX_RETRANSMITTED_DATA_BLOCKS],
+            l->p50Ns, l->p99Ns, l->p999Ns, l->maxNs);
+        if (0 < s->urgentPeriodMs) {
+            BenchReportUrgent(pSnapshot);
+        }
+        printf("}\n");
+    } else {
+        printf("backend,time_base,payload_bytes,blocks,window,batch,loss_ppm,delay_us,seed,seconds,blocks_per_s,mb_per_s,cpu_ns_per_block,"
+            "retransmitted_blocks,latency_p50_ns,latency_p99_ns,latency_p999_ns,latency_max_ns");
+        if (0 < s->urgentPeriodMs) {
+            printf(",urgent_period_ms,urgent_blocks,submit_to_send_p99_ns,submit_to_send_max_ns,"
+                "urgent_submit_to_send_p50_ns,urgent_submit_to_send_p99_ns,urgent_submit_to_send_max_ns,"
+                "urgent_submit_to_accept_p50_ns,urgent_submit_to_accept_p99_ns,urgent_submit_to_accept_max_ns");
+        }
+        printf("\n%s,%s,%u,%lu,%u,%u,%u,%u,%lu,%.3f,%.0f,%.2f,%.0f,%lu,%lu,%lu,%lu,%lu",
+            s->pBackend, BENCH_TIME_BASE, s->payloadSize, s->nrOfBlocks, s->window, s->batch, s->lossPpm, s->delayUs, s->seed,
+            seconds, blocksPerS, mbPerS, cpuNsPerBlock,
+            pSnapshot->counters[GEN_STAT_SLP_TX_RETRANSMITTED_DATA_BLOCKS],
+            l->p50Ns, l->p99Ns, l->p999Ns, l->maxNs);
+        if (0 < s->urgentPeriodMs) {
+            BenchReportUrgent(pSnapshot);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    pthread_t threads[5];
+    GenStatSnapshot_t snapshot;
+    uint64_t startNs;
+    uint64_t startCpuNs;
+    int opt;
+    int i;
+
+    //config file and environment only, benchmark flags and link settings below win
+    GenConfigLoad(1, argv);
+    while ((opt = getopt(argc, argv, "s:n:w:l:d:r:b:v:gu:f:")) != -1) {
+        switch (opt) {
+        case 's': sBenchSettings.payloadSize = strtoul(optarg, NULL, 0); break;
+        case 'n': sBenchSettings.nrOfBlocks = strtoull(optarg, NULL, 0); break;
+        case 'w': sBenchSettings.window = strtoul(optarg, NULL, 0); break;
+        case 'l': sBenchSettings.lossPpm = strtoul(optarg, NULL, 0); break;
+        case 'd': sBenchSettings.delayUs = strtoul(optarg, NULL, 0); break;
+        case 'r': sBenchSettings.seed = strtoull(optarg, NULL, 0); break;
+        case 'b': sBenchSettings.pBackend = optarg; break;
+        case 'v': sBenchSettings.batch = strtoul(optarg, NULL, 0); break;
+        case 'g': sBenchSettings.segmented = 1; break;
+        case 'u': sBenchSettings.urgentPeriodMs = strtoul(optarg, NULL, 0); break;
+        case 'f': sBenchSettings.json = (0 == strcmp(optarg, "json")); break;
+        default: BenchUsage(argv[0]);
+        }
+    }
+    if ((BENCH_MIN_PAYLOAD_SIZE > sBenchSettings.payloadSize) || (SLP_APP_DATA_SIZE < sBenchSettings.payloadSize) ||
+        (0 == sBenchSettings.nrOfBlocks) || (BENCH_URGENT_APP_TAG <= sBenchSettings.nrOfBlocks) ||
+        (0 == sBenchSettings.window) || (1000000 < sBenchSettings.lossPpm) ||
+        (0 == sBenchSettings.batch) || (SLP_LIB_MAX_SENDV_NR < sBenchSettings.batch) || (sBenchSettings.window < sBenchSettings.batch)) {
+        BenchUsage(argv[0]);
+    }
+    if ((0 != strcmp(sBenchSettings.pBackend, "sysv")) && (0 != strcmp(sBenchSettings.pBackend, "inproc"))) {
+        fprintf(stderr, "unsupported backend %s\n", sBenchSettings.pBackend);
+        exit(EXIT_FAILURE);
+    }
+    if (((1 < sBenchSettings.batch) || sBenchSettings.segmented) && (0 != strcmp(sBenchSettings.pBackend, "inproc"))) {
+        fprintf(stderr, "batches and segments need inproc backend\n");
+        exit(EXIT_FAILURE);
+    }
+
+    //ideal links except fixed delay and random loss of data blocks
+    for (i = 0; i < GEN_LINK_NR_OF_LINKS; i++) {
+        uint64_t seed = sBenchSettings.seed ? (sBenchSettings.seed + i) : gGenLinkSettings[i].seed;
+
+        memset(&gGenLinkSettings[i], 0, sizeof(gGenLinkSettings[i]));
+        gGenLinkSettings[i].delayUs = sBenchSettings.delayUs;
+        gGenLinkSettings[i].seed = seed;
+    }
+    gGenLinkSettings[GEN_LINK_DATA].lossPpm = sBenchSettings.lossPpm;
+    gGenTestSettings.randomBreaks = 0;
+    gGenStatSettings.exportIntervalMs = 0;
+
+    BenchRemoveMsgQueues();
+    sBenchAppTagBase = (uint64_t) time(NULL) << 32;
+    if (0 == strcmp(sBenchSettings.pBackend, "inproc")) {
+        static const SlpCallbacks_t callbacks = {.pState = BenchStateReceived};
+
+        if (slp_open(&callbacks) < 0) {
+            fprintf(stderr, "slp_open failed\n");
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        GenInit();
+        GenStartSlpThreads(1);
+        BenchCreateThread(bench_receive_info, &threads[0]);
+        BenchCreateThread(bench_receive_state, &threads[1]);
+    }
+    BenchCreateThread(bench_receive_data, &threads[2]);
+
+    //reset latency histograms so that only this run is reported
+    GenStatGetSnapshot(&snapshot, 1);
+    startNs = GenStatNowNs();
+    startCpuNs = BenchCpuNs();
+    BenchCreateThread(bench_send_data, &threads[3]);
+    if (0 < sBenchSettings.urgentPeriodMs) {
+        BenchCreateThread(bench_send_urgent_data, &threads[4]);
+    }
+
+    pthread_join(threads[3], NULL);
+    pthread_join(threads[2], NULL);
+    atomic_store(&sBenchDone, 1);
+
+    GenStatGetSnapshot(&snapshot, 1);
+    BenchReport(GenStatNowNs() - startNs, BenchCpuNs() - startCpuNs, &snapshot);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,231 @@
+/*
+Simple and Light Protocol - SLP
+
+This implementation is based on POSIX threads:
+https://stackoverflow.com/questions/40177613/c-linux-pthreads-sending-data-from-one-thread-to-another- ...
+http://www.yolinux.com/TUTORIALS/LinuxTutorialPosixThreads.html
+
+Other sources:
+https://www.geeksforgeeks.org/search-insert-and-delete-in-a-sorted-array/
+https://barrgroup.com/Embedded-Systems/How-To/CRC-Calculation-C-Code
+
+This can easily be ported to other Operating System environments, also into embedded SW having some OS.
+*/
+
+//SLP-tx window contention benchmark: producers save blocks while one thread releases them by
+//cumulative acks and one thread copies them for retransmission as nacks would do.
+//The window of slp_txwin.c is compared to a single mutex guarding sorted arrays like SLP-tx had before.
+//usage: slp_tx_bench [nr of producers] [nr of blocks per producer]
+
+#include <time.h>
+#include "../common.h"
+#include "../gen_if.h"
+#include "../msg.h"
+#include "../slp_if.h"
+#include "../slp.h"
+
+#define BENCH_BLOCK_SIZE        256
+#define BENCH_ACK_EVERY         16
+#define BENCH_MAX_NR_OF_PRODUCERS 16
+
+typedef struct BenchMutexState_t {
+    uint64_t    seqNums[SLP_MAX_NR_OF_BLOCKS];
+    void*       pAppDataPtrs[SLP_MAX_NR_OF_BLOCKS];
+    int         nrOfDataBlocks;
+    uint64_t    seqNumCount;
+} BenchMutexState_t;
+
+static BenchMutexState_t sBenchMutexState;
+static pthread_mutex_t sBenchLock = PTHREAD_MUTEX_INITIALIZER;
+static int sBenchUseWin;
+static int sBenchNrOfBlocks;
+static atomic_int sBenchProducersDone;
+static atomic_uint_fast64_t sBenchNrOfCopies;
+
+static int BenchBinarySearch(uint64_t key)
+{
+    int low = 0;
+    int high = sBenchMutexState.nrOfDataBlocks - 1;
+
+    while (low <= high) {
+        int mid = low + (high - low) / 2;
+        if (sBenchMutexState.seqNums[mid] == key) return mid;
+        if (sBenchMutexState.seqNums[mid] < key) low = mid + 1;
+        else high = mid - 1;
+    }
+    return -1;
+}
+
+static void* bench_producer(void* pArg)
+{
+    uint8_t data[BENCH_BLOCK_SIZE];
+    int i;
+
+    (void) pArg;
+    memset(data, 0x5a, sizeof(data));
+    for (i = 0; i < sBenchNrOfBlocks; i++) {
+        void* pAppData = malloc(sizeof(data));
+
+        assert(NULL != pAppData);
+        memcpy(pAppData, data, sizeof(data));
+        if (sBenchUseWin) {
+            SlpTxWinPublish(SlpTxWinReserve(), pAppData, sizeof(data), 0, 0);
+            continue;
+        }
+        for (;;) {
+            pthread_mutex_lock(&sBenchLock);
+            if (SLP_MAX_NR_OF_BLOCKS > sBenchMutexState.nrOfDataBlocks) break;
+            pthread_mutex_unlock(&sBenchLock);
+            usleep(GEN_SMALL_THREAD_DELAY_US);
+        }
+        sBenchMutexState.seqNums[sBenchMutexState.nrOfDataBlocks] = sBenchMutexState.seqNumCount++;
+        sBenchMutexState.pAppDataPtrs[sBenchMutexState.nrOfDataBlocks] = pAppData;
+        sBenchMutexState.nrOfDataBlocks++;
+        pthread_mutex_unlock(&sBenchLock);
+    }
+    atomic_fetch_add(&sBenchProducersDone, 1);
+    return NULL;
+}
+
+static void* bench_ack(void* pArg)
+{
+    SlpTxReleased_t released[64];
+    int nrOfProducers = *(int*) pArg;
+    uint64_t total = (uint64_t) nrOfProducers * sBenchNrOfBlocks;
+    uint64_t acked = 0;
+    int nr;
+    int pos;
+    int i;
+
+    while (acked < total) {
+        uint64_t seqNum = acked + BENCH_ACK_EVERY - 1;
+
+        if (seqNum >= total) seqNum = total - 1;
+        if (sBenchUseWin) {
+            nr = SlpTxWinRelease(seqNum, released, 64);
+            if (0 >= nr) continue;
+            for (i = 0; i < nr; i++) {
+                free(released[i].pAppDataPtr);
+            }
+            acked = released[nr - 1].seqNum + 1;
+            continue;
+        }
+
+        //old way: search, free and shift one by one during the lock is held
+        pthread_mutex_lock(&sBenchLock);
+        pos = BenchBinarySearch(seqNum);
+        if (0 > pos) {
+            pthread_mutex_unlock(&sBenchLock);
+            continue;
+        }
+        for (i = pos; i >= 0; i--) {
+            free(sBenchMutexState.pAppDataPtrs[i]);
+            memmove(&sBenchMutexState.seqNums[i], &sBenchMutexState.seqNums[i + 1],
+                (sBenchMutexState.nrOfDataBlocks - i - 1) * sizeof(uint64_t));
+            memmove(&sBenchMutexState.pAppDataPtrs[i], &sBenchMutexState.pAppDataPtrs[i + 1],
+                (sBenchMutexState.nrOfDataBlocks - i - 1) * sizeof(void*));
+            sBenchMutexState.nrOfDataBlocks--;
+        }
+        pthread_mutex_unlock(&sBenchLock);
+        acked = seqNum + 1;
+    }
+    return NULL;
+}
+
+static void* bench_nack(void* pArg)
+{
+    uint8_t data[SLP_APP_DATA_SIZE];
+    uint32_t appLen;
+    uint32_t flags;
+    uint64_t appTag;
+    int isPoll;
+    int nrOfProducers = *(int*) pArg;
+    unsigned int seed = 1;
+    uint64_t oldestSeqNum;
+    uint64_t seqNum;
+    int nr;
+    int pos;
+
+    while (nrOfProducers > atomic_load(&sBenchProducersDone)) {
+        if (sBenchUseWin) {
+            nr = SlpTxWinNrOfDataBlocks(&oldestSeqNum);
+            if (0 == nr) continue;
+            seqNum = oldestSeqNum + (rand_r(&seed) % nr);
+            if (SlpTxWinCopy(seqNum, data, &appLen, &flags, &appTag, &isPoll)) {
+                atomic_fetch_add_explicit(&sBenchNrOfCopies, 1, memory_order_relaxed);
+            }
+            continue;
+        }
+        pthread_mutex_lock(&sBenchLock);
+        nr = sBenchMutexState.nrOfDataBlocks;
+        if (0 < nr) {
+            seqNum = sBenchMutexState.seqNums[0] + (rand_r(&seed) % nr);
+            pos = BenchBinarySearch(seqNum);
+            if (0 <= pos) {
+                memcpy(data, sBenchMutexState.pAppDataPtrs[pos], BENCH_BLOCK_SIZE);
+                atomic_fetch_add_explicit(&sBenchNrOfCopies, 1, memory_order_relaxed);
+            }
+        }
+        pthread_mutex_unlock(&sBenchLock);
+    }
+    return NULL;
+}
+
+static double BenchRun(int useWin, int nrOfProducers)
+{
+    pthread_t producers[BENCH_MAX_NR_OF_PRODUCERS];
+    pthread_t ack;
+    pthread_t nack;
+    struct timespec start;
+    struct timespec end;
+    int i;
+
+    sBenchUseWin = useWin;
+    atomic_store(&sBenchProducersDone, 0);
+    atomic_store(&sBenchNrOfCopies, 0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < nrOfProducers; i++) {
+        if (pthread_create(&producers[i], NULL, bench_producer, NULL)) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    if (pthread_create(&ack, NULL, bench_ack, &nrOfProducers) || pthread_create(&nack, NULL, bench_nack, &nrOfProducers)) {
+        perror("pthread_create");
+        exit(1);
+    }
+    for (i = 0; i < nrOfProducers; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    pthread_join(ack, NULL);
+    pthread_join(nack, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+    int nrOfProducers = (1 < argc) ? atoi(argv[1]) : 4;
+    double secs;
+    uint64_t total;
+    int useWin;
+
+    sBenchNrOfBlocks = (2 < argc) ? atoi(argv[2]) : 200000;
+    if ((0 >= nrOfProducers) || (BENCH_MAX_NR_OF_PRODUCERS < nrOfProducers) || (0 >= sBenchNrOfBlocks)) {
+        fprintf(stderr, "usage: %s [nr of producers 1..%d] [nr of blocks per producer]\n", argv[0], BENCH_MAX_NR_OF_PRODUCERS);
+        exit(1);
+    }
+    if (pthread_mutex_init(&gSlpTxLock, NULL) != 0) {
+        printf("\n slp tx mutex init failed\n");
+        exit(1);
+    }
+
+    total = (uint64_t) nrOfProducers * sBenchNrOfBlocks;
+    printf("variant,producers,blocks,seconds,blocks_per_s,retransmission_copies\n");
+    for (useWin = 0; useWin <= 1; useWin++) {
+        secs = BenchRun(useWin, nrOfProducers);
+        printf("%s,%d,%lu,%.3f,%.0f,%lu\n", useWin ? "txwin" : "mutex", nrOfProducers, total, secs,
+            total / secs, (uint64_t) atomic_load(&sBenchNrOfCopies));
+    }
+    return 0;
+}
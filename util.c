@@ -17,6 +17,12 @@ This can be ported easily to other Operating System environments, also into embe
 #include "common.h"
 #include "util_if.h"
 
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
 int binarySearch(uint64_t arr[], int low, int high, uint64_t key)
 {
     if (high < low)
@@ -98,3 +104,506 @@ crc crcFast(uint8_t const message[], int nBytes)
     return (remainder);
 
 }   /* crcFast() */
+
+/*
+ * CRC32C (Castagnoli), used by SLP when the link selects SLP_INTEGRITY_ALG_CRC32C.
+ * SSE4.2 and ARMv8 have an instruction for this polynomial, the table is only a fallback.
+ */
+#define CRC32C_POLYNOMIAL 0x82F63B78 /* reflected 0x1EDC6F41 */
+
+static uint32_t crc32cTable[256];
+static uint32_t (*crc32cUpdate)(uint32_t remainder, uint8_t const message[], int nBytes);
+
+static uint32_t crc32cUpdateSw(uint32_t remainder, uint8_t const message[], int nBytes)
+{
+    for (int byte = 0; byte < nBytes; ++byte)
+    {
+        remainder = crc32cTable[(remainder ^ message[byte]) & 0xff] ^ (remainder >> 8);
+    }
+    return (remainder);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32cUpdateHw(uint32_t remainder, uint8_t const message[], int nBytes)
+{
+    uint64_t remainder64 = remainder;
+    uint64_t data;
+
+    while (nBytes >= (int) sizeof(data))
+    {
+        memcpy(&data, message, sizeof(data));
+        remainder64 = _mm_crc32_u64(remainder64, data);
+        message += sizeof(data);
+        nBytes -= sizeof(data);
+    }
+    remainder = (uint32_t) remainder64;
+    while (nBytes-- > 0)
+    {
+        remainder = _mm_crc32_u8(remainder, *message++);
+    }
+    return (remainder);
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+static uint32_t crc32cUpdateHw(uint32_t remainder, uint8_t const message[], int nBytes)
+{
+    uint64_t data;
+
+    while (nBytes >= (int) sizeof(data))
+    {
+        memcpy(&data, message, sizeof(data));
+        remainder = __crc32cd(remainder, data);
+        message += sizeof(data);
+        nBytes -= sizeof(data);
+    }
+    while (nBytes-- > 0)
+    {
+        remainder = __crc32cb(remainder, *message++);
+    }
+    return (remainder);
+}
+#endif
+
+void crc32cInit(void)
+{
+    uint32_t remainder;
+
+    for (int dividend = 0; dividend < 256; ++dividend)
+    {
+        remainder = dividend;
+        for (uint8_t bit = 8; bit > 0; --bit)
+        {
+            if (remainder & 1)
+            {
+                remainder = (remainder >> 1) ^ CRC32C_POLYNOMIAL;
+            }
+            else
+            {
+                remainder = (remainder >> 1);
+            }
+        }
+        crc32cTable[dividend] = remainder;
+    }
+
+    /*
+     * Select hardware instruction when the CPU has it.
+     */
+    crc32cUpdate = crc32cUpdateSw;
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        crc32cUpdate = crc32cUpdateHw;
+    }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    crc32cUpdate = crc32cUpdateHw;
+#endif
+
+}   /* crc32cInit() */
+
+uint32_t crc32cFast(uint8_t const message[], int nBytes)
+{
+    return ~crc32cUpdate(~0U, message, nBytes);
+
+}   /* crc32cFast() */
+
+/*
+ * LZ4 block format compression for blocks smaller than 64 KB.
+ * Greedy single-probe matching: fast rather than best ratio.
+ */
+#define LZ4_HASH_LOG        12
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5   /* last bytes are always literals */
+#define LZ4_MF_LIMIT        12  /* last match must start before this distance from end */
+#define LZ4_MAX_OFFSET      65535
+
+static uint32_t lz4Read32(uint8_t const* p)
+{
+    uint32_t value;
+
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4Hash(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+static int lz4WriteLength(uint8_t dst[], int op, int len)
+{
+    while (len >= 255) {
+        dst[op++] = 255;
+        len -= 255;
+    }
+    dst[op++] = (uint8_t) len;
+    return op;
+}
+
+static int lz4WriteSequence(uint8_t dst[], int op, int dstCapacity,
+    uint8_t const literals[], int literalLen, int offset, int matchLen)
+{
+    int token;
+
+    /*
+     * Worst case: token, length bytes, literals, offset and match length bytes.
+     */
+    if ((op + 1 + literalLen/255 + 1 + literalLen + 2 + matchLen/255 + 1) > dstCapacity) {
+        return -1;
+    }
+
+    token = op++;
+    if (literalLen >= 15) {
+        dst[token] = 15 << 4;
+        op = lz4WriteLength(dst, op, literalLen - 15);
+    } else {
+        dst[token] = literalLen << 4;
+    }
+    memcpy(&dst[op], literals, literalLen);
+    op += literalLen;
+
+    /*
+     * Last sequence has literals only.
+     */
+    if (0 == matchLen) return op;
+
+    dst[op++] = offset & 0xff;
+    dst[op++] = offset >> 8;
+    matchLen -= LZ4_MIN_MATCH;
+    if (matchLen >= 15) {
+        dst[token] |= 15;
+        op = lz4WriteLength(dst, op, matchLen - 15);
+    } else {
+        dst[token] |= matchLen;
+    }
+    return op;
+}
+
+/*
+ * Returns compressed size, or 0 when the result doesn't fit into dstCapacity.
+ */
+int lz4Compress(uint8_t const src[], int srcLen, uint8_t dst[], int dstCapacity)
+{
+    uint16_t table[1 << LZ4_HASH_LOG];
+    int ip = 0;
+    int anchor = 0;
+    int op = 0;
+    int matchLimit = srcLen - LZ4_LAST_LITERALS;
+    int ipLimit = srcLen - LZ4_MF_LIMIT;
+
+    assert(LZ4_MAX_OFFSET >= srcLen);
+    memset(table, 0, sizeof(table));
+
+    while (ip < ipLimit) {
+        uint32_t sequence = lz4Read32(&src[ip]);
+        uint32_t h = lz4Hash(sequence);
+        int ref = table[h];
+
+        table[h] = ip;
+        if ((ref < ip) && (sequence == lz4Read32(&src[ref]))) {
+            int matchLen = LZ4_MIN_MATCH;
+
+            while (((ip + matchLen) < matchLimit) && (src[ref + matchLen] == src[ip + matchLen])) {
+                matchLen++;
+            }
+            op = lz4WriteSequence(dst, op, dstCapacity, &src[anchor], ip - anchor, ip - ref, matchLen);
+            if (0 > op) return 0;
+            ip += matchLen;
+            anchor = ip;
+        } else {
+            ip++;
+        }
+    }
+
+    op = lz4WriteSequence(dst, op, dstCapacity, &src[anchor], srcLen - anchor, 0, 0);
+    if (0 > op) return 0;
+    return op;
+}
+
+static int lz4ReadLength(uint8_t const src[], int* pIp, int srcLen, int len)
+{
+    uint8_t b;
+
+    do {
+        if (*pIp >= srcLen) return -1;
+        b = src[(*pIp)++];
+        len += b;
+    } while (255 == b);
+    return len;
+}
+
+/*
+ * Returns decompressed size, or -1 for malformed input. Never reads or writes out of bounds.
+ */
+int lz4Decompress(uint8_t const src[], int srcLen, uint8_t dst[], int dstCapacity)
+{
+    int ip = 0;
+    int op = 0;
+
+    while (ip < srcLen) {
+        int token = src[ip++];
+        int len = token >> 4;
+        int offset;
+
+        if (15 == len) {
+            len = lz4ReadLength(src, &ip, srcLen, len);
+            if (0 > len) return -1;
+        }
+        if (((ip + len) > srcLen) || ((op + len) > dstCapacity)) return -1;
+        memcpy(&dst[op], &src[ip], len);
+        ip += len;
+        op += len;
+
+        /*
+         * Last sequence has literals only.
+         */
+        if (ip == srcLen) break;
+
+        if ((ip + 2) > srcLen) return -1;
+        offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if ((0 == offset) || (offset > op)) return -1;
+
+        len = token & 15;
+        if (15 == len) {
+            len = lz4ReadLength(src, &ip, srcLen, len);
+            if (0 > len) return -1;
+        }
+        len += LZ4_MIN_MATCH;
+        if ((op + len) > dstCapacity) return -1;
+
+        /*
+         * Byte by byte because source and destination may overlap.
+         */
+        while (len-- > 0) {
+            dst[op] = dst[op - offset];
+            op++;
+        }
+    }
+    return op;
+}
+
+/*
+ * Bounded MPSC queue, based on Dmitry Vyukov's bounded MPMC queue:
+ * every cell has a sequence telling whether it is free for writeIndex or filled for readIndex.
+ */
+static MpscQueueCell_t* mpscQueueCell(MpscQueue_t* pQueue, uint64_t index)
+{
+    return (MpscQueueCell_t*) (pQueue->pCells + (index & (pQueue->size - 1)) * pQueue->cellSize);
+}
+
+void mpscQueueInit(MpscQueue_t* pQueue, uint32_t size, uint32_t elemSize)
+{
+    uint32_t i;
+
+    //size must be power of two
+    assert((0 < size) && (0 == (size & (size - 1))));
+
+    memset(pQueue, 0, sizeof(*pQueue));
+    pQueue->size = size;
+    pQueue->elemSize = elemSize;
+    pQueue->cellSize = (sizeof(MpscQueueCell_t) + elemSize + 7) & ~7U;
+    pQueue->pCells = malloc((size_t) size * pQueue->cellSize);
+    assert(NULL != pQueue->pCells);
+    for (i = 0; i < size; i++) {
+        atomic_init(&mpscQueueCell(pQueue, i)->seq, i);
+    }
+    atomic_init(&pQueue->writeIndex, 0);
+    atomic_init(&pQueue->nrOfWaiters, 0);
+    if ((pthread_mutex_init(&pQueue->waitLock, NULL) != 0) || (pthread_cond_init(&pQueue->waitCond, NULL) != 0)) {
+        printf("\n mpsc queue init failed\n");
+        exit(1);
+    }
+}
+
+/*
+ * Returns 0 when queue is full.
+ */
+int mpscQueuePush(MpscQueue_t* pQueue, const void* pElem)
+{
+    MpscQueueCell_t* pCell;
+    uint64_t index = atomic_load_explicit(&pQueue->writeIndex, memory_order_relaxed);
+    int64_t diff;
+
+    for (;;) {
+        pCell = mpscQueueCell(pQueue, index);
+        diff = (int64_t) (atomic_load_explicit(&pCell->seq, memory_order_acquire) - index);
+        if (0 == diff) {
+            //cell is free, reserve it
+            if (atomic_compare_exchange_weak_explicit(&pQueue->writeIndex, &index, index + 1,
+                memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (0 > diff) {
+            //consumer hasn't freed this cell yet
+            return 0;
+        } else {
+            index = atomic_load_explicit(&pQueue->writeIndex, memory_order_relaxed);
+        }
+    }
+
+    //fill and publish
+    memcpy(pCell + 1, pElem, pQueue->elemSize);
+    atomic_store_explicit(&pCell->seq, index + 1, memory_order_release);
+
+    //wake up consumer only when it is waiting
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pQueue->nrOfWaiters, memory_order_relaxed)) {
+        pthread_mutex_lock(&pQueue->waitLock);
+        pthread_cond_signal(&pQueue->waitCond);
+        pthread_mutex_unlock(&pQueue->waitLock);
+    }
+    return 1;
+}
+
+/*
+ * Only one thread may pop. Returns number of popped elements, 0 when queue is empty.
+ */
+int mpscQueuePopBatch(MpscQueue_t* pQueue, void* pElems, int maxNr)
+{
+    MpscQueueCell_t* pCell;
+    uint8_t* pElem = pElems;
+    int nr;
+
+    for (nr = 0; nr < maxNr; nr++) {
+        pCell = mpscQueueCell(pQueue, pQueue->readIndex);
+        if (atomic_load_explicit(&pCell->seq, memory_order_acquire) != (pQueue->readIndex + 1)) break;
+        memcpy(pElem, pCell + 1, pQueue->elemSize);
+        pElem += pQueue->elemSize;
+
+        //free cell for the round after next one
+        atomic_store_explicit(&pCell->seq, pQueue->readIndex + pQueue->size, memory_order_release);
+        pQueue->readIndex++;
+    }
+    return nr;
+}
+
+/*
+ * Like mpscQueuePopBatch but blocks until at least one element is available.
+ */
+int mpscQueueWaitBatch(MpscQueue_t* pQueue, void* pElems, int maxNr)
+{
+    MpscQueueCell_t* pCell;
+    int nr;
+
+    for (;;) {
+        nr = mpscQueuePopBatch(pQueue, pElems, maxNr);
+        if (0 < nr) return nr;
+
+        pthread_mutex_lock(&pQueue->waitLock);
+        atomic_fetch_add_explicit(&pQueue->nrOfWaiters, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        //producer either sees the waiter or its element is seen here
+        pCell = mpscQueueCell(pQueue, pQueue->readIndex);
+        if (atomic_load_explicit(&pCell->seq, memory_order_acquire) != (pQueue->readIndex + 1)) {
+            pthread_cond_wait(&pQueue->waitCond, &pQueue->waitLock);
+        }
+        atomic_fetch_sub_explicit(&pQueue->nrOfWaiters, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&pQueue->waitLock);
+    }
+}
+
+static InflightCell_t* inflightTableCell(InflightTable_t* pTable, uint64_t index)
+{
+    return (InflightCell_t*) (pTable->pCells + (index & (pTable->size - 1)) * pTable->cellSize);
+}
+
+void inflightTableInit(InflightTable_t* pTable, uint32_t size, uint32_t elemSize)
+{
+    //size must be power of two
+    assert((0 < size) && (0 == (size & (size - 1))));
+
+    memset(pTable, 0, sizeof(*pTable));
+    pTable->size = size;
+    pTable->elemSize = elemSize;
+    pTable->cellSize = (sizeof(InflightCell_t) + elemSize + 7) & ~7U;
+    pTable->pCells = calloc(size, pTable->cellSize);
+    assert(NULL != pTable->pCells);
+}
+
+/*
+ * Returns element of id to be filled by caller, NULL when table is full or id is already in.
+ */
+void* inflightTableAdd(InflightTable_t* pTable, uint64_t id)
+{
+    InflightCell_t* pCell;
+    uint64_t index;
+
+    if (pTable->size == pTable->nr) return NULL;
+    if (NULL != inflightTableFind(pTable, id)) return NULL;
+    for (index = id; ; index++) {
+        pCell = inflightTableCell(pTable, index);
+        if (!pCell->used) break;
+    }
+    if (pTable->maxProbe < index - id) {
+        pTable->maxProbe = (uint32_t) (index - id);
+    }
+    pCell->id = id;
+    pCell->used = 1;
+    pTable->nr++;
+    return (uint8_t*) pCell + sizeof(InflightCell_t);
+}
+
+static InflightCell_t* inflightTableLookup(InflightTable_t* pTable, uint64_t id, uint64_t* pIndex)
+{
+    InflightCell_t* pCell;
+    uint64_t index;
+
+    for (index = id; index <= id + pTable->maxProbe; index++) {
+        pCell = inflightTableCell(pTable, index);
+        if (!pCell->used) return NULL;
+        if (id == pCell->id) {
+            *pIndex = index;
+            return pCell;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns element of id, NULL if id isn't in table.
+ */
+void* inflightTableFind(InflightTable_t* pTable, uint64_t id)
+{
+    InflightCell_t* pCell;
+    uint64_t index;
+
+    pCell = inflightTableLookup(pTable, id, &index);
+    return (NULL == pCell) ? NULL : (uint8_t*) pCell + sizeof(InflightCell_t);
+}
+
+/*
+ * Copies element of id to pElem unless it is NULL, returns 0 if id isn't in table.
+ * Following cells of the probe chain are shifted back, so no tombstones are needed.
+ * Cells farther than maxProbe from the hole can't belong before it, so consecutive ids stop at once.
+ */
+int inflightTableRemove(InflightTable_t* pTable, uint64_t id, void* pElem)
+{
+    InflightCell_t* pCell;
+    InflightCell_t* pNext;
+    uint64_t index;
+    uint64_t next;
+    uint64_t mask = pTable->size - 1;
+
+    pCell = inflightTableLookup(pTable, id, &index);
+    if (NULL == pCell) return 0;
+    if (NULL != pElem) {
+        memcpy(pElem, (uint8_t*) pCell + sizeof(InflightCell_t), pTable->elemSize);
+    }
+
+    for (next = index + 1; next - index <= pTable->maxProbe; next++) {
+        pNext = inflightTableCell(pTable, next);
+        if (!pNext->used) break;
+
+        //cell can fill the hole if its home slot isn't cyclically between hole and itself
+        if (((next - pNext->id) & mask) >= ((next - index) & mask)) {
+            memcpy(pCell, pNext, pTable->cellSize);
+            pCell = pNext;
+            index = next;
+        }
+    }
+    pCell->used = 0;
+    pTable->nr--;
+    return 1;
+}
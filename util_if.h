@@ -21,3 +21,58 @@ typedef uint32_t crc;
 int binarySearch(uint64_t arr[], int low, int high, uint64_t key);
 void crcInit(void);
 crc crcFast(uint8_t const message[], int nBytes);
+void crc32cInit(void);
+uint32_t crc32cFast(uint8_t const message[], int nBytes);
+int lz4Compress(uint8_t const src[], int srcLen, uint8_t dst[], int dstCapacity);
+int lz4Decompress(uint8_t const src[], int srcLen, uint8_t dst[], int dstCapacity);
+
+/*
+ * Bounded lock-free queue for many producers and one consumer.
+ * Elements are copied in and out, the consumer can pop a batch at a time and block when empty.
+ */
+typedef struct MpscQueueCell_t {
+    atomic_uint_fast64_t    seq;
+} MpscQueueCell_t;
+
+typedef struct MpscQueue_t {
+    atomic_uint_fast64_t    writeIndex;
+    uint8_t                 pad1[64 - sizeof(atomic_uint_fast64_t)];
+    uint64_t                readIndex; //owned by the consumer
+    uint8_t                 pad2[64 - sizeof(uint64_t)];
+    uint32_t                size;
+    uint32_t                elemSize;
+    uint32_t                cellSize;
+    uint8_t*                pCells;
+    atomic_int              nrOfWaiters;
+    pthread_mutex_t         waitLock;
+    pthread_cond_t          waitCond;
+} MpscQueue_t;
+
+void mpscQueueInit(MpscQueue_t* pQueue, uint32_t size, uint32_t elemSize);
+int mpscQueuePush(MpscQueue_t* pQueue, const void* pElem);
+int mpscQueuePopBatch(MpscQueue_t* pQueue, void* pElems, int maxNr);
+int mpscQueueWaitBatch(MpscQueue_t* pQueue, void* pElems, int maxNr);
+
+/*
+ * In-flight table: elements of outstanding ids, e.g. appTags or slpIds, found and removed by id in O(1).
+ * Open addressing with linear probing from id modulo size, so consecutive ids never collide.
+ * Not thread safe, caller locks. Any removal order is allowed.
+ */
+typedef struct InflightCell_t {
+    uint64_t    id;
+    uint32_t    used;
+} InflightCell_t;
+
+typedef struct InflightTable_t {
+    uint32_t    size;
+    uint32_t    elemSize;
+    uint32_t    cellSize;
+    uint32_t    nr;
+    uint32_t    maxProbe; //longest distance of a cell from its home slot so far, 0 for consecutive ids
+    uint8_t*    pCells;
+} InflightTable_t;
+
+void inflightTableInit(InflightTable_t* pTable, uint32_t size, uint32_t elemSize);
+void* inflightTableAdd(InflightTable_t* pTable, uint64_t id);
+void* inflightTableFind(InflightTable_t* pTable, uint64_t id);
+int inflightTableRemove(InflightTable_t* pTable, uint64_t id, void* pElem);